@@ -0,0 +1,77 @@
+#include <gflags/gflags.h>
+
+#include <fstream>
+
+#include <core/classify_connection.h>
+#include <core/image_stream.h>
+#include <core/load_generator.h>
+
+DEFINE_string(socket, "/tmp/naive-bayes.sock",
+              "The file path of the classification server's socket.");
+DEFINE_string(test, "", "The file path to the dataset of images to send.");
+DEFINE_uint32(connections, 8, "The number of connections sending at once.");
+DEFINE_uint32(requests, 10000, "The total number of requests to send.");
+DEFINE_string(command, "",
+              "A control command to send instead of images: reload or stats.");
+
+using naivebayes::ClassifyConnection;
+using naivebayes::LoadGenerator;
+using naivebayes::ImageStream;
+using naivebayes::RequestType;
+using naivebayes::Image;
+
+/**
+ * Sends a single control command to the server and prints its reply.
+ * @return a 0 or 1, depending on whether the server replied
+ */
+int SendCommand() {
+  RequestType type;
+  if (FLAGS_command == "reload") {
+    type = RequestType::kReload;
+  } else if (FLAGS_command == "stats") {
+    type = RequestType::kStats;
+  } else {
+    std::cout << "Unknown command: " << FLAGS_command << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ClassifyConnection connection(ClassifyConnection::Connect(FLAGS_socket));
+  std::string reply;
+  if (!connection.WriteControlRequest(type) || !connection.ReadText(reply)) {
+    std::cout << "Could not reach the server." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << reply << std::endl;
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  if (!FLAGS_command.empty()) {
+    return SendCommand();
+  }
+
+  std::ifstream input_file(FLAGS_test);
+  std::vector<Image> images;
+
+  std::cout << "Loading images...";
+  if (input_file.is_open()) {
+    ImageStream image_stream(input_file);
+    Image image;
+    while (image_stream.ReadImage(image)) {
+      images.push_back(image);
+    }
+  }
+
+  if (images.empty()) {
+    std::cout << "failed." << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "done." << std::endl;
+
+  LoadGenerator load_generator(images, FLAGS_connections, FLAGS_requests);
+
+  return load_generator.Run(FLAGS_socket);
+}
@@ -0,0 +1,50 @@
+#include <gflags/gflags.h>
+
+#include <csignal>
+
+#include <core/classify_server.h>
+
+DEFINE_string(load, "", "The file path to load the model to serve from.");
+DEFINE_string(socket, "/tmp/naive-bayes.sock",
+              "The file path to create the Unix domain socket at.");
+DEFINE_uint32(max_batch, 64, "The most requests to score in a single batch.");
+DEFINE_uint32(batch_window_us, 200,
+              "How long to wait for more requests to join a batch, in "
+              "microseconds.");
+DEFINE_uint32(cache_size, 0, 
+              "The most images to cache the scores of, so exact duplicates "
+              "skip scoring. 0 disables the cache.");
+
+using naivebayes::ClassifyServer;
+
+// Signal handlers can't be given any state, so they reach the server here
+static ClassifyServer* running_server = nullptr;
+
+static void HandleStopSignal(int) {
+  if (running_server != nullptr) {
+    running_server->Stop();
+  }
+}
+
+static void HandleReloadSignal(int) {
+  if (running_server != nullptr) {
+    running_server->RequestReload();
+  }
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  ClassifyServer server(FLAGS_load, FLAGS_max_batch, FLAGS_batch_window_us,
+                        FLAGS_cache_size);
+  running_server = &server;
+
+  // A client hanging up mid-response should only end that connection
+  std::signal(SIGPIPE, SIG_IGN);
+  std::signal(SIGINT, HandleStopSignal);
+  std::signal(SIGTERM, HandleStopSignal);
+  // Retrained models are swapped in without restarting the server
+  std::signal(SIGHUP, HandleReloadSignal);
+
+  return server.Serve(FLAGS_socket);
+}
@@ -0,0 +1,28 @@
+#include <gflags/gflags.h>
+
+#include <core/executable_logic.h>
+
+// Every positional argument is the file path of a count checkpoint to merge
+DEFINE_string(save, "", "The file path to save the merged model to.");
+DEFINE_string(save_counts, "", 
+              "The file path to save the merged count checkpoint to.");
+DEFINE_uint32(smoothing, naivebayes::Model::kDefaultLaplaceSmoothingFactor,
+              "The Laplace smoothing factor to use in calculating likelihoods.");
+
+using naivebayes::ExecutableLogic;
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  // Prevent a user from setting the unsigned smoothing factor to 0
+  if (FLAGS_smoothing <= 0) {
+    FLAGS_smoothing = naivebayes::Model::kDefaultLaplaceSmoothingFactor;
+  }
+
+  // Flags have been removed from argv, so only checkpoint paths are left
+  std::vector<std::string> checkpoint_paths(argv + 1, argv + argc);
+
+  ExecutableLogic logic = ExecutableLogic(FLAGS_smoothing);
+
+  return logic.Merge(checkpoint_paths, FLAGS_save, FLAGS_save_counts);
+}
@@ -10,9 +10,106 @@ DEFINE_string(test, "", "The file path to the dataset to test the model on.");
 DEFINE_string(confusion, "", "The file path to save the confusion matrix to.");
 DEFINE_uint32(smoothing, naivebayes::Model::kDefaultLaplaceSmoothingFactor,
               "The Laplace smoothing factor to use in calculating likelihoods.");
-DEFINE_bool(verbose, false, "Whether to print the current index when testing.");
+DEFINE_bool(verbose, false, 
+            "Whether to print the progress of parsing, training and testing, "
+            "with the images per second and time left.");
+DEFINE_string(predictions, "", 
+              "The file path to save the top predictions of each test image "
+              "to, as csv with a label, log score and posterior per prediction.");
+DEFINE_uint32(top_k, 2, "The number of predictions to save for each image.");
+DEFINE_string(save_counts, "", 
+              "The file path to save a count checkpoint of the training "
+              "images to, which merge-models can combine with others.");
+DEFINE_uint32(shard_index, 0, "The shard of the training images to count.");
+DEFINE_uint32(shard_count, 1, 
+              "The number of shards to split the training images into. Image "
+              "i is counted when i % shard_count == shard_index.");
+DEFINE_bool(dedup, false, 
+            "Whether to collapse duplicate training images into one weighted "
+            "image each and report the dedup ratio.");
+DEFINE_string(weights, "", 
+              "The file path of a sidecar file with one weight for each "
+              "training image, in the order of the dataset.");
+DEFINE_bool(balance_classes, false, 
+            "Whether to reweight the training images so every class has the "
+            "same total weight.");
+DEFINE_uint32(kfold, 0, 
+              "The number of folds to cross validate the training images "
+              "with. Cross validation is skipped when this is 0.");
+DEFINE_string(kfold_confusion, "", 
+              "The file path to save the sum of the confusion matrices of all "
+              "cross validation folds to.");
+
+DEFINE_uint32(prune_top, 0, 
+              "The number of most discriminative pixels to prune the model "
+              "to before saving or testing it, 0 to keep every pixel.");
+DEFINE_double(prune_below, 0, 
+              "Prune pixels whose variance of log likelihoods across classes "
+              "is below this, 0 to keep every pixel.");
+DEFINE_bool(prune_report, false, 
+            "Whether to print the --test accuracy of the model pruned to a "
+            "range of fractions of its pixels.");
+DEFINE_string(cascade, "", 
+              "The file path of a dataset to calibrate a cascade classifier "
+              "with, which is then compared to the model on the --test "
+              "dataset.");
+DEFINE_double(cascade_tolerance, 0.01, 
+              "The most accuracy, between 0 and 1, the cascade may lose.");
+DEFINE_string(classify, "", 
+              "The file path of images to classify, or - to read them from "
+              "stdin. A label line is written to stdout for each image.");
+DEFINE_bool(scores, false, 
+            "Whether to follow each classified label with the score of every "
+            "label.");
+DEFINE_uint32(cache_size, 0, 
+              "The most images to cache the scores of while classifying, so "
+              "exact duplicates are only scored once. 0 disables the cache.");
+DEFINE_uint32(sample_size, 0, 
+              "The number of images to sample uniformly from each dataset "
+              "read, instead of reading every image.");
+DEFINE_string(sample_quotas, "", 
+              "The number of images to sample of each label of each dataset "
+              "read, like 0:100,1:50,*:10 or a single count for every label.");
+DEFINE_double(sample_fraction, 0, 
+              "The fraction of the images of each dataset read to sample.");
+DEFINE_uint64(sample_seed, 0, "The seed of the random sample.");
+DEFINE_bool(index_datasets, false, 
+            "Whether to parse whole text datasets on every core, using an "
+            "index of their images saved next to them. Sampled datasets and "
+            "datasets read through --dataset_cache are still parsed on one "
+            "thread.");
+DEFINE_string(dataset_cache, "", 
+              "The directory to keep a binary snapshot of each text dataset "
+              "read in, so later runs map the snapshot instead of parsing.");
+DEFINE_uint64(dataset_cache_mb, 0, 
+              "The most megabytes the dataset snapshots may take before the "
+              "least recently read are removed. 0 for no limit.");
+DEFINE_bool(read_ahead, false, 
+            "Whether to read datasets on a background thread ahead of parsing "
+            "them, and print the bandwidth they were read at.");
+DEFINE_uint32(threads, 0, 
+              "The number of threads to train, test, parse and classify "
+              "with. 0 uses one per core.");
+DEFINE_bool(pin_threads, false, 
+            "Whether to pin each thread to a core, spread over the NUMA "
+            "nodes, and print how many images each node tests per second.");
+DEFINE_bool(numa_replicas, false, 
+            "Whether to pin the threads and copy the model onto each NUMA "
+            "node before testing it.");
+DEFINE_bool(metrics, false, 
+            "Whether to count hardware events while training, testing and "
+            "classifying, and print the instructions per cycle and the cache "
+            "and branch misses per image.");
+DEFINE_string(trace_out, "", 
+              "The file to save a Chrome trace of the time each thread "
+              "spent parsing, training, classifying, saving and loading to.");
+DEFINE_string(convert, "", 
+              "The file path of a dataset to convert to the binary format.");
+DEFINE_string(convert_out, "", 
+              "The file path to save the converted dataset to.");
 
 using naivebayes::ExecutableLogic;
+using naivebayes::ExecutionFlags;
 
 int main(int argc, char** argv) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
@@ -21,9 +118,79 @@ int main(int argc, char** argv) {
   if (FLAGS_smoothing <= 0) {
     FLAGS_smoothing = naivebayes::Model::kDefaultLaplaceSmoothingFactor;
   }
+
+  // Every image must belong to exactly one shard
+  if (FLAGS_shard_count <= 0 || FLAGS_shard_index >= FLAGS_shard_count) {
+    std::cout << "The shard index must be less than the shard count!";
+    std::cout << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // A single fold would leave no images to train the fold model with
+  if (FLAGS_kfold == 1) {
+    std::cout << "Cross validation needs at least 2 folds!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  
+  // Each sampling flag chooses a different kind of sample
+  int sample_flag_count = (FLAGS_sample_size > 0 ? 1 : 0) +
+                          (FLAGS_sample_quotas.empty() ? 0 : 1) +
+                          (FLAGS_sample_fraction > 0 ? 1 : 0);
+  if (sample_flag_count > 1) {
+    std::cout << "Only one kind of sample can be drawn!" << std::endl;
+    return EXIT_FAILURE;
+  } else if (FLAGS_sample_fraction < 0 || FLAGS_sample_fraction > 1) {
+    std::cout << "The sample fraction must be from 0 to 1!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ExecutionFlags flags;
+  flags.train_ = FLAGS_train;
+  flags.load_ = FLAGS_load;
+  flags.save_ = FLAGS_save;
+  flags.test_ = FLAGS_test;
+  flags.confusion_ = FLAGS_confusion;
+  flags.is_printing_verbose_ = FLAGS_verbose;
+  flags.predictions_ = FLAGS_predictions;
+  flags.top_k_ = FLAGS_top_k;
+  flags.save_counts_ = FLAGS_save_counts;
+  flags.shard_index_ = FLAGS_shard_index;
+  flags.shard_count_ = FLAGS_shard_count;
+  flags.is_deduplicating_ = FLAGS_dedup;
+  flags.weights_ = FLAGS_weights;
+  flags.is_balancing_classes_ = FLAGS_balance_classes;
+  flags.fold_count_ = FLAGS_kfold;
+  flags.fold_confusion_ = FLAGS_kfold_confusion;
+  flags.prune_top_ = FLAGS_prune_top;
+  flags.prune_below_ = static_cast<float>(FLAGS_prune_below);
+  flags.is_printing_prune_report_ = FLAGS_prune_report;
+  flags.cascade_ = FLAGS_cascade;
+  flags.cascade_tolerance_ = static_cast<float>(FLAGS_cascade_tolerance);
+  flags.classify_ = FLAGS_classify;
+  flags.is_printing_scores_ = FLAGS_scores;
+  flags.cache_size_ = FLAGS_cache_size;
+  flags.sample_size_ = FLAGS_sample_size;
+  flags.sample_quotas_ = FLAGS_sample_quotas;
+  flags.sample_fraction_ = FLAGS_sample_fraction;
+  flags.sample_seed_ = FLAGS_sample_seed;
+  flags.is_indexing_datasets_ = FLAGS_index_datasets;
+  flags.dataset_cache_ = FLAGS_dataset_cache;
+  flags.dataset_cache_mb_ = FLAGS_dataset_cache_mb;
+  flags.is_reading_ahead_ = FLAGS_read_ahead;
+  flags.thread_count_ = FLAGS_threads;
+  flags.is_pinning_threads_ = FLAGS_pin_threads;
+  flags.is_replicating_model_ = FLAGS_numa_replicas;
+  flags.is_printing_metrics_ = FLAGS_metrics;
+  flags.trace_out_ = FLAGS_trace_out;
+  flags.convert_ = FLAGS_convert;
+  flags.convert_out_ = FLAGS_convert_out;
+
+  // Classifying a pipeline's worth of images can't afford stdio syncing
+  if (!FLAGS_classify.empty()) {
+    std::ios::sync_with_stdio(false);
+  }
   
   ExecutableLogic logic = ExecutableLogic(FLAGS_smoothing);
   
-  return logic.Execute(FLAGS_train, FLAGS_load, FLAGS_save, FLAGS_test, 
-                       FLAGS_confusion, FLAGS_verbose);
+  return logic.Execute(flags);
 }
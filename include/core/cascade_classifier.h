@@ -0,0 +1,110 @@
+#ifndef NAIVE_BAYES_CASCADE_CLASSIFIER_H
+#define NAIVE_BAYES_CASCADE_CLASSIFIER_H
+
+#include <vector>
+
+#include "core/model.h"
+
+namespace naivebayes {
+
+/**
+ * Classifies images in two stages. The first stage scores only the most
+ * discriminative pixels of a Model, and its prediction is kept when its top
+ * two labels are at least a margin apart. Only the remaining images escalate
+ * to the full Model. The pixels and margin are picked by Calibrate() so the
+ * cascade loses as little accuracy as the caller allows.
+ */
+class CascadeClassifier {
+  public:
+    // The fractions of the model's pixels calibration tries for stage one
+    static const std::vector<float> kCandidatePixelFractions;
+
+    /**
+     * Creates a cascade that escalates every image until it is calibrated.
+     * The model must outlive this object and must not be retrained while it
+     * is in use.
+     * @param model - a trained or loaded Model to use as the second stage
+     */
+    explicit CascadeClassifier(const Model& model);
+
+    /**
+     * Picks the stage one pixels and margin threshold that escalate the
+     * fewest images while keeping the accuracy of the cascade on the given
+     * images within the tolerance of the full model's accuracy. Fewer pixels
+     * are preferred when they cost less overall, counting each escalation as
+     * scoring every pixel again. If no cascade costs less than the full model
+     * alone, stage one is skipped and every image escalates.
+     * @param dataset - a Dataset of labeled images to calibrate with
+     * @param tolerance - the most accuracy, between 0 and 1, the cascade may
+     *                    lose compared to the full model
+     */
+    void Calibrate(const Dataset& dataset, float tolerance);
+
+    /**
+     * Classifies an image, escalating to the full model if stage one is not
+     * confident enough.
+     * @param image - an Image object to classify
+     * @param is_escalated - set to whether the full model made the prediction
+     * @return a char indicating the predicted label of the Image
+     */
+    char Classify(const Image& image, bool& is_escalated) const;
+
+    /**
+     * Scores an image with the stage one pixels only, as Classify() does
+     * before deciding whether to escalate it.
+     * @param image - an Image object to score
+     * @param margin - set to the gap between the top two scores
+     * @return a size_t of the label index, in the order of the model's
+     *         labels, with the highest stage one score
+     */
+    size_t ClassifyStageOne(const Image& image, float& margin) const;
+
+    /**
+     * Tests the cascade on every image of a dataset, like Model::Test.
+     * @param dataset - a Dataset object containing Images & their actual labels
+     * @param escalated_count - set to the number of images that escalated
+     * @return 2D-vector representing a confusion matrix generated from testing
+     */
+    std::vector<std::vector<size_t>> Test(const Dataset& dataset,
+                                          size_t& escalated_count) const;
+
+    /**
+     * Getter for the number of pixels stage one scores.
+     * @return a size_t indicating the number of stage one pixels
+     */
+    size_t GetPixelCount() const;
+
+    /**
+     * Getter for the smallest margin, in log10 likelihood, between the top two
+     * stage one scores for which the stage one prediction is kept.
+     * @return a float margin, infinity if every image escalates
+     */
+    float GetMarginThreshold() const;
+
+  private:
+    const Model& model_;
+    std::vector<char> labels_;
+    std::vector<float> class_likelihoods_;
+    size_t width_;
+
+    // The pixels stage one scores, as row * width + column
+    std::vector<size_t> pixels_;
+    // The likelihoods of the stage one pixels, laid out as
+    // [pixel rank][label index][shading] so one pixel is scored contiguously
+    std::vector<float> pixel_likelihoods_;
+    float margin_threshold_;
+
+    // The most images each task of the thread pool classifies at once
+    static constexpr size_t kClassifyGrainSize = 256;
+
+    /**
+     * Replaces the stage one pixels with the given pixels and gathers their
+     * likelihoods from the model.
+     * @param pixels - the pixel indices for stage one to score
+     */
+    void SetPixels(const std::vector<size_t>& pixels);
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_CASCADE_CLASSIFIER_H
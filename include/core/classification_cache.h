@@ -0,0 +1,118 @@
+#ifndef NAIVE_BAYES_CLASSIFICATION_CACHE_H
+#define NAIVE_BAYES_CLASSIFICATION_CACHE_H
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "core/model.h"
+
+namespace naivebayes {
+
+/**
+ * A bounded least recently used cache of the scores a Model gave to images,
+ * so exact duplicate images are only scored once. Images are keyed by a hash
+ * of their packed pixels, and the pixels are compared on every hit so a hash
+ * collision can never return another image's scores. The cache is split into
+ * shards with a lock each, so many threads can use it at once. Scores from
+ * any model other than the one last used are never returned.
+ */
+class ClassificationCache {
+  public:
+    // The number of independently locked shards the entries are spread over
+    static constexpr size_t kShardCount = 16;
+
+    /**
+     * Creates a cache that holds at most the given number of images.
+     * @param capacity - the most images to hold, 0 to never cache anything
+     */
+    explicit ClassificationCache(size_t capacity);
+
+    /**
+     * Classifies an image with the given model, scoring it only if the cache
+     * does not already hold its scores from that model.
+     * @param model - a trained or loaded Model to classify the image with
+     * @param image - an Image object to classify
+     * @return a char indicating the predicted label of the Image
+     */
+    char Classify(const Model& model, const Image& image);
+
+    /**
+     * Looks up the scores an image was given by the model with the given
+     * generation. Seeing a new generation drops every cached entry.
+     * @param image - the Image to look up
+     * @param generation - the generation of the model, from GetGeneration()
+     * @param scores - a vector to fill with the score of each label index
+     * @return a bool indicating whether the scores were cached
+     */
+    bool Find(const Image& image, uint64_t generation,
+              std::vector<float>& scores);
+
+    /**
+     * Caches the scores the model with the given generation gave an image,
+     * evicting the least recently used image of its shard if it is full.
+     * @param image - the Image that was scored
+     * @param generation - the generation of the model, from GetGeneration()
+     * @param scores - the score of each label index
+     */
+    void Insert(const Image& image, uint64_t generation,
+                const std::vector<float>& scores);
+
+    /**
+     * Drops every cached entry.
+     */
+    void Clear();
+
+    size_t GetHitCount() const;
+    size_t GetMissCount() const;
+    size_t GetEvictionCount() const;
+    size_t GetInvalidationCount() const;
+
+  private:
+    /**
+     * A cached image and its scores. The packed pixels are kept to verify
+     * hits against.
+     */
+    struct Entry {
+      uint64_t hash_;
+      size_t height_;
+      size_t width_;
+      std::vector<uint8_t> packed_pixels_;
+      uint64_t generation_;
+      std::vector<float> scores_;
+    };
+
+    /**
+     * One locked part of the cache. Entries are ordered from most to least
+     * recently used, and indexed by hash. Images with the same hash share an
+     * index slot, so a colliding image replaces the other.
+     */
+    struct Shard {
+      std::mutex mutex_;
+      std::list<Entry> entries_;
+      std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+    };
+
+    size_t shard_capacity_;
+    std::vector<Shard> shards_;
+
+    // The generation of the model the cached scores came from, 0 if none
+    std::atomic<uint64_t> generation_;
+
+    std::atomic<size_t> hit_count_;
+    std::atomic<size_t> miss_count_;
+    std::atomic<size_t> eviction_count_;
+    std::atomic<size_t> invalidation_count_;
+
+    /**
+     * Drops every entry if the given generation is not the cached one.
+     * @param generation - the generation of the model being used
+     */
+    void CheckGeneration(uint64_t generation);
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_CLASSIFICATION_CACHE_H
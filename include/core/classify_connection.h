@@ -0,0 +1,146 @@
+#ifndef NAIVE_BAYES_CLASSIFY_CONNECTION_H
+#define NAIVE_BAYES_CLASSIFY_CONNECTION_H
+
+#include <string>
+#include <vector>
+
+#include "core/image.h"
+
+namespace naivebayes {
+
+/**
+ * The result of classifying a single image on the classification server.
+ */
+struct ClassifyResponse {
+  char label_;
+  // The likelihood score of each label the model knows, in the same order
+  std::vector<char> labels_;
+  std::vector<float> scores_;
+};
+
+/**
+ * The kinds of request a classification server answers.
+ */
+enum class RequestType : uint8_t {
+  kClassify = 0,
+  kReload = 1,
+  kStats = 2
+};
+
+/**
+ * Sends and receives classification requests and responses over a connected
+ * Unix domain socket. Every message is a uint32 payload size followed by the
+ * payload. A request payload starts with its uint8 RequestType. A classify
+ * request follows it with a uint16 height, a uint16 width and the image
+ * packed by Image::Pack(), and its response payload is the predicted label, a
+ * uint32 count and that many label and float score pairs. Control requests
+ * carry nothing else and are answered with text. Both ends are on the same
+ * machine, so numbers are sent in host byte order.
+ */
+class ClassifyConnection {
+  public:
+    /**
+     * Takes ownership of an already connected socket.
+     * @param socket_fd - the file descriptor of the socket, closed on delete
+     */
+    explicit ClassifyConnection(int socket_fd);
+
+    ~ClassifyConnection();
+
+    ClassifyConnection(const ClassifyConnection&) = delete;
+    ClassifyConnection& operator=(const ClassifyConnection&) = delete;
+
+    /**
+     * Connects to a classification server listening on the given socket.
+     * @param socket_path - the file path of the server's Unix domain socket
+     * @return an int file descriptor of the connected socket, -1 on failure
+     */
+    static int Connect(const std::string& socket_path);
+
+    /**
+     * Getter for whether the connection can still be used.
+     * @return a bool that is false once any read or write has failed
+     */
+    bool IsOpen() const;
+
+    /**
+     * Reads a request, unpacking its image if it is a classify request. An
+     * image without any rows or columns is not well formed.
+     * @param type - the RequestType to set to the kind of request read
+     * @param image - the Image object to fill with the requested image
+     * @return a bool indicating whether a well formed request was read
+     */
+    bool ReadRequest(RequestType& type, Image& image);
+
+    /**
+     * Sends a request to classify an image.
+     * @param image - the Image to classify
+     * @return a bool indicating whether the request was sent
+     */
+    bool WriteRequest(const Image& image);
+
+    /**
+     * Sends a control request, which carries nothing besides its type.
+     * @param type - the RequestType of the control request, not kClassify
+     * @return a bool indicating whether the request was sent
+     */
+    bool WriteControlRequest(RequestType type);
+
+    /**
+     * Reads the text answering a control request.
+     * @param text - the string to fill with the text
+     * @return a bool indicating whether the text was read
+     */
+    bool ReadText(std::string& text);
+
+    /**
+     * Sends the text answering a control request.
+     * @param text - the string to send
+     * @return a bool indicating whether the text was sent
+     */
+    bool WriteText(const std::string& text);
+
+    /**
+     * Reads the response to a request.
+     * @param response - the ClassifyResponse to fill with the response
+     * @return a bool indicating whether a well formed response was read
+     */
+    bool ReadResponse(ClassifyResponse& response);
+
+    /**
+     * Sends the response to a request.
+     * @param response - the ClassifyResponse to send
+     * @return a bool indicating whether the response was sent
+     */
+    bool WriteResponse(const ClassifyResponse& response);
+
+    /**
+     * Stops all reads and writes on the socket, waking up any thread that is
+     * blocked reading from it.
+     */
+    void Shutdown();
+
+  private:
+    int socket_fd_;
+    bool is_open_;
+
+    // Bounds the memory a single malformed or hostile message can take
+    static constexpr uint32_t kMaxPayloadSize = 1 << 20;
+
+    /**
+     * Reads one message and returns its payload.
+     */
+    bool ReadMessage(std::vector<uint8_t>& payload);
+
+    /**
+     * Sends one message, writing its size before the payload.
+     */
+    bool WriteMessage(const std::vector<uint8_t>& payload);
+
+    bool ReadFully(uint8_t* buffer, size_t size);
+    bool WriteFully(const uint8_t* buffer, size_t size);
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_CLASSIFY_CONNECTION_H
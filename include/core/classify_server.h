@@ -0,0 +1,220 @@
+#ifndef NAIVE_BAYES_CLASSIFY_SERVER_H
+#define NAIVE_BAYES_CLASSIFY_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+
+#include "core/classification_cache.h"
+#include "core/classify_connection.h"
+#include "core/model.h"
+
+namespace naivebayes {
+
+/**
+ * Serves classifications from a model file over a Unix domain socket. Each
+ * connection is handled on its own thread, and the requests of all connections
+ * are gathered into micro-batches that are scored together. The model can be
+ * reloaded while serving without dropping any requests.
+ */
+class ClassifyServer {
+  public:
+    /**
+     * Creates a server for the model saved at the given path.
+     * @param model_path - the file path of the saved model to serve
+     * @param max_batch_size - the most requests to score in a single batch
+     * @param batch_window_micros - how long to wait for more requests to join
+     *                              a batch after its first request arrives
+     * @param cache_size - the most images to cache the scores of, so exact
+     *                     duplicates skip scoring, 0 to not cache
+     */
+    ClassifyServer(const std::string& model_path, size_t max_batch_size,
+                   size_t batch_window_micros, size_t cache_size);
+
+    ~ClassifyServer();
+
+    ClassifyServer(const ClassifyServer&) = delete;
+    ClassifyServer& operator=(const ClassifyServer&) = delete;
+
+    /**
+     * Loads the model, then listens on the given socket and serves requests
+     * until Stop() is called. Any file already at the socket path is replaced.
+     * @param socket_path - the file path to create the Unix domain socket at
+     * @return a 0 or 1, depending on whether the server could start
+     */
+    int Serve(const std::string& socket_path);
+
+    /**
+     * Asks the server to stop. This only sets a flag, so it is safe to call
+     * from a signal handler, and Serve() returns shortly after.
+     */
+    void Stop();
+
+    /**
+     * Asks the server to reload its model file. This only sets a flag, so it
+     * is safe to call from a signal handler.
+     */
+    void RequestReload();
+
+    /**
+     * Loads the model file again and swaps it in for the batches that follow.
+     * Batches already being scored finish with the model they started with.
+     * @return a bool indicating whether the new model was loaded
+     */
+    bool Reload();
+
+    /**
+     * Describes the active model and how much the server has done.
+     * @return a string of a json object with the server's stats
+     */
+    std::string GetStats();
+
+  private:
+    /**
+     * A request waiting on a connection thread for its batch to be scored.
+     */
+    struct PendingRequest {
+      Image image_;
+      ClassifyResponse response_;
+      bool is_classified_;
+      bool is_done_;
+    };
+
+    /**
+     * A loaded model, published to the batching thread as a whole.
+     */
+    struct ModelVersion {
+      Model model_;
+      std::vector<char> labels_;
+      size_t number_;
+      std::string loaded_at_;
+      double load_millis_;
+    };
+
+    std::string model_path_;
+
+    // The model new batches are scored with. Only Reload() replaces it, and
+    // only while holding reload_mutex_.
+    std::atomic<ModelVersion*> active_version_;
+    // The version the batching thread is scoring a batch with, if any. A
+    // replaced version is not deleted while this still points to it.
+    std::atomic<ModelVersion*> batch_version_;
+
+    // Serializes reloads, and guards reading the active version off the
+    // batching thread
+    std::mutex reload_mutex_;
+    std::atomic<bool> is_reload_requested_;
+    size_t failed_reload_count_;
+
+    size_t max_batch_size_;
+    std::chrono::microseconds batch_window_;
+
+    // Scores of recent images, keyed to the model generation they came from,
+    // so a reload invalidates them
+    ClassificationCache cache_;
+
+    std::atomic<bool> is_running_;
+
+    // Guards the queue of requests and whether the batching thread runs
+    std::mutex queue_mutex_;
+    std::condition_variable queue_condition_;
+    std::condition_variable done_condition_;
+    std::deque<PendingRequest*> queue_;
+    bool is_batching_;
+
+    // Guards the open connections, so they can be shut down on Stop()
+    std::mutex connections_mutex_;
+    std::condition_variable connections_condition_;
+    std::set<ClassifyConnection*> connections_;
+    size_t active_connection_count_;
+
+    std::atomic<size_t> request_count_;
+    std::atomic<size_t> batch_count_;
+
+    // How often the accept loop checks whether the server was stopped
+    static constexpr int kAcceptPollMillis = 100;
+    // How often the reload thread checks whether a reload was requested
+    static constexpr int kReloadPollMillis = 100;
+    static constexpr int kListenBacklog = 128;
+
+    static const std::string kListeningMessage;
+    static const std::string kStartFailedMessage;
+    static const std::string kStoppingMessage;
+    static const std::string kRequestCountMessage;
+    static const std::string kBatchCountMessage;
+    static const std::string kLoadedMessage;
+    static const std::string kLoadFailedMessage;
+
+    static const std::string kStatsVersionKey;
+    static const std::string kStatsLoadedAtKey;
+    static const std::string kStatsLoadMillisKey;
+    static const std::string kStatsFailedReloadsKey;
+    static const std::string kStatsRequestsKey;
+    static const std::string kStatsBatchesKey;
+    static const std::string kStatsCacheHitsKey;
+    static const std::string kStatsCacheMissesKey;
+    static const std::string kStatsCacheEvictionsKey;
+    static const std::string kStatsCacheInvalidationsKey;
+
+    /**
+     * Reads and deserializes the model file into a new version.
+     * @return a pointer to the new ModelVersion, nullptr if it can't be loaded
+     */
+    ModelVersion* LoadVersion(size_t number) const;
+
+    /**
+     * Finds the active model version and marks it as used by the batching
+     * thread, so it is not deleted until ReleaseVersion() is called.
+     */
+    ModelVersion* AcquireVersion();
+
+    /**
+     * Marks that the batching thread no longer uses any model version.
+     */
+    void ReleaseVersion();
+
+    /**
+     * Reads requests from a connection until it closes or sends a request
+     * the model can't classify, answering each once its batch is scored.
+     * Control requests are answered right away.
+     * @param socket_fd - the file descriptor of the accepted connection
+     */
+    void HandleConnection(int socket_fd);
+
+    /**
+     * Repeatedly takes a batch of requests off the queue and scores it, until
+     * the server is stopped and the queue is empty.
+     */
+    void RunBatches();
+
+    /**
+     * Reloads the model whenever RequestReload() is called, until the server
+     * is stopped. This runs on its own thread, so loading a model never holds
+     * up accepting connections.
+     */
+    void RunReloads();
+
+    /**
+     * Scores every request of a batch together and fills in its response.
+     * Requests for images of a different size than the model's are skipped,
+     * and requests for cached images are answered from the cache.
+     * @param batch - the requests to score
+     * @param version - the ModelVersion to score them with
+     */
+    void ClassifyBatch(const std::vector<PendingRequest*>& batch,
+                       const ModelVersion& version);
+
+    /**
+     * Creates, binds and starts listening on the Unix domain socket.
+     * @param socket_path - the file path to create the socket at
+     * @return an int file descriptor of the socket, -1 on failure
+     */
+    static int Listen(const std::string& socket_path);
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_CLASSIFY_SERVER_H
@@ -0,0 +1,151 @@
+#ifndef NAIVE_BAYES_COMPRESSED_FILE_H
+#define NAIVE_BAYES_COMPRESSED_FILE_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+namespace naivebayes {
+
+/**
+ * Reads a gzip or zstd compressed file as an istream of its decompressed
+ * bytes. The file is decompressed on a separate thread in blocks of
+ * kBlockSize bytes, up to kQueuedBlockCount blocks ahead of the reader, so
+ * decompressing overlaps with parsing what was already decompressed. The
+ * format is detected from the magic bytes the file starts with, and zstd
+ * files can only be read if the build found the zstd library.
+ */
+class CompressedFile {
+  public:
+    /**
+     * The compression formats a file can be detected as.
+     */
+    enum class Format {
+      kNone,
+      kGzip,
+      kZstd
+    };
+
+    /**
+     * Creates an object with no file open, whose stream is empty.
+     */
+    CompressedFile();
+
+    ~CompressedFile();
+
+    CompressedFile(const CompressedFile&) = delete;
+    CompressedFile& operator=(const CompressedFile&) = delete;
+
+    /**
+     * Detects the compression format of a stream from its magic bytes,
+     * leaving the stream where it was.
+     * @param input - an istream at the start of a file
+     * @return the Format of the stream, kNone if it is not compressed
+     */
+    static Format DetectFormat(std::istream& input);
+
+    /**
+     * Opens a compressed file and starts decompressing it, closing any file
+     * opened before.
+     * @param path - the file path of the compressed file
+     * @return a bool indicating whether the file is open, false if it can't
+     *         be opened or is not compressed
+     * @throws std::invalid_argument if the file is compressed with zstd and
+     * the build has no zstd support
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * Getter for a stream of the decompressed file. Reading it throws
+     * std::invalid_argument if the file turns out to be corrupt or truncated.
+     * @return an istream of the decompressed bytes
+     */
+    std::istream& GetStream();
+
+  private:
+    /**
+     * A stream buffer that reads the decompressed blocks in order.
+     */
+    class BlockBuffer : public std::streambuf {
+      public:
+        explicit BlockBuffer(CompressedFile& file);
+        void Reset();
+
+      protected:
+        int_type underflow() override;
+
+      private:
+        CompressedFile& file_;
+        std::string block_;
+    };
+
+    std::ifstream input_;
+    Format format_;
+
+    // Decompressed blocks are handed from the decompressor to the reader
+    std::thread decompressor_;
+    std::mutex mutex_;
+    std::condition_variable block_queued_;
+    std::condition_variable block_taken_;
+    std::deque<std::string> blocks_;
+    bool is_finished_;
+    bool is_stopping_;
+    std::exception_ptr error_;
+
+    BlockBuffer buffer_;
+    std::istream stream_;
+
+    // The number of bytes read or decompressed at once
+    static constexpr size_t kBlockSize = 1 << 20;
+
+    // The most decompressed blocks waiting to be read
+    static constexpr size_t kQueuedBlockCount = 4;
+
+    /**
+     * Stops decompressing and closes the file, if any.
+     */
+    void Close();
+
+    /**
+     * Decompresses the whole file, then marks the blocks finished. Runs on
+     * the decompressor thread.
+     */
+    void Decompress();
+
+    /**
+     * Decompresses every gzip member of the file into blocks.
+     * @return a bool indicating whether the file is a valid gzip file
+     */
+    bool DecompressGzip();
+
+    /**
+     * Decompresses every zstd frame of the file into blocks.
+     * @return a bool indicating whether the file is a valid zstd file
+     */
+    bool DecompressZstd();
+
+    /**
+     * Queues a decompressed block, waiting for the reader to make room.
+     * @param block - the block to queue, which is moved from
+     * @return a bool indicating whether to keep decompressing
+     */
+    bool PushBlock(std::string& block);
+
+    /**
+     * Takes the next decompressed block, waiting for it to be decompressed.
+     * @param block - a string to move the block into
+     * @return a bool indicating whether there was a block left
+     * @throws std::invalid_argument if the file can't be decompressed
+     */
+    bool PopBlock(std::string& block);
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_COMPRESSED_FILE_H
@@ -40,6 +40,12 @@ class Dataset {
      * @return a vector of char containing all the distinct class labels
      */
     std::vector<char> GetDistinctLabels() const;
+
+    /**
+     * Adds an Image to the group of images sharing its label.
+     * @param image - the Image to add to this dataset
+     */
+    void AddImage(const Image& image);
     
     /**
      * Overloaded extraction operator - populates this Dataset with encoded 
@@ -58,18 +64,6 @@ class Dataset {
     
     // Groups Images by common labels
     std::map<char, std::vector<Image>> class_groups_;
-    
-    static constexpr char kFileLineDelimiter = '\n';
-    
-    /**
-     * Parses the first image in an input stream to infer the dimension of all 
-     * following images in the stream, as assumed in the project description
-     * @param input - an istream to read the first image from
-     * @return an Image struct representing an encoded form of the 1st image in 
-     * the stream and is used to infer the dimension of all other images
-     * @throws std::invalid_argument if the first image is missing a label
-     */
-    Image ParseFirstImage(std::istream& input) const;
 };
 
 } // namespace naivebayes
@@ -0,0 +1,91 @@
+#ifndef NAIVE_BAYES_DATASET_CACHE_H
+#define NAIVE_BAYES_DATASET_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+#include "core/mapped_file.h"
+
+namespace naivebayes {
+
+/**
+ * Keeps a binary snapshot of each text dataset read in a cache directory, so
+ * later runs map the snapshot into memory instead of parsing the text again.
+ * Snapshots are written in the binary dataset format and named after a key
+ * of the absolute path, size and modification time of the dataset and a hash
+ * of its first and last kFingerprintBlockSize bytes, so an edited dataset
+ * gets a new snapshot. Once the snapshots grow past the size limit, the least
+ * recently read ones are removed.
+ */
+class DatasetCache {
+  public:
+    // Appended to the key of a dataset to get the file name of its snapshot
+    static const std::string kSnapshotExtension;
+
+    /**
+     * Creates a cache that is disabled and never opens a snapshot.
+     */
+    DatasetCache();
+
+    /**
+     * Creates a cache that keeps its snapshots in the given directory, which
+     * is created when the first snapshot is written.
+     * @param directory - the path of the directory to keep snapshots in
+     * @param max_size - the most bytes all snapshots may take, 0 for no limit
+     */
+    DatasetCache(const std::string& directory, uint64_t max_size);
+
+    /**
+     * Getter for whether this cache keeps snapshots.
+     * @return a bool indicating whether the cache has a directory
+     */
+    bool IsEnabled() const;
+
+    /**
+     * Maps the snapshot of a text dataset, writing the snapshot first if the
+     * cache has none that matches the dataset.
+     * @param dataset_path - the file path of the text dataset
+     * @param snapshot - the MappedFile to map the snapshot with
+     * @return a bool indicating whether a snapshot was mapped. It is false if
+     *         the cache is disabled, the dataset can't be opened or is binary
+     *         already, or the snapshot can't be written, and then the dataset
+     *         should be read directly.
+     * @throws std::invalid_argument if the dataset is not a valid dataset
+     */
+    bool Open(const std::string& dataset_path, MappedFile& snapshot) const;
+
+    /**
+     * Finds the path the snapshot of a dataset is kept at.
+     * @param dataset_path - the file path of the dataset
+     * @return a string of the snapshot path, empty if the dataset can't be
+     *         opened
+     */
+    std::string GetSnapshotPath(const std::string& dataset_path) const;
+
+  private:
+    std::string directory_;
+    uint64_t max_size_;
+
+    // The number of bytes hashed at each end of a dataset for its key
+    static constexpr size_t kFingerprintBlockSize = 1 << 20;
+
+    /**
+     * Writes the snapshot of a text dataset to a temporary file, then moves
+     * it into place so no run can read a partly written snapshot.
+     * @return a bool indicating whether the snapshot was written
+     * @throws std::invalid_argument if the dataset is not a valid dataset
+     */
+    bool WriteSnapshot(const std::string& dataset_path,
+                       const std::string& snapshot_path) const;
+
+    /**
+     * Removes the least recently read snapshots until all of them fit in the
+     * size limit.
+     * @param kept_path - the path of a snapshot that is never removed
+     */
+    void Evict(const std::string& kept_path) const;
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_DATASET_CACHE_H
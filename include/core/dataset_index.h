@@ -0,0 +1,154 @@
+#ifndef NAIVE_BAYES_DATASET_INDEX_H
+#define NAIVE_BAYES_DATASET_INDEX_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "core/dataset.h"
+
+namespace naivebayes {
+
+/**
+ * Records where every image of a text dataset file starts and what its label
+ * is, so images can be read in any order and the file can be split on image
+ * boundaries and parsed by many threads at once. The index is saved next to
+ * the dataset with kIndexExtension appended to its path, along with the size
+ * and modification time of the dataset, and is only reused while both match.
+ */
+class DatasetIndex {
+  public:
+    // Appended to the path of a dataset to get the path of its index
+    static const std::string kIndexExtension;
+
+    /**
+     * Creates an empty index.
+     */
+    DatasetIndex();
+
+    /**
+     * Builds the index of a text dataset in one pass over the stream.
+     * @param input - an istream at the start of a text dataset
+     * @return a DatasetIndex of every image in the stream
+     * @throws std::invalid_argument if the stream is empty or any image is
+     * missing a label or ends early
+     */
+    static DatasetIndex Build(std::istream& input);
+
+    /**
+     * Loads the saved index of a text dataset if it still matches the
+     * dataset, and otherwise builds the index and tries to save it.
+     * @param dataset_path - the file path of the text dataset
+     * @param index - the DatasetIndex to fill
+     * @return a bool indicating whether the dataset could be indexed
+     * @throws std::invalid_argument if the dataset is not a valid text dataset
+     */
+    static bool LoadOrBuild(const std::string& dataset_path,
+                            DatasetIndex& index);
+
+    /**
+     * Getter for the number of images in the indexed dataset.
+     * @return a size_t indicating the number of images
+     */
+    size_t GetImageCount() const;
+
+    /**
+     * Getter for the label of an image without reading the image.
+     * @param image_index - the index of the image in the dataset
+     * @return a char indicating the label of the image
+     */
+    char GetLabel(size_t image_index) const;
+
+    /**
+     * Reads a single image of the indexed dataset.
+     * @param input - an istream of the indexed dataset, which is sought to
+     *                the image
+     * @param image_index - the index of the image in the dataset
+     * @return the Image at the given index
+     * @throws std::invalid_argument if the image can't be read
+     */
+    Image ReadImage(std::istream& input, size_t image_index) const;
+
+    /**
+     * Reads a range of images of the indexed dataset, splitting it into
+     * chunks on image boundaries that the shared ThreadPool parses at once.
+     * The images are added in file order.
+     * @param dataset_path - the file path of the indexed dataset
+     * @param first_image - the index of the first image to read
+     * @param end_image - the index past the last image to read
+     * @param chunk_count - the number of chunks to split the range into
+     * @param images - a vector to add the images of the range to
+     * @throws std::invalid_argument if any image can't be parsed
+     */
+    void ReadImages(const std::string& dataset_path, size_t first_image,
+                    size_t end_image, size_t chunk_count,
+                    std::vector<Image>& images) const;
+
+    /**
+     * Reads every image of the indexed dataset, splitting the file into
+     * chunks on image boundaries that the shared ThreadPool parses at once.
+     * The images are added in file order, so each label group is in the same
+     * order as when the file is read with operator>>.
+     * @param dataset_path - the file path of the indexed dataset
+     * @param chunk_count - the number of chunks to split the file into
+     * @param dataset - the Dataset to add every image to
+     * @return a bool indicating whether the dataset could be read
+     * @throws std::invalid_argument if any image can't be parsed
+     */
+    bool ReadDataset(const std::string& dataset_path, size_t chunk_count,
+                     Dataset& dataset) const;
+
+    /**
+     * Overloaded insertion operator - streams the index in its binary format.
+     * @param output - an ostream to insert the index into
+     * @param index - a DatasetIndex object to insert into the ostream
+     * @return the ostream after the index has been inserted
+     */
+    friend std::ostream& operator<<(std::ostream& output,
+                                    const DatasetIndex& index);
+
+    /**
+     * Overloaded extraction operator - reads an index in its binary format.
+     * @param input - an istream to extract a saved index from
+     * @param index - a DatasetIndex object to fill with the saved index
+     * @return the istream, which fails if the index is not valid
+     */
+    friend std::istream& operator>>(std::istream& input, DatasetIndex& index);
+
+  private:
+    size_t height_;
+    size_t width_;
+    // The size in bytes of the dataset, the end of its last image
+    uint64_t file_size_;
+    // The modification time of the dataset when it was indexed, 0 if unknown
+    int64_t modified_time_;
+
+    // The byte offset of the label line and the label of each image
+    std::vector<uint64_t> offsets_;
+    std::vector<char> labels_;
+
+    // The bytes a saved index starts with
+    static const std::string kIndexMagic;
+
+    /**
+     * Finds the size and modification time of a file.
+     * @return a bool indicating whether the file exists
+     */
+    static bool GetFileStatus(const std::string& path, uint64_t& file_size,
+                              int64_t& modified_time);
+
+    /**
+     * Parses the images of a range of the dataset.
+     * @param input - an istream of the indexed dataset
+     * @param first_image - the index of the first image to parse
+     * @param end_image - the index past the last image to parse
+     * @param images - a vector to fill with the parsed images
+     */
+    void ReadRange(std::istream& input, size_t first_image, size_t end_image,
+                   std::vector<Image>& images) const;
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_DATASET_INDEX_H
@@ -0,0 +1,105 @@
+#ifndef NAIVE_BAYES_DEDUPLICATED_DATASET_H
+#define NAIVE_BAYES_DEDUPLICATED_DATASET_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "core/image.h"
+
+namespace naivebayes {
+
+/**
+ * Stores a set of images with exact duplicates collapsed into one entry that
+ * remembers how many times it was added and their summed weight. Each entry
+ * keeps only its label and packed pixels, so a heavily duplicated dataset
+ * takes a fraction of the memory a Dataset would. Images are looked up by a
+ * hash of their label and packed pixels, and the pixels are compared on every
+ * match so a hash collision never merges two different images.
+ */
+class DeduplicatedDataset {
+  public:
+    /**
+     * Creates an empty dataset. The image dimension is taken from the first
+     * image that is added.
+     */
+    DeduplicatedDataset();
+
+    /**
+     * Adds an image, or counts it again if an equal image was already added.
+     * @param image - the Image to add
+     * @return a bool indicating whether the image had not been added before
+     * @throws std::invalid_argument if the image is not the same size as all
+     * previously added images
+     */
+    bool AddImage(const Image& image);
+
+    /**
+     * Adds a weighted image, or adds its weight to the entry of an equal image
+     * that was already added.
+     * @param image - the Image to add
+     * @param weight - the weight of the image
+     * @return a bool indicating whether the image had not been added before
+     * @throws std::invalid_argument if the image is not the same size as all
+     * previously added images
+     */
+    bool AddImage(const Image& image, double weight);
+
+    /**
+     * Getter for the number of images added, counting every duplicate.
+     * @return a size_t indicating the number of images added
+     */
+    size_t GetImageCount() const;
+
+    /**
+     * Getter for the number of distinct images added.
+     * @return a size_t indicating the number of entries
+     */
+    size_t GetEntryCount() const;
+
+    /**
+     * Finds how many images were added for each distinct one that is stored.
+     * @return a double dedup ratio, 1 if nothing was duplicated or added
+     */
+    double GetDedupRatio() const;
+
+    /**
+     * Unpacks the image of an entry.
+     * @param entry - the index of the entry, less than GetEntryCount()
+     * @return an Image equal to the images added for the entry
+     */
+    Image GetImage(size_t entry) const;
+
+    /**
+     * Getter for how many times the image of an entry was added.
+     * @param entry - the index of the entry, less than GetEntryCount()
+     * @return a size_t indicating the multiplicity of the entry
+     */
+    size_t GetMultiplicity(size_t entry) const;
+
+    /**
+     * Getter for the summed weight of the images added for an entry.
+     * @param entry - the index of the entry, less than GetEntryCount()
+     * @return a double indicating the weight of the entry
+     */
+    double GetWeight(size_t entry) const;
+
+  private:
+    size_t height_;
+    size_t width_;
+    size_t packed_size_;
+    size_t image_count_;
+
+    // The label, multiplicity, weight and packed pixels of each entry. The
+    // pixels of every entry are stored back to back, packed_size_ bytes each.
+    std::vector<char> labels_;
+    std::vector<size_t> multiplicities_;
+    std::vector<double> weights_;
+    std::vector<uint8_t> packed_pixels_;
+
+    // The entries with each hash. Different images can share a hash.
+    std::unordered_multimap<uint64_t, size_t> index_;
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_DEDUPLICATED_DATASET_H
@@ -5,10 +5,138 @@
 #ifndef NAIVE_BAYES_EXECUTABLE_LOGIC_H
 #define NAIVE_BAYES_EXECUTABLE_LOGIC_H
 
+#include "core/compressed_file.h"
+#include "core/dataset_cache.h"
+#include "core/dataset_index.h"
+#include "core/image_sampler.h"
+#include "core/perf_counters.h"
+#include "core/read_ahead_file.h"
 #include "core/model.h"
 
 namespace naivebayes {
 
+/**
+ * This struct holds the values of all flags passed in the command line. Any
+ * string flag left empty means the logic it drives is skipped.
+ */
+struct ExecutionFlags {
+  // The file path of the dataset to train the model on
+  std::string train_;
+  // The file path of the model file to load into the model in memory
+  std::string load_;
+  // The file to save the model to
+  std::string save_;
+  // The file path of the dataset to test the model on
+  std::string test_;
+  // The file path to save the confusion matrix generated from testing to
+  std::string confusion_;
+  // Whether to print the progress of parsing, training and testing, with
+  // the images per second, from a background thread
+  bool is_printing_verbose_ = false;
+  // The file path to save the top predictions of every test image to
+  std::string predictions_;
+  // The number of predictions to save for each test image
+  size_t top_k_ = 2;
+
+  // The file to save the count checkpoint of the training images to
+  std::string save_counts_;
+  // Training only counts every image whose index in the file is shard_index_
+  // modulo shard_count_, so a file can be split across many processes
+  size_t shard_index_ = 0;
+  size_t shard_count_ = 1;
+  // Whether to collapse exact duplicate training images into one weighted
+  // entry each and report how much of the training set was duplicated
+  bool is_deduplicating_ = false;
+  // The file path of a sidecar file with one weight for each training image,
+  // in the order of the images in the dataset. Weights from a weighted binary
+  // dataset are multiplied by these.
+  std::string weights_;
+  // Whether to rescale the weights of each class so every class has the same
+  // total weight when training
+  bool is_balancing_classes_ = false;
+
+  // The number of folds to cross validate the training images with, 0 to
+  // skip cross validation
+  size_t fold_count_ = 0;
+  // The file path to save the sum of the confusion matrices of all folds to
+  std::string fold_confusion_;
+
+  // The number of most discriminative pixels to prune the model to, 0 to
+  // keep every pixel
+  size_t prune_top_ = 0;
+  // The smallest variance of log likelihoods across classes a pixel needs to
+  // be kept, 0 to keep every pixel
+  float prune_below_ = 0;
+  // Whether to print the test accuracy of the model pruned to a range of
+  // fractions of its pixels
+  bool is_printing_prune_report_ = false;
+
+  // The file path of the dataset to calibrate a cascade classifier with
+  std::string cascade_;
+  // The most accuracy the cascade may lose compared to the full model
+  float cascade_tolerance_ = 0.01f;
+
+  // The file path of the images to classify, or "-" to read them from stdin.
+  // Predictions are written to stdout and every message to stderr instead.
+  std::string classify_;
+  // Whether to follow each prediction with the score of every label
+  bool is_printing_scores_ = false;
+  // The most images to cache the scores of while classifying, so duplicate
+  // images are scored once, 0 to not cache
+  size_t cache_size_ = 0;
+
+  // The number of images to sample uniformly from each dataset read, 0 to
+  // not sample a fixed number of images
+  size_t sample_size_ = 0;
+  // The number of images to sample of each label, as a comma separated list
+  // of label:count pairs where * stands for every other label, or a single
+  // count for every label. Empty to not sample by label.
+  std::string sample_quotas_;
+  // The fraction of the images of each dataset read to sample, 0 to not
+  // sample a fraction
+  double sample_fraction_ = 0;
+  // The seed of the random sample, so the same sample can be drawn again
+  uint64_t sample_seed_ = 0;
+
+  // Whether to read whole text datasets in parallel with a sidecar index of
+  // their images, built next to each dataset the first time it is read
+  bool is_indexing_datasets_ = false;
+
+  // The directory to keep a binary snapshot of each text dataset read in, so
+  // later runs map the snapshot instead of parsing the text. Empty to not
+  // keep snapshots.
+  std::string dataset_cache_;
+  // The most megabytes the snapshots may take, 0 for no limit
+  uint64_t dataset_cache_mb_ = 0;
+
+  // Whether to read datasets on a background thread ahead of parsing them,
+  // and report the bandwidth they were read at
+  bool is_reading_ahead_ = false;
+
+  // The number of threads to train, test, parse and classify with, counting
+  // the main thread, 0 for one per core
+  size_t thread_count_ = 0;
+  // Whether to pin each worker thread to a core, spread over the NUMA nodes,
+  // and report how many images each node tested per second
+  bool is_pinning_threads_ = false;
+  // Whether to also copy the model onto each NUMA node before testing it,
+  // which pins the threads as well
+  bool is_replicating_model_ = false;
+
+  // Whether to count cycles, instructions, cache misses and branch misses
+  // while training, testing and classifying, and print them per image
+  bool is_printing_metrics_ = false;
+
+  // The file to save a Chrome trace of the time each thread spent in each
+  // phase to. Empty to not trace.
+  std::string trace_out_;
+
+  // The file path of a dataset to rewrite in the binary dataset format
+  std::string convert_;
+  // The file to save the converted dataset to
+  std::string convert_out_;
+};
+
 /**
  * This class defines logic of how to handle flags passed in the command line.
  */
@@ -23,42 +151,155 @@ class ExecutableLogic {
     /**
      * Executes the logic and returns the exit status code depending on whether 
      * the logic successfully executed (0) or not (1). This logic will fail
-     * if train_flag and load_flag are both not empty strings since the model
+     * if the train and load flags are both not empty strings since the model
      * must be either loaded or trained, not both. If any flag passed is an 
      * empty string, that logic is skipped. 
-     * @param train_flag - a string indicating the file path of the dataset 
-     *                     to train the model on
-     * @param load_flag - a string indicating the file path of the model file
-     *                    to load into the model in memory
-     * @param save_flag - a string indicating the file to save this model to
-     * @param test_flag - a string indicating the file path of the dataset 
-     *                     to test the model on
-     * @param confusion_flag - a string indicating the file path to save the 
-     *                         confusion matrix generated from testing to
-     * @param is_test_multi_threaded - bool indicating whether to multi thread 
-     *                                 the testing, if we are to test the model
+     * @param flags - the ExecutionFlags parsed from the command line
      * @return a 0 or 1, depending on the result of executing the CLI logic
      */
-    int Execute(const std::string& train_flag, const std::string& load_flag,
-                const std::string& save_flag, const std::string& test_flag, 
-                const std::string& confusion_flag, bool is_printing_verbose);
+    int Execute(const ExecutionFlags& flags);
+
+    /**
+     * Sums any number of count checkpoints and trains the model on the total,
+     * applying this logic's Laplace smoothing, then saves the model.
+     * @param checkpoint_paths - the file paths of the checkpoints to merge
+     * @param save_flag - a string indicating the file to save the model to
+     * @param save_counts_flag - a string indicating the file to save the
+     *                           merged checkpoint to, skipped if empty
+     * @return a 0 or 1, depending on whether every checkpoint could be read
+     *         and was of the same image size
+     */
+    int Merge(const std::vector<std::string>& checkpoint_paths,
+              const std::string& save_flag,
+              const std::string& save_counts_flag);
+
+    // The path that stands for the standard input stream
+    static const std::string kStandardStreamPath;
+
   private:
+    /**
+     * The files a dataset can be read through, of which OpenDataset uses one.
+     */
+    struct DatasetFiles {
+      MappedFile snapshot;
+      CompressedFile compressed_file;
+      ReadAheadFile read_ahead_file;
+      std::ifstream plain_file;
+    };
+
     Model model_;
+
+    // Where to print messages, so they can be kept out of piped predictions
+    std::ostream* message_output_;
+
+    // The counts the model was last trained on, kept to save a checkpoint
+    TrainingCounts counts_;
+
+    // Samples every dataset read, unless it keeps every image. Each dataset
+    // is sampled by a copy, so all of them are drawn with the same seed.
+    ImageSampler sampler_;
+
+    // Whether whole text datasets are read in parallel with an index
+    bool is_indexing_datasets_;
+
+    // Keeps binary snapshots of the text datasets read, unless disabled
+    DatasetCache dataset_cache_;
+
+    // Whether plain datasets are read ahead on a background thread
+    bool is_reading_ahead_;
+
+    // Whether to print the progress of parsing and training datasets
+    bool is_printing_verbose_;
+
+    // Counts hardware events of each phase, unless metrics are off
+    PerfCounters perf_counters_;
     
     // The delimiter to use when generating the csv file
     static constexpr char kCsvElementDelimiter = ',';
+
+    // The number of images to hold in memory at once while training, for
+    // each thread of the pool if the dataset is indexed
+    static constexpr size_t kTrainingChunkSize = 1024;
+
+    // The number of chunks per thread an indexed dataset is split into, so
+    // threads that finish early can steal the chunks of slower ones
+    static constexpr size_t kParseChunksPerThread = 4;
+
+    // The unit of the dataset cache size limit
+    static constexpr uint64_t kBytesPerMegabyte = 1 << 20;
+
+    // The fractions of pixels the pruning report keeps
+    static const std::vector<float> kPruneReportFractions;
+
+    // The number of images to score together while classifying a stream
+    static constexpr size_t kClassifyChunkSize = 256;
     
     // Messages to print throughout executing the user's request
     static const std::string kModelAccuracyMessage;
     static const std::string kTestingModelMessage;
 
     static const std::string kTrainingModelMessage;
+
+    static const std::string kCrossValidatingMessage;
+    static const std::string kTooFewImagesMessage;
+    static const std::string kFoldAccuracyMessage;
+    static const std::string kMeanAccuracyMessage;
     
     static const std::string kLoadingModelMessage;
     static const std::string kLoadingConflictMessage;
     
+    static const std::string kSavingCountsMessage;
+    static const std::string kSavingTraceMessage;
+    static const std::string kTrainingProgressPhase;
+    static const std::string kParsingProgressPhase;
+    static const std::string kMergingCountsMessage;
+    static const std::string kNoCountsMessage;
+
+    static const std::string kPruningModelMessage;
+    static const std::string kPixelsKeptMessage;
+    static const std::string kDedupImagesMessage;
+    static const std::string kDedupDistinctMessage;
+    static const std::string kDedupRatioMessage;
+    static const std::string kPruneReportMessage;
+
+    static const std::string kCalibratingCascadeMessage;
+    static const std::string kCascadePixelsMessage;
+    static const std::string kCascadeThresholdMessage;
+    static const std::string kCascadeAccuracyMessage;
+    static const std::string kEscalatedFractionMessage;
+    static const std::string kModelThroughputMessage;
+    static const std::string kCascadeThroughputMessage;
+
+    static const std::string kClassifyingMessage;
+    static const std::string kClassifiedCountMessage;
+    static const std::string kImageSizeMismatchMessage;
+    static const std::string kCacheHitsMessage;
+    static const std::string kCacheMissesMessage;
+    static const std::string kCacheEvictionsMessage;
+    static const std::string kConvertingMessage;
+    static const std::string kSampledMessage;
+    static const std::string kReadBandwidthMessage;
+    static const std::string kReadBandwidthUnit;
+    static const std::string kNodeThroughputMessage;
+    static const std::string kNodeThroughputUnit;
+    static const std::string kCountersUnavailableMessage;
+    static const std::string kTrainingCountersMessage;
+    static const std::string kTestingCountersMessage;
+    static const std::string kClassifyingCountersMessage;
+    static const std::string kInstructionsPerCycleMessage;
+    static const std::string kL1MissesMessage;
+    static const std::string kLlcMissesMessage;
+    static const std::string kBranchMissesMessage;
+    static const std::string kCounterUnavailableMessage;
+
+    // The syntax of the sample quotas flag, like "0:100,1:50,*:10"
+    static constexpr char kQuotaDelimiter = ',';
+    static constexpr char kQuotaLabelSeparator = ':';
+    static constexpr char kQuotaWildcardLabel = '*';
+
     static const std::string kSavingModelMessage;
     static const std::string kSavingConfusionMatrixMessage;
+    static const std::string kSavingPredictionsMessage;
     static const std::string kConfusionMatrixColumnLabel;
     static const std::string kConfusionMatrixRowLabel;
     static const std::string kConfusionMatrixLabelIndicator;
@@ -73,6 +314,22 @@ class ExecutableLogic {
      */
     void SaveModel(const std::string& file_path) const;
     
+    /**
+     * Save the counts the model was trained on as a checkpoint to the
+     * specified file path. Creates a file, if the file does not exist,
+     * otherwise, overwrites the file.
+     * @param file_path - a string indicating the file to save the counts to
+     */
+    void SaveCounts(const std::string& file_path) const;
+
+    /**
+     * Save the spans traced so far in the Chrome trace event format to the
+     * specified file path. Creates a file, if the file does not exist,
+     * otherwise, overwrites the file.
+     * @param file_path - a string indicating the file to save the trace to
+     */
+    void SaveTrace(const std::string& file_path) const;
+
     /**
      * Loads model from the specified file. Does nothing if file does not exist.
      * @param model_path - a string indicating the path to load the model from
@@ -81,10 +338,50 @@ class ExecutableLogic {
     
     /**
      * Trains model with provided dataset. Does nothing if file does not exist.
+     * The file is streamed in chunks and only the counts of the images are
+     * kept, so memory use does not depend on the size of the dataset. Each
+     * chunk is counted on the shared thread pool, and is also parsed there
+     * if the datasets are indexed.
      * @param dataset_path - a string indicating the path of the dataset to load
+     * @param shard_index - the index of the shard of images to count
+     * @param shard_count - the number of shards the images are split into
+     * @param is_deduplicating - whether to count each distinct image once,
+     *                           weighted by its number of duplicates
+     * @param weights_path - a string indicating the path of a sidecar file
+     *                       with the weight of each image, empty for none
+     * @param is_balancing_classes - whether to give every class the same
+     *                               total weight
      */
-    void TrainModel(const std::string& dataset_path);
+    void TrainModel(const std::string& dataset_path, size_t shard_index,
+                    size_t shard_count, bool is_deduplicating,
+                    const std::string& weights_path,
+                    bool is_balancing_classes);
     
+    /**
+     * Cross validates the model with the provided dataset by splitting its
+     * images into folds, with image i going to fold i % fold_count. Counts of
+     * each fold are taken in a single pass, with each fold counted by its own
+     * task on the shared pool. The model of each fold is the total counts
+     * minus that fold's counts, so nothing is retrained. The folds are tested
+     * in parallel, printing the accuracy of each fold and their mean. The
+     * model is then trained on every image. The images are parsed on the
+     * shared pool too if the datasets are indexed.
+     * @param dataset_path - a string indicating the path of the dataset to load
+     * @param fold_count - the number of folds to split the images into
+     * @param confusion_csv_path - a string indicating the file path to save the
+     *                             sum of the confusion matrices of all folds to
+     * @param weights_path - a string indicating the path of a sidecar file
+     *                       with the weight of each image, empty for none
+     * @param is_balancing_classes - whether to give every class the same
+     *                               total weight in each model trained
+     * @return a bool indicating whether the model was trained, false if the
+     *         dataset can't be read or has fewer images than folds
+     */
+    bool CrossValidateModel(const std::string& dataset_path, size_t fold_count,
+                            const std::string& confusion_csv_path,
+                            const std::string& weights_path,
+                            bool is_balancing_classes);
+
     /**
      * Tests the model linearly or concurrently, depending on the request to 
      * multi-thread with the dataset provided. Saves the confusion matrix to the
@@ -95,13 +392,201 @@ class ExecutableLogic {
      *                             confusion matrix to     
      * @param is_test_multi_threaded - a bool indicating whether to use multiple 
      *                                 threads when testing the model
-     * @param is_printing_verbose - a bool indicating whether to print the index
-     *                              of the current image being tested
+     * @param is_printing_verbose - a bool indicating whether to print the
+     *                              progress of the test
+     * @param predictions_path - a string indicating the file path to save the
+     *                           top predictions of every image to, skipped if
+     *                           empty
+     * @param top_k - the number of predictions to save for each image
      */
     void TestModel(const std::string& dataset_path,
                    const std::string& confusion_csv_path,
-                   bool is_printing_verbose) const;
+                   bool is_printing_verbose,
+                   const std::string& predictions_path, size_t top_k) const;
     
+    /**
+     * Prunes copies of the model to each of kPruneReportFractions of its
+     * pixels and prints the accuracy of each on the test dataset.
+     * @param test_path - a string indicating the file path of the dataset to
+     *                    test the pruned models on
+     */
+    void ReportPruning(const std::string& test_path) const;
+
+    /**
+     * Calibrates a cascade classifier in front of the model, then compares it
+     * to the model on the test dataset, or on the calibration dataset if no
+     * test dataset is given. Prints the accuracy and images per second of
+     * both and the fraction of images the cascade escalated to the model.
+     * @param calibration_path - a string indicating the file path of the
+     *                           dataset to calibrate the cascade with
+     * @param tolerance - the most accuracy the cascade may lose
+     * @param test_path - a string indicating the file path of the dataset to
+     *                    compare the cascade and model on
+     */
+    void CascadeModel(const std::string& calibration_path, float tolerance,
+                      const std::string& test_path) const;
+
+    /**
+     * Classifies a stream of images in batches, writing a line for each image
+     * to stdout with its predicted label, followed by the score of every label
+     * in label order if requested, all separated by commas. Output is buffered
+     * and only flushed once every image has been classified.
+     * @param input_path - a string indicating the file path of the images to
+     *                     classify, or "-" to read them from stdin
+     * @param is_printing_scores - a bool indicating whether to write the score
+     *                             of every label after each prediction
+     * @param cache_size - the most images to cache the scores of, 0 to score
+     *                     every image
+     * @return a bool indicating whether every image was classified, false if
+     *         the input can't be read or an image is malformed or isn't the
+     *         model's size. Empty input has no images, so it is classified.
+     */
+    bool ClassifyImages(const std::string& input_path,
+                        bool is_printing_scores, size_t cache_size) const;
+
+    /**
+     * Rewrites a dataset in the binary dataset format, one image at a time.
+     * Given a sidecar weights file, the weighted binary format is written
+     * instead, with each image's weight stored after its label.
+     * @param input_path - a string indicating the file path of the dataset
+     * @param output_path - a string indicating the file to save it to
+     * @param weights_path - a string indicating the path of a sidecar file
+     *                       with the weight of each image, empty for none
+     */
+    void ConvertDataset(const std::string& input_path,
+                        const std::string& output_path,
+                        const std::string& weights_path) const;
+
+    /**
+     * Trains the model on a copy of the counts taken, with every class given
+     * the same total weight if requested. The counts themselves are kept as
+     * taken, so saved checkpoints can still be merged.
+     * @param is_balancing_classes - whether to give every class the same
+     *                               total weight
+     */
+    void TrainOnCounts(bool is_balancing_classes);
+
+    /**
+     * Reads the weight of the next image from a sidecar weights file, which
+     * holds one whitespace separated weight for each image.
+     * @param weights_file - the istream of the sidecar file
+     * @return a double indicating the weight of the next image
+     * @throws std::invalid_argument if the file has no weight left
+     */
+    static double ReadSampleWeight(std::istream& weights_file);
+
+    /**
+     * Reads the next chunk of images of a dataset and their weights, applying
+     * any sidecar weights. If the datasets are sampled, the images read are
+     * offered to the sampler and its sample so far is returned as the chunk.
+     * A reservoir sampler reads every image first, so its whole sample is
+     * returned as one chunk.
+     * @param image_stream - the ImageStream of the dataset
+     * @param weights_file - the istream of a sidecar weights file, or nullptr
+     * @param sampler - the dataset's copy of the sampler, kept across chunks
+     * @param chunk - a vector to fill with the images read
+     * @param weights - a vector to fill with the weight of each image read
+     * @return a bool indicating whether any image was read
+     * @throws std::invalid_argument if the dataset or weights are invalid
+     */
+    bool ReadWeightedChunk(ImageStream& image_stream,
+                           std::istream* weights_file,
+                           ImageSampler& sampler,
+                           std::vector<Image>& chunk,
+                           std::vector<double>& weights) const;
+
+    /**
+     * Reads the next chunk of images of an indexed dataset and their weights,
+     * applying any sidecar weights. The chunk has kTrainingChunkSize images
+     * for each thread of the shared pool, which parses them at once.
+     * @param dataset_path - a string indicating the file path of the dataset
+     * @param index - the DatasetIndex of the dataset
+     * @param weights_file - the istream of a sidecar weights file, or nullptr
+     * @param next_image - the index of the first image to read, which is
+     *                     moved past the images read
+     * @param chunk - a vector to fill with the images read
+     * @param weights - a vector to fill with the weight of each image read
+     * @return a bool indicating whether any image was read
+     * @throws std::invalid_argument if the dataset or weights are invalid
+     */
+    bool ReadIndexedChunk(const std::string& dataset_path,
+                          const DatasetIndex& index,
+                          std::istream* weights_file, size_t& next_image,
+                          std::vector<Image>& chunk,
+                          std::vector<double>& weights) const;
+
+    /**
+     * Loads or builds the index of a text dataset if the datasets are
+     * indexed. Sampled and cached datasets are read as a stream instead, so
+     * they are never indexed.
+     * @param dataset_path - a string indicating the file path of the dataset
+     * @param index - the DatasetIndex to fill
+     * @return a bool indicating whether the dataset should be read through
+     *         its index
+     * @throws std::invalid_argument if the dataset is not a valid text dataset
+     */
+    bool LoadIndex(const std::string& dataset_path, DatasetIndex& index) const;
+
+    /**
+     * Reads a dataset to test or calibrate with. Only its sample is read if
+     * the datasets are sampled. A text dataset is read from its snapshot if
+     * the datasets are cached, and is otherwise parsed in parallel with its
+     * index if the datasets are indexed.
+     * @param dataset_path - a string indicating the file path of the dataset
+     * @param dataset - the Dataset to add the images read to
+     * @return a bool indicating whether the dataset could be opened
+     * @throws std::invalid_argument if the dataset is not a valid dataset
+     */
+    bool LoadDataset(const std::string& dataset_path, Dataset& dataset) const;
+
+    /**
+     * Opens a dataset to read, mapping its cached snapshot instead if the
+     * datasets are cached, and decompressing it if it is compressed.
+     * @param dataset_path - a string indicating the file path of the dataset
+     * @param dataset_files - the files to open the dataset with, which must
+     *                        outlive the stream
+     * @return a pointer to the istream of the dataset, nullptr if the dataset
+     *         can't be opened
+     * @throws std::invalid_argument if a snapshot of an invalid dataset is
+     * written, or the dataset is compressed with an unsupported format
+     */
+    std::istream* OpenDataset(const std::string& dataset_path,
+                              DatasetFiles& dataset_files) const;
+
+    /**
+     * Prints the bandwidth a dataset was read at, if it was read ahead.
+     * @param dataset_files - the files the dataset was opened with
+     */
+    void ReportReadBandwidth(const DatasetFiles& dataset_files) const;
+
+    /**
+     * Prints how many images the threads of each NUMA node tested per second,
+     * if the threads are pinned.
+     * @param seconds - the number of seconds the test took
+     */
+    void ReportNodeThroughput(double seconds) const;
+
+    /**
+     * Prints the instructions per cycle of a phase and its cache and branch
+     * misses per image, if the counters are open. Events that weren't
+     * counted are printed as unavailable.
+     * @param phase_message - the message naming the phase
+     * @param image_count - the number of images the phase handled
+     * @param reading - the Reading of the counters over the phase
+     */
+    void ReportCounters(const std::string& phase_message, size_t image_count,
+                        const PerfCounters::Reading& reading) const;
+
+    /**
+     * Creates the sampler described by the sampling flags.
+     * @param flags - the ExecutionFlags parsed from the command line
+     * @return an ImageSampler, which keeps every image if no sampling flag
+     *         is set
+     * @throws std::invalid_argument if the sample quotas can't be parsed or
+     * are too large
+     */
+    static ImageSampler CreateSampler(const ExecutionFlags& flags);
+
     /**
      * Writes the confusion matrix provided to a CSV file.
      * @param save_path - a string indicating the file path to save to
@@ -6,6 +6,7 @@
 #define NAIVE_BAYES_IMAGE_H
 
 #include <iostream>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <map>
@@ -35,6 +36,9 @@ class Image {
     
     // The default label to use for an Image when one is not specified
     static constexpr char kDefaultLabel = '\0';
+
+    // The number of pixels stored in each byte of a packed image
+    static constexpr size_t kPackedPixelsPerByte = 4;
     
     Image();
   
@@ -81,6 +85,45 @@ class Image {
      */
     static Shading MapStringDigitEncodingToShading(const std::string& to_map);
 
+    /**
+     * Packs the pixels of this image row by row into 2 bits per pixel, with
+     * the first pixel of each byte in its lowest bits. The label is not packed.
+     * @return a vector of bytes holding the Shading encoding of every pixel
+     */
+    std::vector<uint8_t> Pack() const;
+
+    /**
+     * Creates an Image from pixels packed by Pack().
+     * @param packed - a pointer to GetPackedSize(height, width) packed bytes
+     * @param height - the number of rows of pixels in the image
+     * @param width - the number of columns of pixels in the image
+     * @param label - a char that indicates the label the image represents
+     * @return an Image with the unpacked pixels
+     * @throws std::invalid_argument if any pixel has no Shading encoding
+     */
+    static Image Unpack(const uint8_t* packed, size_t height, size_t width,
+                        char label);
+
+    /**
+     * Finds the number of bytes an image of the given size packs into.
+     * @param height - the number of rows of pixels in the image
+     * @param width - the number of columns of pixels in the image
+     * @return a size_t indicating the number of bytes of the packed image
+     */
+    static size_t GetPackedSize(size_t height, size_t width);
+
+    /**
+     * Hashes the size, label and packed pixels of an image with 64 bit FNV-1a,
+     * so images can be looked up without comparing every pixel.
+     * @param packed_pixels - the bytes of the image packed by Pack()
+     * @param height - the number of rows of pixels in the image
+     * @param width - the number of columns of pixels in the image
+     * @param label - a char that indicates the label the image represents
+     * @return a uint64_t hash that is equal for equal images
+     */
+    static uint64_t HashPacked(const std::vector<uint8_t>& packed_pixels,
+                               size_t height, size_t width, char label);
+
     /**
      * Overloaded extraction operator creates an Image from a stream of chars
      * by mapping each char to a Shading enum encoding and assigning a label.
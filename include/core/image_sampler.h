@@ -0,0 +1,170 @@
+#ifndef NAIVE_BAYES_IMAGE_SAMPLER_H
+#define NAIVE_BAYES_IMAGE_SAMPLER_H
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include "core/image_stream.h"
+
+namespace naivebayes {
+
+/**
+ * Draws a random sample of the images offered to it one at a time, so a
+ * subset of a dataset can be taken while streaming it without ever holding
+ * the whole dataset. A sampler keeps a uniform sample of a fixed size, a
+ * uniform sample of a fixed size for each label, or each image with a fixed
+ * probability. Samplers with the same seed offered the same images draw the
+ * same sample, and copying a sampler copies its random state.
+ */
+class ImageSampler {
+  public:
+    /**
+     * Creates a sampler that keeps every image offered to it.
+     */
+    ImageSampler();
+
+    /**
+     * Creates a sampler that keeps a uniform sample of the given size, using
+     * reservoir sampling. Fewer images are kept if fewer are offered.
+     * @param sample_size - the number of images to keep
+     * @param seed - the seed of the random number generator
+     * @return an ImageSampler of the given size
+     */
+    static ImageSampler Reservoir(size_t sample_size, uint64_t seed);
+
+    /**
+     * Creates a sampler that keeps a uniform sample of each label, with its
+     * own sample size for each label.
+     * @param label_quotas - the number of images to keep of each listed label
+     * @param default_quota - the number of images to keep of other labels
+     * @param seed - the seed of the random number generator
+     * @return an ImageSampler with the given quotas
+     */
+    static ImageSampler Stratified(const std::map<char, size_t>& label_quotas,
+                                   size_t default_quota, uint64_t seed);
+
+    /**
+     * Creates a sampler that keeps each image with the given probability, so
+     * about that fraction of the images is kept.
+     * @param fraction - the probability of keeping each image, from 0 to 1
+     * @param seed - the seed of the random number generator
+     * @return an ImageSampler that keeps the given fraction
+     * @throws std::invalid_argument if the fraction is not from 0 to 1
+     */
+    static ImageSampler Fraction(double fraction, uint64_t seed);
+
+    /**
+     * Getter for whether the sampler keeps every image offered to it.
+     * @return a bool that is true only for a default sampler
+     */
+    bool IsKeepingEveryImage() const;
+
+    /**
+     * Getter for whether the sampler decides to keep or drop each image when
+     * it is offered, never dropping an image it kept before. The sample of
+     * such a sampler can be taken a chunk at a time while streaming.
+     * @return a bool that is true for a default or fraction sampler
+     */
+    bool IsDecidingOnOffer() const;
+
+    /**
+     * Offers the next image of the dataset to the sampler, which may keep it
+     * and may drop an image it kept before.
+     * @param image - the Image to offer
+     * @param weight - the weight of the image, kept along with it
+     */
+    void Offer(const Image& image, double weight);
+
+    /**
+     * Offers every remaining image of a stream to the sampler.
+     * @param image_stream - the ImageStream to read the images from
+     * @throws std::invalid_argument if the stream is not a valid dataset
+     */
+    void OfferStream(ImageStream& image_stream);
+
+    /**
+     * Getter for the number of images offered so far.
+     * @return a size_t indicating the number of images offered
+     */
+    size_t GetOfferedCount() const;
+
+    /**
+     * Getter for the number of images taken from the sampler so far.
+     * @return a size_t indicating the number of images sampled
+     */
+    size_t GetSampledCount() const;
+
+    /**
+     * Moves the images kept so far out of the sampler, in the order they were
+     * offered in. The sampler keeps no images afterwards.
+     * @param images - a vector to fill with the sampled images
+     * @param weights - a vector to fill with the weight of each sampled image
+     * @return a size_t indicating the number of images sampled
+     */
+    size_t TakeSample(std::vector<Image>& images, std::vector<double>& weights);
+
+  private:
+    /**
+     * The ways a sampler can choose which images to keep.
+     */
+    enum class Mode {
+      kEveryImage,
+      kReservoir,
+      kStratified,
+      kFraction
+    };
+
+    /**
+     * An image kept by the sampler, with its position among the offered
+     * images so the sample can be put back in file order.
+     */
+    struct SampledImage {
+      size_t offer_index_;
+      Image image_;
+      double weight_;
+    };
+
+    /**
+     * The images kept of a single reservoir, and how many images were offered
+     * to it.
+     */
+    struct SampleReservoir {
+      size_t capacity_;
+      size_t offered_count_;
+      std::vector<SampledImage> images_;
+    };
+
+    // The key of the single reservoir of a sampler that is not stratified
+    static constexpr char kWholeSampleKey = '\0';
+
+    Mode mode_;
+    std::mt19937_64 generator_;
+    size_t offered_count_;
+    size_t sampled_count_;
+
+    // The reservoir of the whole sample, or of each label when stratified
+    std::map<char, SampleReservoir> reservoirs_;
+    std::map<char, size_t> label_quotas_;
+    size_t default_quota_;
+
+    double fraction_;
+    // The images kept by the modes without a reservoir
+    std::vector<SampledImage> kept_images_;
+
+    /**
+     * Creates a sampler of the given mode with its generator seeded.
+     */
+    ImageSampler(Mode mode, uint64_t seed);
+
+    /**
+     * Offers an image to a reservoir, replacing a random kept image with
+     * it once the reservoir is full so every image is kept with equal chance.
+     */
+    void OfferToReservoir(SampleReservoir& reservoir,
+                          const SampledImage& image);
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_IMAGE_SAMPLER_H
@@ -0,0 +1,146 @@
+#ifndef NAIVE_BAYES_IMAGE_STREAM_H
+#define NAIVE_BAYES_IMAGE_STREAM_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "core/image.h"
+
+namespace naivebayes {
+
+/**
+ * Reads labeled images one at a time from a stream in the dataset text format,
+ * so callers never have to hold more than the images they asked for. Like a
+ * Dataset, the dimension of every image is inferred from the first image.
+ * 
+ * Streams starting with kBinaryMagic are read in the binary dataset format
+ * instead: the magic, a little endian uint16 height and width, then for each
+ * image its label byte followed by its pixels packed by Image::Pack(). Streams
+ * starting with kWeightedBinaryMagic follow each label with the weight of the
+ * image as a little endian float32. Every other image has a weight of 1.
+ */
+class ImageStream {
+  public:
+    // The bytes a binary dataset starts with. The first byte is not printable,
+    // so it can't be mistaken for the label of a text dataset.
+    static const std::string kBinaryMagic;
+    // The bytes a binary dataset with a weight for each image starts with
+    static const std::string kWeightedBinaryMagic;
+
+    /**
+     * Creates an ImageStream that reads images from the given input stream.
+     * @param input - an istream in the dataset text or binary format, which
+     *                must outlive this object
+     */
+    explicit ImageStream(std::istream& input);
+
+    /**
+     * Reads the next image in the stream.
+     * @param image - the Image object to populate with the next image
+     * @return a bool indicating whether an image was read or the stream ended
+     * @throws std::invalid_argument if the stream is empty, if any image is
+     * missing a label, if any image is not the same size as the first image,
+     * if any pixel isn't a shading or if a binary stream ends partway through
+     * an image
+     */
+    bool ReadImage(Image& image);
+
+    /**
+     * Reads the next image in the stream and its weight.
+     * @param image - the Image object to populate with the next image
+     * @param weight - the double to set to the weight of the image
+     * @return a bool indicating whether an image was read or the stream ended
+     * @throws std::invalid_argument under the same conditions as ReadImage
+     */
+    bool ReadImage(Image& image, double& weight);
+
+    /**
+     * Reads up to max_images images from the stream, replacing the contents of
+     * the given chunk so its storage can be reused between chunks.
+     * @param chunk - a vector to fill with the images read
+     * @param max_images - the maximum number of images to read
+     * @return a size_t indicating the number of images read, 0 at end of stream
+     * @throws std::invalid_argument under the same conditions as ReadImage
+     */
+    size_t ReadChunk(std::vector<Image>& chunk, size_t max_images);
+
+    /**
+     * Reads up to max_images images from the stream and their weights,
+     * replacing the contents of the given chunk and weights.
+     * @param chunk - a vector to fill with the images read
+     * @param weights - a vector to fill with the weight of each image read
+     * @param max_images - the maximum number of images to read
+     * @return a size_t indicating the number of images read, 0 at end of stream
+     * @throws std::invalid_argument under the same conditions as ReadImage
+     */
+    size_t ReadChunk(std::vector<Image>& chunk, std::vector<double>& weights,
+                     size_t max_images);
+
+    /**
+     * Getter for the height of the images in the stream, 0 before any image
+     * has been read.
+     * @return a size_t indicating the number of rows in each image
+     */
+    size_t GetHeight() const;
+
+    /**
+     * Getter for the width of the images in the stream, 0 before any image
+     * has been read.
+     * @return a size_t indicating the number of columns in each image
+     */
+    size_t GetWidth() const;
+
+  private:
+    std::istream& input_;
+
+    size_t height_;
+    size_t width_;
+
+    // The first image is over once we read a line that is not image-wide, so
+    // that line is the label of the next image and has to be held onto
+    std::string pending_label_;
+    bool has_pending_label_;
+
+    bool is_binary_;
+    bool is_weighted_;
+    // Reused between binary images so reading one does not allocate for it
+    std::vector<uint8_t> packed_pixels_;
+
+    /**
+     * Reads the first image in the stream, inferring the dimension of all
+     * following images in the stream, as assumed in the project description.
+     * @param image - the Image object to populate with the first image
+     * @param weight - the double to set to the weight of the first image
+     * @return a bool indicating whether an image was read
+     * @throws std::invalid_argument if the first image is missing a label
+     */
+    bool ReadFirstImage(Image& image, double& weight);
+
+    /**
+     * Reads the header of a binary dataset, after its first byte was peeked.
+     * @throws std::invalid_argument if the header is not a valid header
+     */
+    void ReadBinaryHeader();
+
+    /**
+     * Reads the next image of a binary dataset.
+     * @param image - the Image object to populate with the next image
+     * @param weight - the double to set to the weight of the image
+     * @return a bool indicating whether an image was read or the stream ended
+     * @throws std::invalid_argument if the stream ends partway through an image
+     */
+    bool ReadBinaryImage(Image& image, double& weight);
+
+    /**
+     * Maps each char in a line of the image to its Shading encoding.
+     * @param line - a string of pixel chars
+     * @return a vector of Shading encodings for the row of pixels
+     * @throws std::invalid_argument if a char isn't a pixel shading
+     */
+    static std::vector<Shading> ParsePixelRow(const std::string& line);
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_IMAGE_STREAM_H
@@ -0,0 +1,76 @@
+#ifndef NAIVE_BAYES_IMAGE_WRITER_H
+#define NAIVE_BAYES_IMAGE_WRITER_H
+
+#include <iostream>
+#include <vector>
+
+#include "core/image.h"
+
+namespace naivebayes {
+
+/**
+ * Writes labeled images one at a time to a stream in the dataset text format
+ * or the binary dataset format, so that an ImageStream can read them back.
+ */
+class ImageWriter {
+  public:
+    /**
+     * The formats a dataset can be written in.
+     */
+    enum class Format {
+      kText,
+      kBinary,
+      // The binary format with the weight of each image after its label
+      kWeightedBinary
+    };
+
+    /**
+     * Creates an ImageWriter that writes images to the given output stream.
+     * @param output - the ostream to write to, which must outlive this object
+     * @param format - the Format to write the images in
+     */
+    ImageWriter(std::ostream& output, Format format);
+
+    /**
+     * Writes an image to the stream. The first image written sets the size
+     * of all images in the dataset.
+     * @param image - the Image to write
+     * @throws std::invalid_argument if the image is not the same size as the
+     * first image written
+     */
+    void Write(const Image& image);
+
+    /**
+     * Writes a weighted image to the stream. Only the weighted binary format
+     * stores weights, so other formats can only write a weight of 1.
+     * @param image - the Image to write
+     * @param weight - the weight of the image
+     * @throws std::invalid_argument if the image is not the same size as the
+     * first image written, or if the format can't store the weight
+     */
+    void Write(const Image& image, double weight);
+
+  private:
+    std::ostream& output_;
+    Format format_;
+
+    size_t height_;
+    size_t width_;
+
+    // Maps each Shading encoding to the char that stands for it in text
+    std::vector<char> shading_chars_;
+
+    /**
+     * Writes the magic and image size that start a binary dataset.
+     */
+    void WriteBinaryHeader();
+
+    /**
+     * Writes the weight of an image as a little endian float32.
+     */
+    void WriteWeight(float weight);
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_IMAGE_WRITER_H
@@ -0,0 +1,74 @@
+#ifndef NAIVE_BAYES_LIVE_CLASSIFIER_H
+#define NAIVE_BAYES_LIVE_CLASSIFIER_H
+
+#include <vector>
+
+#include "core/model.h"
+
+namespace naivebayes {
+
+/**
+ * Keeps a running likelihood score for every class of a Model so that an image
+ * which changes one pixel at a time can be re-classified in O(labels) per
+ * changed pixel instead of rescoring the entire image.
+ */
+class LiveClassifier {
+  public:
+    /**
+     * Creates a LiveClassifier that is not attached to any model. It will
+     * always predict the default label until it is replaced by one that is.
+     */
+    LiveClassifier();
+
+    /**
+     * Precomputes the scores of an all-white image of the given size for each
+     * class in the model and starts tracking from that baseline. The model
+     * must outlive this object and must not be retrained while it is in use.
+     * @param model - a trained or loaded Model to score the image with
+     * @param height - a size_t indicating the number of rows in the image
+     * @param width - a size_t indicating the number of columns in the image
+     */
+    LiveClassifier(const Model& model, size_t height, size_t width);
+
+    /**
+     * Updates the score of each class after a single pixel changed shading.
+     * @param row - the index of the row of the pixel that changed
+     * @param column - the index of the column of the pixel that changed
+     * @param previous - the Shading the pixel had before the change
+     * @param current - the Shading the pixel has after the change
+     */
+    void UpdatePixel(size_t row, size_t column,
+                     Shading previous, Shading current);
+
+    /**
+     * Resets the scores to those of the all-white baseline image.
+     */
+    void Reset();
+
+    /**
+     * Finds the label with the highest running score.
+     * @return a char indicating the predicted label of the tracked image
+     */
+    char GetPrediction() const;
+
+    /**
+     * Getter for the running scores, indexed by the model's label indices.
+     * @return a vector of floats containing the likelihood score of each class
+     */
+    const std::vector<float>& GetScores() const;
+
+  private:
+    const Model* model_;
+
+    // Maps a label index in the model back to its char label
+    std::vector<char> labels_;
+
+    // Scores of each class for an image with every pixel left unshaded
+    std::vector<float> baseline_scores_;
+
+    std::vector<float> scores_;
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_LIVE_CLASSIFIER_H
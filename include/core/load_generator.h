@@ -0,0 +1,73 @@
+#ifndef NAIVE_BAYES_LOAD_GENERATOR_H
+#define NAIVE_BAYES_LOAD_GENERATOR_H
+
+#include <string>
+#include <vector>
+
+#include "core/image.h"
+
+namespace naivebayes {
+
+/**
+ * Sends classification requests to a ClassifyServer from many connections at
+ * once and reports the throughput and latency percentiles it observed.
+ */
+class LoadGenerator {
+  public:
+    /**
+     * Creates a load generator that cycles through the given images.
+     * @param images - the Images to send, at least one
+     * @param connection_count - the number of connections sending at once
+     * @param request_count - the total number of requests to send
+     */
+    LoadGenerator(const std::vector<Image>& images, size_t connection_count,
+                  size_t request_count);
+
+    /**
+     * Sends every request and prints the requests per second and latency
+     * percentiles of the responses.
+     * @param socket_path - the file path of the server's Unix domain socket
+     * @return a 0 or 1, depending on whether every request got a response
+     */
+    int Run(const std::string& socket_path) const;
+
+    /**
+     * Finds a percentile of a sorted vector of latencies, using the nearest
+     * rank so the 100th percentile is the largest latency.
+     * @param sorted_latencies - the latencies, sorted in ascending order
+     * @param percentile - the percentile to find, between 0 and 100
+     * @return a double of the latency at that percentile, 0 if there are none
+     */
+    static double FindPercentile(const std::vector<double>& sorted_latencies,
+                                 double percentile);
+
+  private:
+    const std::vector<Image>& images_;
+    size_t connection_count_;
+    size_t request_count_;
+
+    // The percentiles of the request latencies to report
+    static const std::vector<double> kReportedPercentiles;
+
+    static const std::string kConnectFailedMessage;
+    static const std::string kRequestFailedMessage;
+    static const std::string kThroughputMessage;
+    static const std::string kLatencyMessage;
+
+    /**
+     * Sends requests one after another over one connection, recording the
+     * latency of each in microseconds.
+     * @param socket_path - the file path of the server's Unix domain socket
+     * @param first_request - the index of the first request to send
+     * @param request_count - the number of requests to send
+     * @param latencies - a vector to add the latency of each response to
+     * @return a bool indicating whether every request got a response
+     */
+    bool SendRequests(const std::string& socket_path, size_t first_request,
+                      size_t request_count,
+                      std::vector<double>& latencies) const;
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_LOAD_GENERATOR_H
@@ -0,0 +1,69 @@
+#ifndef NAIVE_BAYES_MAPPED_FILE_H
+#define NAIVE_BAYES_MAPPED_FILE_H
+
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+namespace naivebayes {
+
+/**
+ * Maps a whole file into memory read only and reads it as an istream, so the
+ * file is paged in by the kernel as it is read instead of being copied
+ * through a stream buffer.
+ */
+class MappedFile {
+  public:
+    /**
+     * Creates an object with no file mapped, whose stream is empty.
+     */
+    MappedFile();
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Maps a file, unmapping any file mapped before.
+     * @param path - the file path of the file to map
+     * @return a bool indicating whether the file could be mapped
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * Getter for a stream that reads the mapped file from its start.
+     * @return an istream of the mapped file
+     */
+    std::istream& GetStream();
+
+    /**
+     * Getter for the size of the mapped file.
+     * @return a size_t indicating the number of bytes mapped
+     */
+    size_t GetSize() const;
+
+  private:
+    /**
+     * A stream buffer that reads straight from a block of memory.
+     */
+    class MemoryBuffer : public std::streambuf {
+      public:
+        void Reset(char* data, size_t size);
+    };
+
+    void* data_;
+    size_t size_;
+
+    MemoryBuffer buffer_;
+    std::istream stream_;
+
+    /**
+     * Unmaps the mapped file, if any.
+     */
+    void Close();
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_MAPPED_FILE_H
@@ -7,7 +7,12 @@
 
 #include <nlohmann/json.hpp>
 
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+
 #include "core/dataset.h"
+#include "core/training_counts.h"
 
 namespace naivebayes {
 
@@ -20,6 +25,17 @@ struct Classification {
   std::map<Shading, std::vector<std::vector<float>>> shading_likelihoods_;
 };
 
+/**
+ * A label the model predicted for an image, with how strongly it predicted it.
+ */
+struct Prediction {
+  char label_;
+  // The log10 likelihood score of the label, as CalculateLikelihoodScore
+  float score_;
+  // The probability of the label given the image, normalized over all labels
+  float posterior_;
+};
+
 /**
  * Stores the conditional likelihoods for all features and the likelihoods of 
  * all classes based on the dataset provided when training this model
@@ -41,18 +57,48 @@ class Model {
      * @param dataset - a Dataset object containing encoded images from a stream 
      */
     void Train(const Dataset& dataset);
+
+    /**
+     * Trains the model with a dataset whose duplicate images were collapsed,
+     * counting each distinct image once for every time it was added.
+     * @param dataset - the DeduplicatedDataset to train on
+     */
+    void Train(const DeduplicatedDataset& dataset);
+
+    /**
+     * Trains the model with the class and pixel counts of a set of images, so
+     * the images themselves never have to be held in memory at once.
+     * Replaces any classes the model previously held.
+     * @param counts - a TrainingCounts object with at least one image counted
+     */
+    void Train(const TrainingCounts& counts);
     
     /**
      * Tests the model by classifying each image in the dataset sequentially 
      * and generating a confusion matrix displaying the count of predicted 
      * labels with respect to the count of actual labels.
      * @param dataset - a Dataset object containing Images & their actual labels
-     * @param is_printing_verbose - indicates whether to notify the index of the
-     *                              current test image every increment
+     * @param is_printing_verbose - indicates whether to print the progress of
+     *                              the test from a background thread
+     * @param progress_output - the ostream to print the progress to
+     * @return 2D-vector representing a confusion matrix generated from testing
+     */
+    std::vector<std::vector<size_t>> Test(
+        const Dataset& dataset, bool is_printing_verbose,
+        std::ostream* progress_output = &std::cout) const;
+    
+    /**
+     * Same as Test, but scores each group of images as a batch and writes a
+     * csv line to the given stream for every image with its actual label and
+     * its top k predictions, each as a label, log score and posterior.
+     * @param dataset - a Dataset object containing Images & their actual labels
+     * @param k - the number of predictions to write for each image, at least 1
+     * @param predictions_output - an ostream to write the predictions to
      * @return 2D-vector representing a confusion matrix generated from testing
      */
-    std::vector<std::vector<size_t>> Test(const Dataset& dataset, 
-                                          bool is_printing_verbose) const;
+    std::vector<std::vector<size_t>> Test(
+        const Dataset& dataset, size_t k,
+        std::ostream& predictions_output) const;
     
     /**
      * Classify the given Image by comparing its features to the model.
@@ -60,6 +106,55 @@ class Model {
      * @return a char indicating the predicted label of the Image
      */
     char Classify(const Image& image) const;
+
+    /**
+     * Same as Classify, but reads the image straight from a buffer of Shading
+     * encodings, one byte per pixel, without building an Image. Never
+     * allocates memory unless it throws.
+     * @param codes - a pointer to the encoding of the first pixel
+     * @param height - the number of rows of pixels, the model's image height
+     * @param width - the number of columns of pixels, the model's image width
+     * @param stride - the number of bytes from the start of one row to the
+     *                 start of the next, at least the width
+     * @return a char indicating the predicted label of the image
+     * @throws std::invalid_argument if the size doesn't match the model, the
+     *         stride is smaller than the width or a pixel has no Shading
+     */
+    char Classify(const uint8_t* codes, size_t height, size_t width,
+                  size_t stride) const;
+
+    /**
+     * Same as Classify, but reads the image straight from pixels packed by
+     * Image::Pack(), without unpacking them into an Image. Never allocates
+     * memory unless it throws.
+     * @param packed - a pointer to Image::GetPackedSize(height, width) bytes
+     * @param height - the number of rows of pixels, the model's image height
+     * @param width - the number of columns of pixels, the model's image width
+     * @return a char indicating the predicted label of the image
+     * @throws std::invalid_argument if the size doesn't match the model or a
+     *         pixel has no Shading
+     */
+    char ClassifyPacked(const uint8_t* packed, size_t height,
+                        size_t width) const;
+
+    /**
+     * Finds the k most likely labels of the given Image. Posteriors are
+     * normalized with log-sum-exp over every label, so the gap between the
+     * first two predictions can be used as a confidence margin.
+     * @param image - an Image object to classify
+     * @param k - the number of predictions to return, capped by label count
+     * @return a vector of Predictions ordered from most to least likely
+     */
+    std::vector<Prediction> ClassifyTopK(const Image& image, size_t k) const;
+
+    /**
+     * Same as ClassifyTopK, but scores the images together as a batch.
+     * @param images - a vector of Images to classify, all of the model's size
+     * @param k - the number of predictions to return for each image
+     * @return a vector of the top k Predictions of each image, in image order
+     */
+    std::vector<std::vector<Prediction>> ClassifyTopK(
+        const std::vector<Image>& images, size_t k) const;
     
     /**
      * Calculates the likelihood of an Image being labeled by the given label.
@@ -68,6 +163,16 @@ class Model {
      * @return a float indicating the likelihood score of the image and label
      */
     float CalculateLikelihoodScore(char label, const Image& image) const;
+
+    /**
+     * Calculates the likelihood score of every class for a batch of images.
+     * Scoring one class at a time for the whole batch keeps that class's
+     * likelihoods in cache, so this is faster than scoring image by image.
+     * @param images - a vector of Images to score, all of the model's size
+     * @return a 2D-vector of scores indexed by [image][label index]
+     */
+    std::vector<std::vector<float>> CalculateLikelihoodScores(
+        const std::vector<Image>& images) const;
     
     /**
      * Getter for the likelihood of the occurrence of a class.
@@ -85,14 +190,83 @@ class Model {
      * @param column - size_t indicating the x-axis index of feature to retrieve
      * @return a float indicating the likelihood of the specified feature
      */
-    float GetFeatureLikelihood(char class_label, Shading shading, 
+    float GetFeatureLikelihood(char class_label, Shading shading,
                                size_t row, size_t column) const;
-    
+
+    /**
+     * Same as GetFeatureLikelihood, but looks the class up by its index in the
+     * model instead of its label so it is cheap enough to call per pixel.
+     * @param label_index - the index of the class, from GetLabelIndices()
+     * @param shading - a Shading enum corresponding to a likelihood to retrieve
+     * @param row - size_t indicating the y-axis index of a feature to retrieve
+     * @param column - size_t indicating the x-axis index of feature to retrieve
+     * @return a float indicating the likelihood of the specified feature
+     */
+    float GetIndexedFeatureLikelihood(size_t label_index, Shading shading,
+                                      size_t row, size_t column) const;
+
+    /**
+     * Ranks every pixel by how well it tells the classes apart, measured by
+     * the variance of its log likelihoods across classes, summed over each
+     * Shading. Pixels every class shades alike barely change any prediction.
+     * @return a vector of pixel indices, row * width + column, from the most
+     * to the least discriminative
+     */
+    std::vector<size_t> RankPixels() const;
+
+    /**
+     * Keeps only the given number of most discriminative pixels, as ranked by
+     * RankPixels, so classifying scores only those. Pruned pixels have their
+     * likelihoods zeroed for every class, which scores the same as skipping
+     * them, so a saved pruned model stays pruned when it is loaded.
+     * @param kept_pixel_count - the number of pixels to keep
+     */
+    void Prune(size_t kept_pixel_count);
+
+    /**
+     * Same as Prune, but keeps every pixel whose variance of log likelihoods
+     * across classes is at least the given threshold.
+     * @param min_variance - the smallest variance of a pixel to keep
+     */
+    void PruneBelow(float min_variance);
+
+    /**
+     * Getter for the pixels the model scores when classifying.
+     * @return a vector of pixel indices, row * width + column, in row order
+     */
+    std::vector<size_t> GetRetainedPixels() const;
+
     /**
      * Getter for a map of char labels and their indices in the model.
      * @return a map from each char label to its index in the confusion matrix
      */
     const std::map<char, size_t>& GetLabelIndices() const;
+
+    /**
+     * Getter for the labels of the model ordered by their indices.
+     * @return a vector of char where the label with index i is at position i
+     */
+    std::vector<char> GetLabels() const;
+
+    /**
+     * Getter for the generation of the model, which changes whenever it is
+     * trained, loaded or pruned. No two versions of any models in a process
+     * share a generation, so it tells caches when their results are stale.
+     * @return a uint64_t identifying the current version of the model
+     */
+    uint64_t GetGeneration() const;
+
+    /**
+     * Getter for the height of the images the model is built for.
+     * @return a size_t indicating the number of rows, 0 if the model is empty
+     */
+    size_t GetImageHeight() const;
+
+    /**
+     * Getter for the width of the images the model is built for.
+     * @return a size_t indicating the number of columns, 0 if the model is empty
+     */
+    size_t GetImageWidth() const;
     
     /**
      * Calculates the accuracy of the model by tallying the number of correct
@@ -133,11 +307,20 @@ class Model {
     
     // maps a char label to an index used in classification
     std::map<char, size_t> label_indices_;
+
+    // The row and column of each pixel scored in classification, all of
+    // them unless pruned. Kept apart so scoring needs no division.
+    std::vector<std::pair<size_t, size_t>> retained_pixels_;
     
     float laplace_smoothing_;
 
-    // Determines how often to list the current index during a test
-    static constexpr size_t kLinearTestingFeedbackRate = 100;
+    uint64_t generation_;
+
+    // The generation to give the next changed model, shared by all models
+    static std::atomic<uint64_t> next_generation_;
+
+    // The most images each task of the thread pool scores at once
+    static constexpr size_t kScoringGrainSize = 256;
     
     // The spacing schema to use when generating the serialized model
     static constexpr size_t kJsonSchemaSpacing = 2;
@@ -147,7 +330,61 @@ class Model {
     static const std::string kJsonSchemaClassKey; 
     static const std::string kJsonSchemaShadingKey; 
     
-    static const std::string kModelTestingIndexFeedback;
+    // The phase the progress of a verbose test is printed as
+    static const std::string kTestingProgressPhase;
+
+    // Column names of the predictions file written while testing
+    static const std::string kPredictionsActualColumn;
+    static const std::string kPredictionsLabelColumn;
+    static const std::string kPredictionsScoreColumn;
+    static const std::string kPredictionsPosteriorColumn;
+
+    /**
+     * Calculates the variance of the log likelihoods of each pixel across
+     * classes, summed over each Shading.
+     * @return a vector of variances indexed by row * width + column
+     */
+    std::vector<float> CalculatePixelVariances() const;
+
+    /**
+     * Zeroes the likelihoods of every pixel not in the given set and makes
+     * the set the retained pixels.
+     * @param is_kept - a vector indicating whether to keep each pixel
+     */
+    void RetainPixels(const std::vector<bool>& is_kept);
+
+    /**
+     * Finds the retained pixels of a trained or loaded model, which are all
+     * pixels except those pruned to a likelihood of zero for every class.
+     * Sets the retained_pixels_ vector.
+     */
+    void SetRetainedPixels();
+
+    /**
+     * Ranks the scores of every label of one image into its top k Predictions.
+     * @param scores - the score of each label, indexed by label index
+     * @param k - the number of predictions to return
+     * @return a vector of Predictions ordered from most to least likely
+     */
+    std::vector<Prediction> RankScores(const std::vector<float>& scores,
+                                       size_t k) const;
+
+    /**
+     * Classifies an image whose pixels are read through a function, scoring
+     * exactly as Classify(const Image&) does without allocating memory.
+     * @param get_encoding - called with a row and column, returns the Shading
+     *                       encoding of that pixel as a size_t
+     * @return a char indicating the predicted label of the image
+     * @throws std::invalid_argument if a pixel has no Shading
+     */
+    template <typename EncodingGetter>
+    char ClassifyEncodings(const EncodingGetter& get_encoding) const;
+
+    /**
+     * Checks that an image of the given size can be classified by the model.
+     * @throws std::invalid_argument if the size doesn't match the model
+     */
+    void CheckImageSize(size_t height, size_t width) const;
 
     /**
      * Converts the classification map into a 4D-vector of feature probabilities
@@ -163,39 +400,15 @@ class Model {
     
     /**
      * Calculates the conditional likelihood of a Shading appearing in an image
-     * for all pixels in a provided vector of images with the same label.
-     * @param class_group - a vector if Images with the same label
-     * @param label_count - the total number of labels in the dataset
-     * @return a map of pairs of Shading and size_t indicating the likelihood
+     * for all pixels from the counts of all images with the same label.
+     * @param counts - the counts of the images the model is trained on
+     * @param class_label - the label of the class to calculate likelihoods for
+     * @return a map of pairs of Shading and 2D-vector indicating the likelihood
      * of each Shading feature appearing for this group with the same label
      */
     std::map<Shading, std::vector<std::vector<float>>>
     CalculateFeatureLikelihoods(
-        const std::vector<Image>& class_group, size_t label_count) const;
-
-    /**
-     * Creates an empty map to hold the likelihoods of each Shading type in all
-     * pixel positions for the image size this model is built for.
-     * @param row_count - a size_t indicating the number of rows of pixels in 
-     *                    images the model built for
-     * @param column_count - a size_t indicating the number of columns of pixels 
-     *                       in images the model built for
-     * @return an map of Shading and 2D-vector pairs filled with zeros
-     */
-    static std::map<Shading, std::vector<std::vector<float>>>
-    InitializeEmptyFeatureMap(size_t row_count, size_t column_count);
-
-    /**
-     * Finds the total count of each type of shading in all images in the given
-     * vector of Images at the specified row and column in the image.
-     * @param group - a vector of Images to find shading counts for
-     * @param row - a size_t indicating the Image row index to analyze
-     * @param column - a size_t indicating the Image column index to analyze
-     * @return a map of pairs of Shading and size_t indicating the count of each
-     * type of shading for all images in the given group of images
-     */
-    static std::map<Shading, size_t> CountPixelShadings(
-        const std::vector<Image>& group, size_t row, size_t column);
+        const TrainingCounts& counts, char class_label) const;
 };
 
 } // namespace naivebayes
@@ -0,0 +1,46 @@
+#ifndef NAIVE_BAYES_MODEL_REPLICAS_H
+#define NAIVE_BAYES_MODEL_REPLICAS_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "core/model.h"
+
+namespace naivebayes {
+
+/**
+ * A copy of a read-only Model for each NUMA node, so threads score images
+ * with likelihoods held in the memory of their own node. Each copy is made
+ * by the first thread of its node to ask for it, and the OS places memory on
+ * the node of the thread that first writes it, so no NUMA library is needed.
+ */
+class ModelReplicas {
+  public:
+    /**
+     * Creates an empty replica slot for each node.
+     * @param model - the Model to copy, which must outlive the replicas
+     * @param node_count - the number of NUMA nodes
+     */
+    ModelReplicas(const Model& model, size_t node_count);
+
+    ModelReplicas(const ModelReplicas&) = delete;
+    ModelReplicas& operator=(const ModelReplicas&) = delete;
+
+    /**
+     * Getter for the replica of a node, copying the model on the calling
+     * thread if the node has no replica yet.
+     * @param node - the index of the node, usually ThreadPool::GetCurrentNode
+     * @return a reference to the Model of the node
+     */
+    const Model& Get(size_t node);
+
+  private:
+    const Model& model_;
+    std::vector<std::unique_ptr<Model>> replicas_;
+    std::mutex mutex_;
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_MODEL_REPLICAS_H
@@ -0,0 +1,73 @@
+#ifndef NAIVE_BAYES_NUMA_TOPOLOGY_H
+#define NAIVE_BAYES_NUMA_TOPOLOGY_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace naivebayes {
+
+/**
+ * The NUMA nodes of the machine and the cores of each. On Linux the nodes
+ * are read from sysfs, and anywhere else, or if sysfs can't be read, every
+ * core is on a single node.
+ */
+class NumaTopology {
+  public:
+    /**
+     * Creates a topology of a single node with the given number of cores.
+     * @param core_count - the number of cores, numbered from 0
+     */
+    explicit NumaTopology(size_t core_count);
+
+    /**
+     * Creates a topology with the given cores on each node.
+     * @param node_cores - the core numbers of each node, which must not be
+     *                     empty
+     */
+    explicit NumaTopology(const std::vector<std::vector<size_t>>& node_cores);
+
+    /**
+     * Detects the topology of this machine.
+     * @return the NumaTopology of the machine
+     */
+    static NumaTopology Detect();
+
+    /**
+     * Parses a list of cores in the sysfs format, like "0-3,8,10-11".
+     * @param cpu_list - the list to parse
+     * @return a vector of the core numbers in the list
+     * @throws std::invalid_argument if the list is malformed
+     */
+    static std::vector<size_t> ParseCpuList(const std::string& cpu_list);
+
+    /**
+     * Getter for the number of nodes.
+     * @return a size_t indicating the number of nodes, at least 1
+     */
+    size_t GetNodeCount() const;
+
+    /**
+     * Getter for the cores of a node.
+     * @param node - the index of the node
+     * @return a vector of the core numbers of the node
+     */
+    const std::vector<size_t>& GetNodeCores(size_t node) const;
+
+    /**
+     * Orders every core so consecutive cores are on different nodes, so
+     * threads pinned in this order are spread evenly over the nodes.
+     * @return a vector of pairs of a core number and the index of its node
+     */
+    std::vector<std::pair<size_t, size_t>> InterleaveCores() const;
+
+  private:
+    std::vector<std::vector<size_t>> node_cores_;
+
+    // Where the cores of each node are listed on Linux
+    static const std::string kSysfsNodeDirectory;
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_NUMA_TOPOLOGY_H
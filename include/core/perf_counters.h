@@ -0,0 +1,95 @@
+#ifndef NAIVE_BAYES_PERF_COUNTERS_H
+#define NAIVE_BAYES_PERF_COUNTERS_H
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace naivebayes {
+
+/**
+ * Hardware performance counters of this process, read with Linux
+ * perf_event_open. Each event is counted in user space only, on the thread
+ * that opened the counters and on every thread it starts afterwards, so the
+ * counters must be opened before the workers of the thread pool are started.
+ * Any event the kernel or the CPU can't count is left out, and on other
+ * platforms no event is counted.
+ */
+class PerfCounters {
+  public:
+    /**
+     * The events that are counted, which also index a Reading.
+     */
+    enum Event : size_t {
+      kCycles,
+      kInstructions,
+      kL1Misses,
+      kLlcMisses,
+      kBranchMisses,
+      kEventCount
+    };
+
+    /**
+     * The counts of every event between a call to Start and Stop, scaled up
+     * if the kernel could only count an event part of the time.
+     */
+    struct Reading {
+      std::array<double, kEventCount> counts_;
+      std::array<bool, kEventCount> is_counted_;
+    };
+
+    /**
+     * Creates an object with no counters open, which counts nothing.
+     */
+    PerfCounters();
+
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    PerfCounters(PerfCounters&& other);
+
+    /**
+     * Opens a counter for every event that can be counted, stopped.
+     * @return a bool indicating whether any event can be counted
+     */
+    bool Open();
+
+    /**
+     * Getter for whether any event can be counted.
+     * @return a bool indicating whether Open last succeeded
+     */
+    bool IsOpen() const;
+
+    /**
+     * Getter for why no event can be counted.
+     * @return a string describing why Open failed, empty if it succeeded
+     */
+    const std::string& GetError() const;
+
+    /**
+     * Resets every counter to 0 and starts counting.
+     */
+    void Start() const;
+
+    /**
+     * Stops counting and reads every counter.
+     * @return the Reading of every event since Start was called
+     */
+    Reading Stop() const;
+
+  private:
+    // The counter of each event, -1 if it can't be counted
+    std::vector<int> file_descriptors_;
+    std::string error_;
+
+    /**
+     * Closes every counter.
+     */
+    void Close();
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_PERF_COUNTERS_H
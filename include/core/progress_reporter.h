@@ -0,0 +1,94 @@
+#ifndef NAIVE_BAYES_PROGRESS_REPORTER_H
+#define NAIVE_BAYES_PROGRESS_REPORTER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace naivebayes {
+
+/**
+ * Prints the progress of a phase, like testing or parsing, from a thread of
+ * its own. The threads doing the work only add to an atomic count of the
+ * images they handled, and the reporter samples it every interval to print
+ * the images per second, and the percent done and time left if the total is
+ * known. Work never waits on the output, and progress is reported the same
+ * however many threads add to it.
+ */
+class ProgressReporter {
+  public:
+    // How often progress is printed unless another interval is given
+    static const std::chrono::milliseconds kDefaultInterval;
+
+    /**
+     * Starts reporting the progress of a phase.
+     * @param output - the stream to print progress to
+     * @param phase - the name of the phase, printed before each report
+     * @param total_count - the number of images the phase will handle, 0 if
+     *                      it isn't known
+     * @param interval - how often to print progress
+     */
+    ProgressReporter(std::ostream& output, const std::string& phase,
+                     size_t total_count,
+                     std::chrono::milliseconds interval = kDefaultInterval);
+
+    /**
+     * Stops reporting, if not already stopped.
+     */
+    ~ProgressReporter();
+
+    ProgressReporter(const ProgressReporter&) = delete;
+    ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+    /**
+     * Counts images the phase handled. Can be called from any thread.
+     * @param count - the number of images handled
+     */
+    void Add(size_t count);
+
+    /**
+     * Getter for the number of images handled so far.
+     * @return a size_t indicating the number of images handled
+     */
+    size_t GetCount() const;
+
+    /**
+     * Stops reporting and prints the progress a last time, so even a phase
+     * shorter than the interval is reported once.
+     */
+    void Stop();
+
+  private:
+    std::ostream& output_;
+    std::string phase_;
+    size_t total_count_;
+    std::chrono::milliseconds interval_;
+    std::chrono::steady_clock::time_point start_time_;
+
+    // Only ever added to with relaxed ordering, so counting costs no fence
+    std::atomic<size_t> count_;
+
+    std::thread reporter_;
+    std::mutex mutex_;
+    std::condition_variable stopped_;
+    bool is_stopping_;
+
+    /**
+     * Prints the progress every interval until stopped. Runs on the
+     * reporter thread.
+     */
+    void Report();
+
+    /**
+     * Prints the progress so far on a single line.
+     */
+    void Print() const;
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_PROGRESS_REPORTER_H
@@ -0,0 +1,142 @@
+#ifndef NAIVE_BAYES_READ_AHEAD_FILE_H
+#define NAIVE_BAYES_READ_AHEAD_FILE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace naivebayes {
+
+/**
+ * Reads a file as an istream while a background thread reads ahead of it.
+ * The thread fills a ring of kBufferCount buffers of kBufferSize bytes with
+ * large reads at offsets aligned to kBufferSize, and the stream parses the
+ * filled buffers in order, so waiting on the disk overlaps with parsing. The
+ * kernel is also told the file is read sequentially, so it reads ahead of
+ * the thread too.
+ */
+class ReadAheadFile {
+  public:
+    /**
+     * Creates an object with no file open, whose stream is empty.
+     */
+    ReadAheadFile();
+
+    ~ReadAheadFile();
+
+    ReadAheadFile(const ReadAheadFile&) = delete;
+    ReadAheadFile& operator=(const ReadAheadFile&) = delete;
+
+    /**
+     * Opens a file and starts reading it ahead, closing any file opened
+     * before.
+     * @param path - the file path of the file to read
+     * @return a bool indicating whether the file could be opened
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * Getter for whether a file is open.
+     * @return a bool indicating whether Open last succeeded
+     */
+    bool IsOpen() const;
+
+    /**
+     * Getter for a stream of the file. Reading it throws std::runtime_error
+     * if the file can't be read.
+     * @return an istream of the file
+     */
+    std::istream& GetStream();
+
+    /**
+     * Getter for the number of bytes read from the file so far.
+     * @return a uint64_t indicating the number of bytes read
+     */
+    uint64_t GetReadBytes() const;
+
+    /**
+     * Getter for the time spent reading, from opening the file until its end
+     * was read, or until now if it is still being read.
+     * @return a double indicating the seconds spent reading
+     */
+    double GetReadSeconds() const;
+
+  private:
+    /**
+     * A stream buffer that reads the filled buffers of the ring in order.
+     */
+    class RingBuffer : public std::streambuf {
+      public:
+        explicit RingBuffer(ReadAheadFile& file);
+        void Reset();
+
+      protected:
+        int_type underflow() override;
+
+      private:
+        ReadAheadFile& file_;
+    };
+
+    int file_descriptor_;
+
+    // The ring of buffers, which the reader thread fills in order and the
+    // stream reads in the same order
+    std::vector<std::string> buffers_;
+    std::vector<size_t> filled_sizes_;
+    size_t filled_count_;
+    size_t read_index_;
+    bool is_holding_buffer_;
+
+    std::thread reader_;
+    mutable std::mutex mutex_;
+    std::condition_variable buffer_filled_;
+    std::condition_variable buffer_released_;
+    bool is_finished_;
+    bool is_stopping_;
+    std::exception_ptr error_;
+
+    uint64_t read_bytes_;
+    std::chrono::steady_clock::time_point start_time_;
+    std::chrono::steady_clock::time_point end_time_;
+
+    RingBuffer ring_buffer_;
+    std::istream stream_;
+
+    // The number of bytes read at once
+    static constexpr size_t kBufferSize = 4 << 20;
+
+    // The number of buffers in the ring
+    static constexpr size_t kBufferCount = 4;
+
+    /**
+     * Stops reading and closes the file, if any.
+     */
+    void Close();
+
+    /**
+     * Fills the buffers of the ring in order until the end of the file. Runs
+     * on the reader thread.
+     */
+    void ReadFile();
+
+    /**
+     * Releases the buffer the stream was reading, then takes the next filled
+     * buffer, waiting for it to be filled.
+     * @param data - set to the bytes of the buffer taken
+     * @param size - set to the number of bytes in the buffer taken
+     * @return a bool indicating whether there was a buffer left
+     * @throws std::runtime_error if the file can't be read
+     */
+    bool TakeBuffer(char*& data, size_t& size);
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_READ_AHEAD_FILE_H
@@ -0,0 +1,202 @@
+#ifndef NAIVE_BAYES_THREAD_POOL_H
+#define NAIVE_BAYES_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace naivebayes {
+
+/**
+ * A work stealing pool of threads that every parallel part of training,
+ * testing, parsing and classifying shares, instead of each starting threads
+ * of its own. Each worker has a deque of tasks: it takes the newest task of
+ * its own deque, and once that is empty it steals the oldest task of another
+ * worker, so uneven tasks keep every core busy. The thread that starts the
+ * work runs tasks too until all of its tasks are done, so work can be
+ * started from inside a task without the pool running out of threads.
+ * Workers can be pinned to cores spread evenly over the NUMA nodes, and the
+ * pool counts how many indices the tasks on each node ran.
+ */
+class ThreadPool {
+  public:
+    /**
+     * Where the workers run and what data their work may copy.
+     */
+    enum class Placement {
+      // Workers run on whichever cores the OS picks
+      kAnywhere,
+      // Each worker is pinned to a core, spread evenly over the NUMA nodes
+      kPinned,
+      // Pinned, and read-only data like a model is copied onto every node
+      kReplicated
+    };
+
+    /**
+     * Creates a pool that runs work on the given number of threads, counting
+     * the thread that starts the work.
+     * @param thread_count - the number of threads, 0 for one per core
+     */
+    explicit ThreadPool(size_t thread_count);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Getter for the pool shared by the whole program, which has one thread
+     * per core until SetThreadCount is called on it.
+     * @return a reference to the shared ThreadPool
+     */
+    static ThreadPool& GetShared();
+
+    /**
+     * Finds the number of cores of the machine.
+     * @return a size_t indicating the number of cores, at least 1
+     */
+    static size_t GetCoreCount();
+
+    /**
+     * Getter for the number of threads work is run on, counting the thread
+     * that starts it.
+     * @return a size_t indicating the number of threads
+     */
+    size_t GetThreadCount() const;
+
+    /**
+     * Replaces the worker threads so work runs on the given number of
+     * threads. It must not be called while any work is running.
+     * @param thread_count - the number of threads, 0 for one per core
+     * @param placement - the Placement of the new workers
+     */
+    void SetThreadCount(size_t thread_count,
+                        Placement placement = Placement::kAnywhere);
+
+    /**
+     * Getter for the placement of the workers.
+     * @return the Placement the workers were started with
+     */
+    Placement GetPlacement() const;
+
+    /**
+     * Getter for the number of NUMA nodes the workers are spread over.
+     * @return a size_t indicating the number of nodes, 1 unless pinned
+     */
+    size_t GetNodeCount() const;
+
+    /**
+     * Getter for the NUMA node of the calling thread. Only pinned workers
+     * know their node, so any other thread is counted as on node 0.
+     * @return a size_t indicating the index of the node
+     */
+    static size_t GetCurrentNode();
+
+    /**
+     * Getter for the number of indices the tasks of each node ran since the
+     * counts were last reset.
+     * @return a vector of the count of each node
+     */
+    std::vector<size_t> GetNodeIndexCounts() const;
+
+    /**
+     * Resets the number of indices each node ran to 0.
+     */
+    void ResetNodeIndexCounts();
+
+    /**
+     * Runs the body over every index of a range, split into subranges of at
+     * most grain_size indices that are run as tasks on the pool, and waits
+     * for all of them. A range no bigger than a grain is run on the calling
+     * thread.
+     * @param begin - the first index of the range
+     * @param end - the index past the last index of the range
+     * @param grain_size - the most indices per task, 0 to pick a size that
+     *                     gives each thread several tasks
+     * @param body - called with the first and past the last index of each
+     *               subrange, on any thread
+     * @throws the first exception thrown by the body, once every task is done
+     */
+    void ParallelFor(size_t begin, size_t end, size_t grain_size,
+                     const std::function<void(size_t, size_t)>& body);
+
+  private:
+    /**
+     * The tasks queued on one worker. The owner takes tasks from the back,
+     * and other threads steal them from the front.
+     */
+    struct WorkerQueue {
+      std::mutex mutex_;
+      std::deque<std::function<void()>> tasks_;
+    };
+
+    std::vector<std::thread> workers_;
+    std::deque<WorkerQueue> queues_;
+    size_t thread_count_;
+    Placement placement_;
+    size_t node_count_;
+
+    // The number of indices the tasks of each node ran
+    std::vector<std::atomic<size_t>> node_index_counts_;
+
+    // Idle workers sleep until a task is queued
+    std::mutex sleep_mutex_;
+    std::condition_variable task_queued_;
+    std::atomic<size_t> queued_count_;
+    bool is_stopping_;
+
+    // The queue the next task is pushed on, so tasks are spread evenly
+    std::atomic<size_t> next_queue_;
+
+    // The number of tasks each thread is given by a grain size of 0
+    static constexpr size_t kTasksPerThread = 8;
+
+    /**
+     * Starts a worker for every thread but the one that starts the work,
+     * pinning each to the next core of the interleaved NUMA cores if pinned.
+     */
+    void StartWorkers(size_t thread_count, Placement placement);
+
+    /**
+     * Stops and joins every worker.
+     */
+    void StopWorkers();
+
+    /**
+     * Takes and runs tasks until the pool stops. Runs on each worker.
+     * @param worker_index - the index of the worker's own queue
+     * @param core - the core to pin the worker to, if pinned
+     * @param node - the NUMA node of the core
+     */
+    void RunWorker(size_t worker_index, size_t core, size_t node);
+
+    /**
+     * Runs the body over a subrange and counts the indices for the node of
+     * the calling thread.
+     */
+    void RunRange(size_t first, size_t last,
+                  const std::function<void(size_t, size_t)>& body);
+
+    /**
+     * Queues a task on the next worker queue and wakes a worker.
+     */
+    void PushTask(std::function<void()> task);
+
+    /**
+     * Takes a task, from the back of the given queue first and then from the
+     * front of every other queue.
+     * @param worker_index - the index of the caller's own queue, or the
+     *                       number of queues if it has none
+     * @param task - set to the task taken
+     * @return a bool indicating whether a task was taken
+     */
+    bool TakeTask(size_t worker_index, std::function<void()>& task);
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_THREAD_POOL_H
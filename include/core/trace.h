@@ -0,0 +1,98 @@
+#ifndef NAIVE_BAYES_TRACE_H
+#define NAIVE_BAYES_TRACE_H
+
+#include <chrono>
+#include <iostream>
+
+namespace naivebayes {
+
+/**
+ * Collects the spans of time each thread spent in each phase of the
+ * pipeline, and writes them in the Chrome trace event format, which
+ * chrome://tracing and Perfetto can show as a timeline per thread. Each
+ * thread appends its spans to a buffer of its own, so recording never takes
+ * a lock, and nothing is recorded unless tracing is enabled.
+ *
+ * Since recording takes no lock, GetSpanCount(), Clear() and Write() don't
+ * synchronize with the threads appending spans. Only call them while no span
+ * is being recorded on any thread: every TraceSpan has been destroyed, and
+ * none is created until they return. Disabling tracing is not enough, since
+ * a span that started while tracing was enabled is still recorded when it
+ * ends.
+ */
+class Tracer {
+  public:
+    /**
+     * Starts or stops recording spans.
+     * @param is_enabled - whether spans are recorded from now on
+     */
+    static void SetEnabled(bool is_enabled);
+
+    /**
+     * Getter for whether spans are recorded.
+     * @return a bool indicating whether tracing is enabled
+     */
+    static bool IsEnabled();
+
+    /**
+     * Getter for the number of spans recorded on every thread. Only call it
+     * while no span is being recorded.
+     * @return a size_t indicating the number of spans
+     */
+    static size_t GetSpanCount();
+
+    /**
+     * Drops every span recorded so far. Only call it while no span is being
+     * recorded.
+     */
+    static void Clear();
+
+    /**
+     * Writes every span recorded as a Chrome trace event file. Only call it
+     * while no span is being recorded, once the work and every task it gave
+     * the thread pool are done.
+     * @param output - the stream to write the trace to
+     */
+    static void Write(std::ostream& output);
+
+  private:
+    friend class TraceSpan;
+
+    /**
+     * Records a span on the calling thread.
+     * @param name - the name of the phase, which must outlive the tracer
+     * @param start - when the span started
+     * @param end - when the span ended
+     */
+    static void Record(const char* name,
+                       std::chrono::steady_clock::time_point start,
+                       std::chrono::steady_clock::time_point end);
+};
+
+/**
+ * Records the time from its creation to its destruction as a span on the
+ * calling thread, if tracing was enabled when it was created.
+ */
+class TraceSpan {
+  public:
+    /**
+     * Starts a span.
+     * @param name - the name of the phase, usually a string literal, which
+     *               must outlive the tracer
+     */
+    explicit TraceSpan(const char* name);
+
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+  private:
+    const char* name_;
+    bool is_recording_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_TRACE_H
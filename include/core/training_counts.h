@@ -0,0 +1,216 @@
+#ifndef NAIVE_BAYES_TRAINING_COUNTS_H
+#define NAIVE_BAYES_TRAINING_COUNTS_H
+
+#include <functional>
+#include <map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "core/dataset.h"
+#include "core/deduplicated_dataset.h"
+
+namespace naivebayes {
+
+/**
+ * Tallies how many images of each class were seen and how often each Shading
+ * appeared at each pixel for each class. These counts are all a Model needs to
+ * be trained, so images can be counted and thrown away as they are read.
+ * Images can be weighted, so every count is a floating point sum of weights.
+ */
+class TrainingCounts {
+  public:
+    /**
+     * Creates empty counts. The image dimension is taken from the first image
+     * that is added.
+     */
+    TrainingCounts();
+
+    /**
+     * Counts the label and the Shading of every pixel of an Image.
+     * @param image - the Image to count
+     * @throws std::invalid_argument if the image is not the same size as all
+     * previously counted images
+     */
+    void AddImage(const Image& image);
+
+    /**
+     * Counts an Image with the given weight, so a weight of 2 counts it as if
+     * it had been added twice and a weight of 0.5 as half an image.
+     * @param image - the Image to count
+     * @param weight - the non-negative weight of the image
+     * @throws std::invalid_argument if the image is not the same size as all
+     * previously counted images, or if the weight is negative or not finite
+     */
+    void AddImage(const Image& image, double weight);
+
+    /**
+     * Counts a batch of images on the shared thread pool. Each task counts
+     * its images into counts of its own, and those are merged in the order
+     * of the images, so the sums don't depend on how tasks were scheduled.
+     * @param images - the Images to count
+     * @param weights - the non-negative weight of each image
+     * @throws std::invalid_argument under the same conditions as AddImage
+     */
+    void AddImages(const std::vector<Image>& images,
+                   const std::vector<double>& weights);
+
+    /**
+     * Counts every Image in a Dataset on the shared thread pool, the same
+     * way as AddImages.
+     * @param dataset - a Dataset of images to count
+     */
+    void AddDataset(const Dataset& dataset);
+
+    /**
+     * Counts every entry of a DeduplicatedDataset once, weighted by the summed
+     * weight of the times its image was added, on the shared thread pool.
+     * @param dataset - a DeduplicatedDataset of images to count
+     */
+    void AddDataset(const DeduplicatedDataset& dataset);
+
+    /**
+     * Adds the counts of another set of images to these counts, as if every
+     * image counted there had been counted here.
+     * @param other - the TrainingCounts to add to these counts
+     * @throws std::invalid_argument if both have counted images of different
+     * sizes
+     */
+    void Merge(const TrainingCounts& other);
+
+    /**
+     * Removes the counts of a subset of the images counted here, as if those
+     * images had never been counted. Classes left with no images are kept so
+     * a model trained on the result still knows every label.
+     * @param other - the TrainingCounts of images that were counted here
+     * @throws std::invalid_argument if other has counts that are not here
+     */
+    void Subtract(const TrainingCounts& other);
+
+    /**
+     * Rescales the counts of every class so each class has the same total
+     * weight, keeping the total weight of all classes. A model trained on the
+     * result has a uniform class prior and weighs every class equally.
+     */
+    void BalanceClasses();
+
+    /**
+     * Getter for the total weight of the images counted, which is the number
+     * of images counted if none were weighted.
+     * @return a double indicating the weighted number of images counted
+     */
+    double GetImageCount() const;
+
+    /**
+     * Getter for the height of the images counted.
+     * @return a size_t indicating the number of rows in each image
+     */
+    size_t GetHeight() const;
+
+    /**
+     * Getter for the width of the images counted.
+     * @return a size_t indicating the number of columns in each image
+     */
+    size_t GetWidth() const;
+
+    /**
+     * Returns all the class labels that have been counted.
+     * @return a vector of char containing all the distinct class labels
+     */
+    std::vector<char> GetDistinctLabels() const;
+
+    /**
+     * Getter for the weighted number of images counted with the given label.
+     * @param class_label - the label to get the count of
+     * @return a double indicating the weighted number of images of the class
+     */
+    double GetClassCount(char class_label) const;
+
+    /**
+     * Getter for the weighted number of images with the given label that have
+     * the given Shading at the given pixel.
+     * @param class_label - the label of the images to get the count of
+     * @param shading - the Shading to get the count of
+     * @param row - size_t indicating the y-axis index of the pixel
+     * @param column - size_t indicating the x-axis index of the pixel
+     * @return a double indicating the weighted number of images with that
+     * feature
+     */
+    double GetShadingCount(char class_label, Shading shading,
+                           size_t row, size_t column) const;
+
+    /**
+     * Overloaded insertion operator - streams the counts as a JSON checkpoint.
+     * @param output - an ostream to insert the counts into
+     * @param counts - a TrainingCounts object to insert into the ostream
+     * @return the ostream after the counts have been inserted
+     */
+    friend std::ostream &operator<<(std::ostream& output,
+                                    const TrainingCounts& counts);
+
+    /**
+     * Overloaded extraction operator - reads counts from a JSON checkpoint,
+     * replacing any counts already held.
+     * @param input - an istream to extract a serialized checkpoint from
+     * @param counts - a TrainingCounts object to fill with the checkpoint
+     * @return the istream after the counts have been extracted from it
+     */
+    friend std::istream &operator>>(std::istream& input,
+                                    TrainingCounts& counts);
+
+  private:
+    size_t height_;
+    size_t width_;
+    double image_count_;
+
+    // Weighted number of images of each class
+    std::map<char, double> class_counts_;
+
+    // Counts of each class, indexed by [shading][row][column] in a flat vector
+    std::map<char, std::vector<double>> shading_counts_;
+
+    // How far a count may fall below the count subtracted from it, relative
+    // to that count, before it is not considered to have been counted here.
+    // Summing weights in a different order can round differently.
+    static constexpr double kSubtractTolerance = 1e-9;
+
+    // The most images counted by each task of the pool. Every task's counts
+    // are merged afterwards, so a grain must be large enough for counting
+    // its images to outweigh merging its counts.
+    static constexpr size_t kCountingGrainSize = 128;
+
+    // The spacing schema to use when generating the serialized checkpoint
+    static constexpr size_t kJsonSchemaSpacing = 2;
+
+    // Keys that define the structure of the JSON schema
+    static const std::string kJsonSchemaHeightKey;
+    static const std::string kJsonSchemaWidthKey;
+    static const std::string kJsonSchemaClassesKey;
+    static const std::string kJsonSchemaLabelKey;
+    static const std::string kJsonSchemaClassCountKey;
+    static const std::string kJsonSchemaShadingCountsKey;
+
+    /**
+     * Checks whether a count is less than a count being subtracted from it,
+     * beyond what rounding could explain.
+     */
+    static bool IsBelow(double count, double subtracted_count);
+
+    /**
+     * Counts images on the shared thread pool, with each task calling
+     * count_image with counts of its own and the index of each of its images,
+     * then merges every task's counts in index order.
+     */
+    void AddInParallel(
+        size_t image_count,
+        const std::function<void(TrainingCounts&, size_t)>& count_image);
+
+    /**
+     * Finds the index of a feature in the flat vector of shading counts.
+     */
+    size_t GetFeatureIndex(Shading shading, size_t row, size_t column) const;
+};
+
+} // namespace naivebayes
+
+#endif  // NAIVE_BAYES_TRAINING_COUNTS_H
@@ -5,6 +5,7 @@
 #include "cinder/gl/gl.h"
 #include "sketchpad.h"
 
+#include <core/live_classifier.h>
 #include <core/model.h>
 
 namespace naivebayes {
@@ -29,6 +30,14 @@ class NaiveBayesApp : public ci::app::App {
   char current_prediction_;
   
   Model model_;
+  LiveClassifier live_classifier_;
+
+  /**
+   * Applies the brush at the given position and re-scores only the pixels the
+   * stroke changed, so the prediction can follow every drag event.
+   * @param brush_screen_coords the screen coordinates of the brush
+   */
+  void HandleStroke(const glm::vec2& brush_screen_coords);
 
   static constexpr double kWindowSize = 700;
   static constexpr double kMargin = 100;
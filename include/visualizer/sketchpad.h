@@ -10,6 +10,16 @@ namespace naivebayes {
 
 namespace visualizer {
 
+/**
+ * Records a single sketchpad pixel changing from one Shading to another.
+ */
+struct PixelChange {
+  size_t row_;
+  size_t column_;
+  Shading previous_;
+  Shading current_;
+};
+
 /**
  * A sketchpad which will be displayed in the Cinder application and respond to
  * mouse events. Furthermore, the sketchpad can output its current state in the
@@ -32,20 +42,49 @@ class Sketchpad {
    */
   Sketchpad(const glm::vec2& top_left_corner, size_t num_pixels_per_side,
             double sketchpad_size, double brush_radius = 0.8);
-  
-  const std::vector<std::vector<Shading>>& GetPixels() const {
+
+  /**
+   * Gets the pixels of the sketchpad stored row by row in a single buffer, so
+   * the pixel at (row, col) is at index row * GetNumPixelsPerSide() + col.
+   */
+  const std::vector<Shading>& GetPixels() const {
     return pixels_;
   }
 
   /**
-   * Displays the current state of the sketchpad in the Cinder application.
+   * Gets the Shading of the sketchpad pixel at the given row and column.
+   */
+  Shading GetPixel(size_t row, size_t col) const {
+    return pixels_.at(row * num_pixels_per_side_ + col);
+  }
+
+  size_t GetNumPixelsPerSide() const {
+    return num_pixels_per_side_;
+  }
+
+  /**
+   * Gets every pixel change since the last call to ClearDirtyPixels(), in the
+   * order the changes happened, so callers can update incrementally.
+   */
+  const std::vector<PixelChange>& GetDirtyPixels() const {
+    return dirty_pixels_;
+  }
+
+  /**
+   * Forgets all recorded pixel changes once a caller has consumed them.
+   */
+  void ClearDirtyPixels();
+
+  /**
+   * Displays the current state of the sketchpad in the Cinder application,
+   * drawing a rectangle for each shaded pixel over a white background.
    */
   void Draw() const;
 
   /**
    * Shades in the sketchpad pixels whose centers are within brush_radius units
    * of the brush's location. (One unit is equal to the length of one sketchpad
-   * pixel.)
+   * pixel.) Only the pixels inside the bounding box of the brush are visited.
    *
    * @param brush_screen_coords the screen coordinates at which the brush is
    *           located
@@ -53,7 +92,8 @@ class Sketchpad {
   void HandleBrush(const glm::vec2& brush_screen_coords);
 
   /**
-   * Set all of the sketchpad pixels to an unshaded state.
+   * Set all of the sketchpad pixels to an unshaded state. Only the pixels that
+   * are currently shaded are touched.
    */
   void Clear();
 
@@ -66,9 +106,19 @@ class Sketchpad {
   double pixel_side_length_;
 
   double brush_radius_;
-  
-  std::vector<std::vector<Shading>> pixels_;
-  
+
+  /** Row-major buffer of num_pixels_per_side_^2 pixels */
+  std::vector<Shading> pixels_;
+
+  /** Indices into pixels_ of every pixel that is currently shaded */
+  std::vector<size_t> shaded_indices_;
+
+  std::vector<PixelChange> dirty_pixels_;
+
+  /**
+   * Changes the Shading of a pixel, recording the change if there is one.
+   */
+  void SetPixel(size_t row, size_t col, Shading shading);
 };
 
 }  // namespace visualizer
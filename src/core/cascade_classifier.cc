@@ -0,0 +1,244 @@
+#include "core/cascade_classifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "core/thread_pool.h"
+#include "core/trace.h"
+
+namespace naivebayes {
+
+using std::vector;
+
+namespace {
+
+/**
+ * Gathers the images of every label group into one list, since the groups
+ * are very uneven and the pool splits one range best.
+ * @param dataset - a Dataset object to gather the images of
+ * @return a vector of pointers to the images of the dataset
+ */
+vector<const Image*> GatherImages(const Dataset& dataset) {
+  vector<const Image*> images;
+  for (char label : dataset.GetDistinctLabels()) {
+    for (const Image& image : dataset.GetImageGroup(label)) {
+      images.push_back(&image);
+    }
+  }
+
+  return images;
+}
+
+} // namespace
+
+const vector<float> CascadeClassifier::kCandidatePixelFractions =
+    {0.0625f, 0.125f, 0.25f, 0.5f};
+
+CascadeClassifier::CascadeClassifier(const Model& model)
+    : model_(model),
+      labels_(model.GetLabels()),
+      width_(model.GetImageWidth()),
+      margin_threshold_(std::numeric_limits<float>::infinity()) {
+  for (char label : labels_) {
+    class_likelihoods_.push_back(model.GetClassLikelihood(label));
+  }
+}
+
+void CascadeClassifier::Calibrate(const Dataset& dataset, float tolerance) {
+  vector<const Image*> images = GatherImages(dataset);
+  ThreadPool& pool = ThreadPool::GetShared();
+
+  vector<size_t> ranked_pixels = model_.RankPixels();
+  if (images.empty() || ranked_pixels.empty()) {
+    return;
+  }
+
+  // The full model's predictions don't depend on stage one, so find them once
+  // Tasks write their own elements, so char is used instead of vector<bool>
+  vector<char> is_full_correct(images.size());
+  pool.ParallelFor(0, images.size(), kClassifyGrainSize,
+                   [&](size_t first, size_t last) {
+    for (size_t idx = first; idx < last; idx++) {
+      char predicted = model_.Classify(*images[idx]);
+      is_full_correct[idx] = predicted == images[idx]->GetLabel();
+    }
+  });
+  auto full_correct_count = static_cast<size_t>(
+      std::count(is_full_correct.begin(), is_full_correct.end(), 1));
+
+  auto image_count = static_cast<float>(images.size());
+  float min_accuracy = 
+      static_cast<float>(full_correct_count) / image_count - tolerance;
+
+  // Running the full model alone costs 1, so a cascade has to beat that
+  float best_cost = 1;
+  vector<size_t> best_pixels;
+  float best_threshold = std::numeric_limits<float>::infinity();
+
+  for (float fraction : kCandidatePixelFractions) {
+    auto pixel_count = std::max(static_cast<size_t>(1), static_cast<size_t>(
+        std::round(fraction * static_cast<float>(ranked_pixels.size()))));
+    SetPixels(vector<size_t>(ranked_pixels.begin(),
+                             ranked_pixels.begin() + pixel_count));
+
+    vector<float> margins(images.size());
+    vector<char> is_stage_one_correct(images.size());
+    pool.ParallelFor(0, images.size(), kClassifyGrainSize,
+                     [&](size_t first, size_t last) {
+      for (size_t idx = first; idx < last; idx++) {
+        char predicted = labels_[ClassifyStageOne(*images[idx], margins[idx])];
+        is_stage_one_correct[idx] = predicted == images[idx]->GetLabel();
+      }
+    });
+
+    // Keep stage one's prediction for the most confident images first
+    vector<size_t> order(images.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), 
+              [&margins](size_t left, size_t right) {
+      return margins[left] > margins[right];
+    });
+
+    size_t correct_count = full_correct_count;
+    size_t kept_count = 0;
+    for (size_t rank = 0; rank < order.size(); rank++) {
+      size_t idx = order[rank];
+      correct_count += is_stage_one_correct[idx] ? 1 : 0;
+      correct_count -= is_full_correct[idx] ? 1 : 0;
+
+      // A threshold keeps every image with the same margin, so only cut here
+      // if the next image has a smaller margin
+      bool is_cut = rank + 1 == order.size() || 
+          margins[order[rank + 1]] < margins[idx];
+      if (is_cut && 
+          static_cast<float>(correct_count) / image_count >= min_accuracy) {
+        kept_count = rank + 1;
+      }
+    }
+
+    float escalated_fraction = 
+        static_cast<float>(images.size() - kept_count) / image_count;
+    float cost = static_cast<float>(pixel_count) / 
+        static_cast<float>(ranked_pixels.size()) + escalated_fraction;
+
+    if (cost < best_cost) {
+      best_cost = cost;
+      best_pixels = pixels_;
+      best_threshold = kept_count == 0 ? std::numeric_limits<float>::infinity()
+                                       : margins[order[kept_count - 1]];
+    }
+  }
+
+  SetPixels(best_pixels);
+  margin_threshold_ = best_threshold;
+}
+
+char CascadeClassifier::Classify(const Image& image, bool& is_escalated) const {
+  is_escalated = true;
+  if (pixels_.empty()) {
+    return model_.Classify(image);
+  }
+
+  float margin = 0;
+  size_t label_idx = ClassifyStageOne(image, margin);
+  if (margin < margin_threshold_) {
+    return model_.Classify(image);
+  }
+
+  is_escalated = false;
+  return labels_[label_idx];
+}
+
+vector<vector<size_t>> CascadeClassifier::Test(
+    const Dataset& dataset, size_t& escalated_count) const {
+  const std::map<char, size_t>& label_indices = model_.GetLabelIndices();
+  vector<vector<size_t>> confusion_matrix(
+      label_indices.size(), vector<size_t>(label_indices.size(), 0));
+  escalated_count = 0;
+
+  // Classify on the pool like Model::Test, so the two are timed alike
+  vector<const Image*> images = GatherImages(dataset);
+  vector<char> predictions(images.size());
+  vector<char> is_escalated(images.size());
+  ThreadPool::GetShared().ParallelFor(0, images.size(), kClassifyGrainSize,
+                                      [&](size_t first, size_t last) {
+    TraceSpan span("Classify images with the cascade");
+    for (size_t index = first; index < last; index++) {
+      bool is_image_escalated;
+      predictions[index] = Classify(*images[index], is_image_escalated);
+      is_escalated[index] = is_image_escalated;
+    }
+  });
+
+  for (size_t index = 0; index < images.size(); index++) {
+    escalated_count += is_escalated[index] ? 1 : 0;
+    confusion_matrix.at(label_indices.at(images[index]->GetLabel()))
+        .at(label_indices.at(predictions[index]))++;
+  }
+
+  return confusion_matrix;
+}
+
+size_t CascadeClassifier::GetPixelCount() const {
+  return pixels_.size();
+}
+
+float CascadeClassifier::GetMarginThreshold() const {
+  return margin_threshold_;
+}
+
+void CascadeClassifier::SetPixels(const vector<size_t>& pixels) {
+  size_t shading_count = Image::kDistinctShadingEncodings.size();
+  pixels_ = pixels;
+  pixel_likelihoods_.assign(pixels.size() * labels_.size() * shading_count, 0);
+
+  for (size_t rank = 0; rank < pixels.size(); rank++) {
+    size_t row = pixels[rank] / width_;
+    size_t column = pixels[rank] % width_;
+
+    for (size_t label_idx = 0; label_idx < labels_.size(); label_idx++) {
+      for (const Shading& shading : Image::kDistinctShadingEncodings) {
+        auto shading_encoding = static_cast<size_t>(shading);
+        pixel_likelihoods_[(rank * labels_.size() + label_idx) * shading_count +
+                           shading_encoding] =
+            model_.GetIndexedFeatureLikelihood(label_idx, shading, row, column);
+      }
+    }
+  }
+}
+
+size_t CascadeClassifier::ClassifyStageOne(const Image& image,
+                                           float& margin) const {
+  size_t shading_count = Image::kDistinctShadingEncodings.size();
+  vector<float> scores = class_likelihoods_;
+
+  const float* likelihoods = pixel_likelihoods_.data();
+  for (size_t pixel : pixels_) {
+    auto shading_encoding = 
+        static_cast<size_t>(image.GetPixel(pixel / width_, pixel % width_));
+
+    for (size_t label_idx = 0; label_idx < labels_.size(); label_idx++) {
+      scores[label_idx] += likelihoods[shading_encoding];
+      likelihoods += shading_count;
+    }
+  }
+
+  // Find the top two scores in one pass
+  size_t best_idx = 0;
+  float runner_up = -std::numeric_limits<float>::infinity();
+  for (size_t label_idx = 1; label_idx < scores.size(); label_idx++) {
+    if (scores[label_idx] > scores[best_idx]) {
+      runner_up = scores[best_idx];
+      best_idx = label_idx;
+    } else if (scores[label_idx] > runner_up) {
+      runner_up = scores[label_idx];
+    }
+  }
+
+  margin = scores[best_idx] - runner_up;
+  return best_idx;
+}
+
+} // namespace naivebayes
@@ -0,0 +1,139 @@
+#include "core/classification_cache.h"
+
+namespace naivebayes {
+
+using std::vector;
+
+ClassificationCache::ClassificationCache(size_t capacity)
+    : shard_capacity_((capacity + kShardCount - 1) / kShardCount),
+      shards_(kShardCount),
+      generation_(0),
+      hit_count_(0),
+      miss_count_(0),
+      eviction_count_(0),
+      invalidation_count_(0) {}
+
+char ClassificationCache::Classify(const Model& model, const Image& image) {
+  vector<float> scores;
+
+  if (!Find(image, model.GetGeneration(), scores)) {
+    scores = model.CalculateLikelihoodScores(vector<Image>{image}).at(0);
+    Insert(image, model.GetGeneration(), scores);
+  }
+
+  if (scores.empty()) {
+    return Image::kDefaultLabel;
+  }
+
+  // The prediction is the label with the highest score
+  size_t best_idx = 0;
+  for (size_t label_idx = 1; label_idx < scores.size(); label_idx++) {
+    if (scores[label_idx] > scores[best_idx]) {
+      best_idx = label_idx;
+    }
+  }
+
+  return model.GetLabels().at(best_idx);
+}
+
+bool ClassificationCache::Find(const Image& image, uint64_t generation,
+                               vector<float>& scores) {
+  CheckGeneration(generation);
+  if (shard_capacity_ == 0) {
+    miss_count_++;
+    return false;
+  }
+
+  vector<uint8_t> packed_pixels = image.Pack();
+  uint64_t hash = Image::HashPacked(packed_pixels, image.GetHeight(),
+                                    image.GetWidth(), Image::kDefaultLabel);
+  Shard& shard = shards_[hash % kShardCount];
+
+  std::lock_guard<std::mutex> lock(shard.mutex_);
+  auto indexed_entry = shard.index_.find(hash);
+
+  // A hit must be this very image under the current model, or it would be
+  // given the scores of another image that only shares its hash
+  if (indexed_entry == shard.index_.end() ||
+      indexed_entry->second->generation_ != generation ||
+      indexed_entry->second->height_ != image.GetHeight() ||
+      indexed_entry->second->width_ != image.GetWidth() ||
+      indexed_entry->second->packed_pixels_ != packed_pixels) {
+    miss_count_++;
+    return false;
+  }
+
+  // Move the entry to the front, as the most recently used
+  shard.entries_.splice(shard.entries_.begin(), shard.entries_,
+                        indexed_entry->second);
+  scores = indexed_entry->second->scores_;
+  hit_count_++;
+  return true;
+}
+
+void ClassificationCache::Insert(const Image& image, uint64_t generation,
+                                 const vector<float>& scores) {
+  CheckGeneration(generation);
+  if (shard_capacity_ == 0) {
+    return;
+  }
+
+  vector<uint8_t> packed_pixels = image.Pack();
+  uint64_t hash = Image::HashPacked(packed_pixels, image.GetHeight(),
+                                    image.GetWidth(), Image::kDefaultLabel);
+  Shard& shard = shards_[hash % kShardCount];
+
+  std::lock_guard<std::mutex> lock(shard.mutex_);
+  auto indexed_entry = shard.index_.find(hash);
+  if (indexed_entry != shard.index_.end()) {
+    shard.entries_.erase(indexed_entry->second);
+    shard.index_.erase(indexed_entry);
+  }
+
+  Entry entry = {hash, image.GetHeight(), image.GetWidth(),
+                 std::move(packed_pixels), generation, scores};
+  shard.entries_.push_front(std::move(entry));
+  shard.index_[hash] = shard.entries_.begin();
+
+  if (shard.entries_.size() > shard_capacity_) {
+    shard.index_.erase(shard.entries_.back().hash_);
+    shard.entries_.pop_back();
+    eviction_count_++;
+  }
+}
+
+void ClassificationCache::Clear() {
+  for (Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+    shard.entries_.clear();
+    shard.index_.clear();
+  }
+}
+
+size_t ClassificationCache::GetHitCount() const {
+  return hit_count_;
+}
+
+size_t ClassificationCache::GetMissCount() const {
+  return miss_count_;
+}
+
+size_t ClassificationCache::GetEvictionCount() const {
+  return eviction_count_;
+}
+
+size_t ClassificationCache::GetInvalidationCount() const {
+  return invalidation_count_;
+}
+
+void ClassificationCache::CheckGeneration(uint64_t generation) {
+  // Only the thread that swaps in the new generation clears the old entries.
+  // Entries another thread inserts for the old generation are never hit.
+  uint64_t previous_generation = generation_.exchange(generation);
+  if (previous_generation != generation) {
+    Clear();
+    invalidation_count_ += previous_generation == 0 ? 0 : 1;
+  }
+}
+
+} // namespace naivebayes
@@ -0,0 +1,258 @@
+#include "core/classify_connection.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace naivebayes {
+
+using std::vector;
+using std::string;
+
+namespace {
+
+/**
+ * Appends the bytes of a number to the end of a message payload.
+ */
+template <typename T>
+void AppendBytes(vector<uint8_t>& payload, T value) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+  payload.insert(payload.end(), bytes, bytes + sizeof(T));
+}
+
+/**
+ * Reads a number from a message payload, advancing the offset past it.
+ */
+template <typename T>
+bool ExtractBytes(const vector<uint8_t>& payload, size_t& offset, T& value) {
+  if (offset + sizeof(T) > payload.size()) {
+    return false;
+  }
+
+  std::memcpy(&value, payload.data() + offset, sizeof(T));
+  offset += sizeof(T);
+  return true;
+}
+
+} // namespace
+
+ClassifyConnection::ClassifyConnection(int socket_fd)
+    : socket_fd_(socket_fd), is_open_(socket_fd >= 0) {}
+
+ClassifyConnection::~ClassifyConnection() {
+  if (socket_fd_ >= 0) {
+    close(socket_fd_);
+  }
+}
+
+int ClassifyConnection::Connect(const string& socket_path) {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    return -1;
+  }
+  std::strncpy(address.sun_path, socket_path.c_str(),
+               sizeof(address.sun_path) - 1);
+
+  int socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (socket_fd < 0) {
+    return -1;
+  }
+
+  if (connect(socket_fd, reinterpret_cast<sockaddr*>(&address),
+              sizeof(address)) < 0) {
+    close(socket_fd);
+    return -1;
+  }
+
+  return socket_fd;
+}
+
+bool ClassifyConnection::IsOpen() const {
+  return is_open_;
+}
+
+bool ClassifyConnection::ReadRequest(RequestType& type, Image& image) {
+  vector<uint8_t> payload;
+  if (!ReadMessage(payload)) {
+    return false;
+  }
+
+  size_t offset = 0;
+  uint8_t type_byte;
+  if (!ExtractBytes(payload, offset, type_byte) ||
+      type_byte > static_cast<uint8_t>(RequestType::kStats)) {
+    is_open_ = false;
+    return false;
+  }
+
+  type = static_cast<RequestType>(type_byte);
+  if (type != RequestType::kClassify) {
+    return true;
+  }
+
+  uint16_t height;
+  uint16_t width;
+  if (!ExtractBytes(payload, offset, height) ||
+      !ExtractBytes(payload, offset, width) || height == 0 || width == 0 ||
+      payload.size() - offset != Image::GetPackedSize(height, width)) {
+    is_open_ = false;  // the stream can't be trusted to be at a message start
+    return false;
+  }
+
+  try {
+    image = Image::Unpack(payload.data() + offset, height, width,
+                          Image::kDefaultLabel);
+  } catch (const std::invalid_argument&) {
+    is_open_ = false;
+    return false;
+  }
+
+  return true;
+}
+
+bool ClassifyConnection::WriteRequest(const Image& image) {
+  vector<uint8_t> packed = image.Pack();
+
+  vector<uint8_t> payload;
+  payload.reserve(sizeof(uint8_t) + 2 * sizeof(uint16_t) + packed.size());
+  AppendBytes(payload, static_cast<uint8_t>(RequestType::kClassify));
+  AppendBytes(payload, static_cast<uint16_t>(image.GetHeight()));
+  AppendBytes(payload, static_cast<uint16_t>(image.GetWidth()));
+  payload.insert(payload.end(), packed.begin(), packed.end());
+
+  return WriteMessage(payload);
+}
+
+bool ClassifyConnection::WriteControlRequest(RequestType type) {
+  vector<uint8_t> payload;
+  AppendBytes(payload, static_cast<uint8_t>(type));
+
+  return WriteMessage(payload);
+}
+
+bool ClassifyConnection::ReadText(string& text) {
+  vector<uint8_t> payload;
+  if (!ReadMessage(payload)) {
+    return false;
+  }
+
+  text.assign(payload.begin(), payload.end());
+  return true;
+}
+
+bool ClassifyConnection::WriteText(const string& text) {
+  return WriteMessage(vector<uint8_t>(text.begin(), text.end()));
+}
+
+bool ClassifyConnection::ReadResponse(ClassifyResponse& response) {
+  vector<uint8_t> payload;
+  if (!ReadMessage(payload)) {
+    return false;
+  }
+
+  size_t offset = 0;
+  uint32_t score_count;
+  if (!ExtractBytes(payload, offset, response.label_) ||
+      !ExtractBytes(payload, offset, score_count) ||
+      payload.size() - offset != score_count * (sizeof(char) + sizeof(float))) {
+    is_open_ = false;
+    return false;
+  }
+
+  response.labels_ = vector<char>(score_count);
+  response.scores_ = vector<float>(score_count);
+  for (size_t index = 0; index < score_count; index++) {
+    ExtractBytes(payload, offset, response.labels_[index]);
+    ExtractBytes(payload, offset, response.scores_[index]);
+  }
+
+  return true;
+}
+
+bool ClassifyConnection::WriteResponse(const ClassifyResponse& response) {
+  vector<uint8_t> payload;
+  AppendBytes(payload, response.label_);
+  AppendBytes(payload, static_cast<uint32_t>(response.scores_.size()));
+
+  for (size_t index = 0; index < response.scores_.size(); index++) {
+    AppendBytes(payload, response.labels_.at(index));
+    AppendBytes(payload, response.scores_.at(index));
+  }
+
+  return WriteMessage(payload);
+}
+
+void ClassifyConnection::Shutdown() {
+  if (socket_fd_ >= 0) {
+    shutdown(socket_fd_, SHUT_RDWR);
+  }
+}
+
+bool ClassifyConnection::ReadMessage(vector<uint8_t>& payload) {
+  uint32_t payload_size;
+  if (!ReadFully(reinterpret_cast<uint8_t*>(&payload_size),
+                 sizeof(payload_size))) {
+    return false;
+  }
+
+  if (payload_size > kMaxPayloadSize) {
+    is_open_ = false;
+    return false;
+  }
+
+  payload.resize(payload_size);
+  return ReadFully(payload.data(), payload_size);
+}
+
+bool ClassifyConnection::WriteMessage(const vector<uint8_t>& payload) {
+  // Send the size and payload with one write so they go out in one packet
+  vector<uint8_t> message;
+  message.reserve(sizeof(uint32_t) + payload.size());
+  AppendBytes(message, static_cast<uint32_t>(payload.size()));
+  message.insert(message.end(), payload.begin(), payload.end());
+
+  return WriteFully(message.data(), message.size());
+}
+
+bool ClassifyConnection::ReadFully(uint8_t* buffer, size_t size) {
+  size_t bytes_read = 0;
+
+  while (is_open_ && bytes_read < size) {
+    ssize_t result = read(socket_fd_, buffer + bytes_read, size - bytes_read);
+
+    if (result > 0) {
+      bytes_read += static_cast<size_t>(result);
+    } else if (result < 0 && errno == EINTR) {
+      continue;
+    } else {
+      is_open_ = false;  // 0 means the other end closed the connection
+    }
+  }
+
+  return is_open_;
+}
+
+bool ClassifyConnection::WriteFully(const uint8_t* buffer, size_t size) {
+  size_t bytes_written = 0;
+
+  while (is_open_ && bytes_written < size) {
+    ssize_t result = write(socket_fd_, buffer + bytes_written,
+                           size - bytes_written);
+
+    if (result > 0) {
+      bytes_written += static_cast<size_t>(result);
+    } else if (result < 0 && errno == EINTR) {
+      continue;
+    } else {
+      is_open_ = false;
+    }
+  }
+
+  return is_open_;
+}
+
+} // namespace naivebayes
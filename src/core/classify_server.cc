@@ -0,0 +1,419 @@
+#include "core/classify_server.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <thread>
+
+namespace naivebayes {
+
+using nlohmann::json;
+using std::vector;
+using std::string;
+
+const string ClassifyServer::kListeningMessage = "Listening on ";
+const string ClassifyServer::kStartFailedMessage =
+    "Could not listen on the socket.";
+const string ClassifyServer::kStoppingMessage = "Stopping server...";
+const string ClassifyServer::kRequestCountMessage = "Requests served: ";
+const string ClassifyServer::kBatchCountMessage = "Batches scored: ";
+const string ClassifyServer::kLoadedMessage = "Loaded model version ";
+const string ClassifyServer::kLoadFailedMessage =
+    "Could not load a trained model from ";
+
+const string ClassifyServer::kStatsVersionKey = "model_version";
+const string ClassifyServer::kStatsLoadedAtKey = "model_loaded_at";
+const string ClassifyServer::kStatsLoadMillisKey = "model_load_millis";
+const string ClassifyServer::kStatsFailedReloadsKey = "failed_reloads";
+const string ClassifyServer::kStatsRequestsKey = "requests_served";
+const string ClassifyServer::kStatsBatchesKey = "batches_scored";
+const string ClassifyServer::kStatsCacheHitsKey = "cache_hits";
+const string ClassifyServer::kStatsCacheMissesKey = "cache_misses";
+const string ClassifyServer::kStatsCacheEvictionsKey = "cache_evictions";
+const string ClassifyServer::kStatsCacheInvalidationsKey = 
+    "cache_invalidations";
+
+ClassifyServer::ClassifyServer(const string& model_path,
+                               size_t max_batch_size,
+                               size_t batch_window_micros, size_t cache_size)
+    : model_path_(model_path),
+      active_version_(nullptr),
+      batch_version_(nullptr),
+      is_reload_requested_(false),
+      failed_reload_count_(0),
+      max_batch_size_(max_batch_size > 0 ? max_batch_size : 1),
+      batch_window_(batch_window_micros),
+      cache_(cache_size),
+      is_running_(false),
+      is_batching_(false),
+      active_connection_count_(0),
+      request_count_(0),
+      batch_count_(0) {}
+
+ClassifyServer::~ClassifyServer() {
+  delete active_version_.load();
+}
+
+int ClassifyServer::Serve(const string& socket_path) {
+  if (active_version_ == nullptr && !Reload()) {
+    return EXIT_FAILURE;
+  }
+
+  int listen_fd = Listen(socket_path);
+  if (listen_fd < 0) {
+    std::cout << kStartFailedMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  is_running_ = true;
+  is_batching_ = true;
+  std::thread batch_thread(&ClassifyServer::RunBatches, this);
+  std::thread reload_thread(&ClassifyServer::RunReloads, this);
+  std::cout << kListeningMessage << socket_path << std::endl;
+
+  // Poll with a timeout instead of blocking so Stop() is noticed promptly
+  while (is_running_) {
+    pollfd listen_poll = {listen_fd, POLLIN, 0};
+    if (poll(&listen_poll, 1, kAcceptPollMillis) <= 0) {
+      continue;
+    }
+
+    int socket_fd = accept(listen_fd, nullptr, nullptr);
+    if (socket_fd < 0) {
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    active_connection_count_++;
+    std::thread(&ClassifyServer::HandleConnection, this, socket_fd).detach();
+  }
+
+  std::cout << kStoppingMessage << std::endl;
+  close(listen_fd);
+  unlink(socket_path.c_str());
+  reload_thread.join();
+
+  // Wake up every connection blocked on a read, then wait for them to finish
+  {
+    std::unique_lock<std::mutex> lock(connections_mutex_);
+    for (ClassifyConnection* connection : connections_) {
+      connection->Shutdown();
+    }
+    connections_condition_.wait(
+        lock, [this]() { return active_connection_count_ == 0; });
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    is_batching_ = false;
+  }
+  queue_condition_.notify_all();
+  batch_thread.join();
+
+  std::cout << kRequestCountMessage << request_count_ << std::endl;
+  std::cout << kBatchCountMessage << batch_count_ << std::endl;
+  return EXIT_SUCCESS;
+}
+
+void ClassifyServer::Stop() {
+  is_running_ = false;
+}
+
+void ClassifyServer::RequestReload() {
+  is_reload_requested_ = true;
+}
+
+bool ClassifyServer::Reload() {
+  std::lock_guard<std::mutex> lock(reload_mutex_);
+
+  ModelVersion* old_version = active_version_.load();
+  size_t number = old_version == nullptr ? 1 : old_version->number_ + 1;
+
+  // Parse the new model before touching the one requests are scored with
+  ModelVersion* new_version = LoadVersion(number);
+  if (new_version == nullptr) {
+    std::cout << kLoadFailedMessage << model_path_ << std::endl;
+    failed_reload_count_++;
+    return false;
+  }
+
+  active_version_ = new_version;
+  std::cout << kLoadedMessage << number << std::endl;
+
+  // A batch may have picked up the old version just before the swap, so
+  // wait for it to finish before deleting the old version. Any later batch
+  // can only see the new one.
+  while (old_version != nullptr && batch_version_ == old_version) {
+    std::this_thread::yield();
+  }
+  delete old_version;
+
+  return true;
+}
+
+string ClassifyServer::GetStats() {
+  json stats;
+  {
+    // Holding the reload lock keeps the active version from being deleted
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    const ModelVersion* version = active_version_.load();
+
+    if (version != nullptr) {
+      stats[kStatsVersionKey] = version->number_;
+      stats[kStatsLoadedAtKey] = version->loaded_at_;
+      stats[kStatsLoadMillisKey] = version->load_millis_;
+    }
+    stats[kStatsFailedReloadsKey] = failed_reload_count_;
+  }
+
+  stats[kStatsRequestsKey] = request_count_.load();
+  stats[kStatsBatchesKey] = batch_count_.load();
+  stats[kStatsCacheHitsKey] = cache_.GetHitCount();
+  stats[kStatsCacheMissesKey] = cache_.GetMissCount();
+  stats[kStatsCacheEvictionsKey] = cache_.GetEvictionCount();
+  stats[kStatsCacheInvalidationsKey] = cache_.GetInvalidationCount();
+
+  return stats.dump();
+}
+
+void ClassifyServer::HandleConnection(int socket_fd) {
+  ClassifyConnection connection(socket_fd);
+
+  // Once registered, a stop either sees this connection or we see the stop
+  bool is_registered;
+  {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    is_registered = is_running_;
+    if (is_registered) {
+      connections_.insert(&connection);
+    }
+  }
+
+  RequestType type;
+  Image image;
+  while (is_registered && connection.ReadRequest(type, image)) {
+    if (type != RequestType::kClassify) {
+      if (type == RequestType::kReload) {
+        Reload();
+      }
+
+      if (!connection.WriteText(GetStats())) {
+        break;
+      }
+      continue;
+    }
+
+    PendingRequest request = {std::move(image), ClassifyResponse(), false,
+                              false};
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex_);
+      queue_.push_back(&request);
+    }
+    queue_condition_.notify_one();
+
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      done_condition_.wait(lock, [&request]() { return request.is_done_; });
+    }
+
+    if (!request.is_classified_) {
+      break;  // the model can't score an image of a different size
+    }
+
+    if (!connection.WriteResponse(request.response_)) {
+      break;
+    }
+    request_count_++;
+  }
+
+  std::lock_guard<std::mutex> lock(connections_mutex_);
+  connections_.erase(&connection);
+  active_connection_count_--;
+  connections_condition_.notify_all();
+}
+
+void ClassifyServer::RunBatches() {
+  vector<PendingRequest*> batch;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_condition_.wait(
+          lock, [this]() { return !queue_.empty() || !is_batching_; });
+
+      if (queue_.empty()) {
+        return;  // only reached once the server has stopped batching
+      }
+
+      // Give concurrent requests a short window to join this batch
+      auto deadline = std::chrono::steady_clock::now() + batch_window_;
+      queue_condition_.wait_until(lock, deadline, [this]() {
+        return queue_.size() >= max_batch_size_ || !is_batching_;
+      });
+
+      size_t batch_size = std::min(queue_.size(), max_batch_size_);
+      batch.assign(queue_.begin(), queue_.begin() + batch_size);
+      queue_.erase(queue_.begin(), queue_.begin() + batch_size);
+    }
+
+    ClassifyBatch(batch, *AcquireVersion());
+    ReleaseVersion();
+    batch_count_++;
+
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex_);
+      for (PendingRequest* request : batch) {
+        request->is_done_ = true;
+      }
+    }
+    done_condition_.notify_all();
+  }
+}
+
+void ClassifyServer::RunReloads() {
+  while (is_running_) {
+    if (is_reload_requested_.exchange(false)) {
+      Reload();
+    } else {
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(kReloadPollMillis));
+    }
+  }
+}
+
+ClassifyServer::ModelVersion* ClassifyServer::LoadVersion(
+    size_t number) const {
+  auto start = std::chrono::steady_clock::now();
+
+  ModelVersion* version = new ModelVersion();
+  version->number_ = number;
+
+  try {
+    std::ifstream model_file(model_path_);
+    if (model_file.is_open()) {
+      model_file >> version->model_;
+    }
+  } catch (const std::exception&) {
+    version->model_ = Model();  // a partly written model file is not served
+  }
+
+  version->labels_ = version->model_.GetLabels();
+  if (version->labels_.empty()) {
+    delete version;
+    return nullptr;
+  }
+
+  std::chrono::duration<double, std::milli> load_time =
+      std::chrono::steady_clock::now() - start;
+  version->load_millis_ = load_time.count();
+
+  char timestamp[sizeof("YYYY-MM-DDTHH:MM:SSZ")];
+  std::time_t now = std::time(nullptr);
+  std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ",
+                std::gmtime(&now));
+  version->loaded_at_ = timestamp;
+
+  return version;
+}
+
+ClassifyServer::ModelVersion* ClassifyServer::AcquireVersion() {
+  ModelVersion* version = active_version_.load();
+
+  // Publish the version before using it, then make sure it was not replaced
+  // in between, or Reload() could miss it and delete it under us
+  while (true) {
+    batch_version_ = version;
+
+    ModelVersion* current_version = active_version_.load();
+    if (current_version == version) {
+      return version;
+    }
+    version = current_version;
+  }
+}
+
+void ClassifyServer::ReleaseVersion() {
+  batch_version_ = nullptr;
+}
+
+void ClassifyServer::ClassifyBatch(const vector<PendingRequest*>& batch,
+                                   const ModelVersion& version) {
+  uint64_t generation = version.model_.GetGeneration();
+  vector<PendingRequest*> classified_batch;
+  vector<PendingRequest*> missed_batch;
+  vector<Image> missed_images;
+
+  for (PendingRequest* request : batch) {
+    if (request->image_.GetHeight() != version.model_.GetImageHeight() ||
+        request->image_.GetWidth() != version.model_.GetImageWidth()) {
+      continue;
+    }
+
+    classified_batch.push_back(request);
+    vector<float>& scores = request->response_.scores_;
+    if (!cache_.Find(request->image_, generation, scores)) {
+      missed_batch.push_back(request);
+      missed_images.push_back(std::move(request->image_));
+    }
+  }
+
+  // Only the images the cache has not seen need to be scored
+  vector<vector<float>> scores =
+      version.model_.CalculateLikelihoodScores(missed_images);
+  for (size_t missed_idx = 0; missed_idx < missed_batch.size(); 
+       missed_idx++) {
+    cache_.Insert(missed_images[missed_idx], generation, scores[missed_idx]);
+    missed_batch[missed_idx]->response_.scores_ = 
+        std::move(scores[missed_idx]);
+  }
+
+  for (PendingRequest* request : classified_batch) {
+    ClassifyResponse& response = request->response_;
+    response.labels_ = version.labels_;
+
+    // The prediction is the label with the highest score
+    size_t best_idx = 0;
+    for (size_t label_idx = 1; label_idx < version.labels_.size();
+         label_idx++) {
+      if (response.scores_[label_idx] > response.scores_[best_idx]) {
+        best_idx = label_idx;
+      }
+    }
+    response.label_ = version.labels_[best_idx];
+    request->is_classified_ = true;
+  }
+}
+
+int ClassifyServer::Listen(const string& socket_path) {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    return -1;
+  }
+  std::strncpy(address.sun_path, socket_path.c_str(),
+               sizeof(address.sun_path) - 1);
+
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd < 0) {
+    return -1;
+  }
+
+  // Remove a socket left behind by a server that did not shut down cleanly
+  unlink(socket_path.c_str());
+  if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) < 0 ||
+      listen(listen_fd, kListenBacklog) < 0) {
+    close(listen_fd);
+    return -1;
+  }
+
+  return listen_fd;
+}
+
+} // namespace naivebayes
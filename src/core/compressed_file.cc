@@ -0,0 +1,297 @@
+#include "core/compressed_file.h"
+
+#include <zlib.h>
+
+#ifdef NAIVE_BAYES_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#include <stdexcept>
+
+namespace naivebayes {
+
+using std::string;
+
+namespace {
+
+const string kGzipMagic = "\x1f\x8b";
+const string kZstdMagic = "\x28\xb5\x2f\xfd";
+
+// Accept a gzip header, or a zlib header, and use the largest window
+const int kGzipWindowBits = 15 + 32;
+
+} // namespace
+
+CompressedFile::BlockBuffer::BlockBuffer(CompressedFile& file) : file_(file) {}
+
+void CompressedFile::BlockBuffer::Reset() {
+  block_.clear();
+  setg(nullptr, nullptr, nullptr);
+}
+
+CompressedFile::BlockBuffer::int_type CompressedFile::BlockBuffer::underflow() {
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+
+  // Blocks are never empty, so a block that was taken has a byte to read
+  if (!file_.PopBlock(block_)) {
+    return traits_type::eof();
+  }
+
+  setg(&block_[0], &block_[0], &block_[0] + block_.size());
+  return traits_type::to_int_type(*gptr());
+}
+
+CompressedFile::CompressedFile()
+    : format_(Format::kNone),
+      is_finished_(true),
+      is_stopping_(false),
+      buffer_(*this),
+      stream_(&buffer_) {
+  // Errors thrown by the buffer reach the reader instead of only failing it
+  stream_.exceptions(std::ios::badbit);
+}
+
+CompressedFile::~CompressedFile() {
+  Close();
+}
+
+CompressedFile::Format CompressedFile::DetectFormat(std::istream& input) {
+  std::streampos start = input.tellg();
+  string magic(kZstdMagic.size(), '\0');
+  input.read(&magic[0], static_cast<std::streamsize>(magic.size()));
+  magic.resize(static_cast<size_t>(input.gcount()));
+
+  input.clear();
+  input.seekg(start);
+
+  if (magic.compare(0, kGzipMagic.size(), kGzipMagic) == 0) {
+    return Format::kGzip;
+  } else if (magic == kZstdMagic) {
+    return Format::kZstd;
+  }
+
+  return Format::kNone;
+}
+
+bool CompressedFile::Open(const string& path) {
+  Close();
+
+  input_.open(path, std::ios::binary);
+  if (!input_.is_open()) {
+    return false;
+  }
+
+  format_ = DetectFormat(input_);
+  if (format_ == Format::kNone) {
+    input_.close();
+    return false;
+  }
+
+#ifndef NAIVE_BAYES_HAS_ZSTD
+  if (format_ == Format::kZstd) {
+    input_.close();
+    throw std::invalid_argument("This build can't read zstd datasets.");
+  }
+#endif
+
+  is_finished_ = false;
+  is_stopping_ = false;
+  error_ = nullptr;
+  decompressor_ = std::thread(&CompressedFile::Decompress, this);
+  return true;
+}
+
+std::istream& CompressedFile::GetStream() {
+  return stream_;
+}
+
+void CompressedFile::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  block_taken_.notify_all();
+
+  if (decompressor_.joinable()) {
+    decompressor_.join();
+  }
+
+  input_.close();
+  input_.clear();
+  format_ = Format::kNone;
+  blocks_.clear();
+  is_finished_ = true;
+  error_ = nullptr;
+  buffer_.Reset();
+  stream_.clear();
+}
+
+void CompressedFile::Decompress() {
+  bool is_valid = format_ == Format::kGzip ? DecompressGzip()
+                                           : DecompressZstd();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!is_valid) {
+    error_ = std::make_exception_ptr(std::invalid_argument(
+        "The compressed dataset is corrupt or truncated."));
+  }
+  is_finished_ = true;
+  block_queued_.notify_all();
+}
+
+bool CompressedFile::DecompressGzip() {
+  z_stream stream = z_stream();
+  if (inflateInit2(&stream, kGzipWindowBits) != Z_OK) {
+    return false;
+  }
+
+  string input(kBlockSize, '\0');
+  string output(kBlockSize, '\0');
+  stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+  stream.avail_out = static_cast<uInt>(output.size());
+  int status = Z_OK;
+  bool is_input_done = false;
+
+  while (true) {
+    if (stream.avail_in == 0 && !is_input_done) {
+      input_.read(&input[0], static_cast<std::streamsize>(input.size()));
+      is_input_done = input_.gcount() == 0;
+      stream.next_in = reinterpret_cast<Bytef*>(&input[0]);
+      stream.avail_in = static_cast<uInt>(input_.gcount());
+    }
+
+    // Inflate keeps running after the input ends to flush what it holds
+    status = inflate(&stream, Z_NO_FLUSH);
+    if (status == Z_STREAM_END &&
+        (stream.avail_in > 0 || (!is_input_done && input_.peek() != EOF))) {
+      // Concatenated gzip files are one file, like gunzip reads them
+      inflateReset(&stream);
+      status = Z_OK;
+    } else if (status == Z_BUF_ERROR && is_input_done) {
+      // Nothing is left to flush, so the stream ended before it should have
+      break;
+    } else if (status != Z_OK && status != Z_STREAM_END) {
+      inflateEnd(&stream);
+      return false;
+    }
+
+    if (stream.avail_out == 0) {
+      if (!PushBlock(output)) {
+        inflateEnd(&stream);
+        return true;
+      }
+      output.assign(kBlockSize, '\0');
+      stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+      stream.avail_out = static_cast<uInt>(output.size());
+    } else if (is_input_done || status == Z_STREAM_END) {
+      // Output that isn't full means inflate has nothing more to give
+      break;
+    }
+  }
+
+  inflateEnd(&stream);
+  output.resize(kBlockSize - stream.avail_out);
+  if (!output.empty()) {
+    PushBlock(output);
+  }
+
+  return status == Z_STREAM_END;
+}
+
+bool CompressedFile::DecompressZstd() {
+#ifdef NAIVE_BAYES_HAS_ZSTD
+  ZSTD_DStream* stream = ZSTD_createDStream();
+  if (stream == nullptr || ZSTD_isError(ZSTD_initDStream(stream))) {
+    ZSTD_freeDStream(stream);
+    return false;
+  }
+
+  string input(kBlockSize, '\0');
+  string output(kBlockSize, '\0');
+  ZSTD_inBuffer in_buffer = {input.data(), 0, 0};
+  ZSTD_outBuffer out_buffer = {&output[0], output.size(), 0};
+  // ZSTD_decompressStream returns 0 once a whole frame is decompressed
+  size_t status = 0;
+  bool is_input_done = false;
+
+  while (true) {
+    if (in_buffer.pos == in_buffer.size && !is_input_done) {
+      input_.read(&input[0], static_cast<std::streamsize>(input.size()));
+      is_input_done = input_.gcount() == 0;
+      in_buffer.size = static_cast<size_t>(input_.gcount());
+      in_buffer.pos = 0;
+    }
+    if (is_input_done && status == 0) {
+      // The last frame is whole, and a finished frame holds nothing back
+      break;
+    }
+
+    // Once the input ends, empty input still flushes what the stream holds
+    status = ZSTD_decompressStream(stream, &out_buffer, &in_buffer);
+    if (ZSTD_isError(status)) {
+      ZSTD_freeDStream(stream);
+      return false;
+    }
+
+    if (out_buffer.pos == out_buffer.size) {
+      if (!PushBlock(output)) {
+        ZSTD_freeDStream(stream);
+        return true;
+      }
+      output.assign(kBlockSize, '\0');
+      out_buffer = {&output[0], output.size(), 0};
+    } else if (is_input_done) {
+      // Output that isn't full means the stream has nothing more to give
+      break;
+    }
+  }
+
+  ZSTD_freeDStream(stream);
+  output.resize(out_buffer.pos);
+  if (!output.empty()) {
+    PushBlock(output);
+  }
+
+  return status == 0;
+#else
+  return false;
+#endif
+}
+
+bool CompressedFile::PushBlock(string& block) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  block_taken_.wait(lock, [this]() {
+    return is_stopping_ || blocks_.size() < kQueuedBlockCount;
+  });
+
+  if (is_stopping_) {
+    return false;
+  }
+
+  blocks_.push_back(std::move(block));
+  block_queued_.notify_one();
+  return true;
+}
+
+bool CompressedFile::PopBlock(string& block) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  block_queued_.wait(lock, [this]() {
+    return is_finished_ || !blocks_.empty();
+  });
+
+  if (blocks_.empty()) {
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return false;
+  }
+
+  block = std::move(blocks_.front());
+  blocks_.pop_front();
+  block_taken_.notify_one();
+  return true;
+}
+
+} // namespace naivebayes
@@ -0,0 +1,225 @@
+#include "core/dataset_cache.h"
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "core/compressed_file.h"
+#include "core/image_stream.h"
+#include "core/image_writer.h"
+
+namespace naivebayes {
+
+using std::string;
+using std::vector;
+
+const string DatasetCache::kSnapshotExtension = ".nbd";
+
+namespace {
+
+const uint64_t kOffsetBasis = 14695981039346656037ULL;
+const uint64_t kPrime = 1099511628211ULL;
+
+/**
+ * Folds bytes into an FNV-1a hash.
+ */
+uint64_t HashBytes(uint64_t hash, const char* bytes, size_t size) {
+  for (size_t byte = 0; byte < size; byte++) {
+    hash = (hash ^ static_cast<uint8_t>(bytes[byte])) * kPrime;
+  }
+  return hash;
+}
+
+/**
+ * Folds a number into an FNV-1a hash.
+ */
+uint64_t HashNumber(uint64_t hash, uint64_t value) {
+  return (hash ^ value) * kPrime;
+}
+
+/**
+ * A snapshot in the cache directory, to be sorted by when it was last read.
+ */
+struct Snapshot {
+  string path;
+  uint64_t size;
+  int64_t read_time;
+};
+
+} // namespace
+
+DatasetCache::DatasetCache() : max_size_(0) {}
+
+DatasetCache::DatasetCache(const string& directory, uint64_t max_size)
+    : directory_(directory), max_size_(max_size) {}
+
+bool DatasetCache::IsEnabled() const {
+  return !directory_.empty();
+}
+
+bool DatasetCache::Open(const string& dataset_path,
+                        MappedFile& snapshot) const {
+  if (!IsEnabled()) {
+    return false;
+  }
+
+  string snapshot_path = GetSnapshotPath(dataset_path);
+  if (snapshot_path.empty()) {
+    return false;
+  }
+
+  // Touch the snapshot on every read so eviction can find the least recent
+  if (snapshot.Open(snapshot_path)) {
+    utime(snapshot_path.c_str(), nullptr);
+    return true;
+  }
+
+  if (!WriteSnapshot(dataset_path, snapshot_path)) {
+    return false;
+  }
+
+  Evict(snapshot_path);
+  return snapshot.Open(snapshot_path);
+}
+
+string DatasetCache::GetSnapshotPath(const string& dataset_path) const {
+  struct stat status;
+  std::ifstream input(dataset_path, std::ios::binary);
+  if (!input.is_open() || stat(dataset_path.c_str(), &status) != 0) {
+    return "";
+  }
+
+  // The same dataset can be named by many relative paths
+  char absolute_path[PATH_MAX];
+  string path = realpath(dataset_path.c_str(), absolute_path) != nullptr
+                    ? string(absolute_path)
+                    : dataset_path;
+
+  uint64_t key = HashBytes(kOffsetBasis, path.data(), path.size());
+  key = HashNumber(key, static_cast<uint64_t>(status.st_size));
+  key = HashNumber(key, static_cast<uint64_t>(status.st_mtime));
+
+  // Hashing the whole file would cost as much as reading it, so only both
+  // ends are hashed to catch a dataset rewritten within the same second
+  string block(kFingerprintBlockSize, '\0');
+  input.read(&block[0], static_cast<std::streamsize>(block.size()));
+  key = HashBytes(key, block.data(), static_cast<size_t>(input.gcount()));
+
+  uint64_t file_size = static_cast<uint64_t>(status.st_size);
+  if (file_size > 2 * kFingerprintBlockSize) {
+    input.clear();
+    input.seekg(static_cast<std::streamoff>(file_size - kFingerprintBlockSize));
+    input.read(&block[0], static_cast<std::streamsize>(block.size()));
+    key = HashBytes(key, block.data(), static_cast<size_t>(input.gcount()));
+  } else if (file_size > kFingerprintBlockSize) {
+    input.read(&block[0], static_cast<std::streamsize>(block.size()));
+    key = HashBytes(key, block.data(), static_cast<size_t>(input.gcount()));
+  }
+
+  std::ostringstream snapshot_path;
+  snapshot_path << directory_ << '/' << std::hex << std::setw(16)
+                << std::setfill('0') << key << kSnapshotExtension;
+  return snapshot_path.str();
+}
+
+bool DatasetCache::WriteSnapshot(const string& dataset_path,
+                                 const string& snapshot_path) const {
+  // Binary datasets are already as fast to read as their snapshot would be,
+  // but compressed ones are decompressed to write the snapshot of
+  std::ifstream plain_input(dataset_path, std::ios::binary);
+  CompressedFile compressed_file;
+  if (!plain_input.is_open() ||
+      plain_input.peek() == static_cast<unsigned char>(
+          ImageStream::kBinaryMagic.at(0))) {
+    return false;
+  }
+  std::istream& input = compressed_file.Open(dataset_path)
+                            ? compressed_file.GetStream()
+                            : plain_input;
+
+  // Another run may be writing the same snapshot, so each writes its own
+  mkdir(directory_.c_str(), 0755);
+  string temporary_path =
+      snapshot_path + ".tmp" + std::to_string(static_cast<long>(getpid()));
+  std::ofstream output(temporary_path, std::ios::binary);
+  if (!output.is_open()) {
+    return false;
+  }
+
+  try {
+    ImageStream image_stream(input);
+    ImageWriter image_writer(output, ImageWriter::Format::kBinary);
+    Image image;
+    while (image_stream.ReadImage(image)) {
+      image_writer.Write(image);
+    }
+  } catch (...) {
+    output.close();
+    std::remove(temporary_path.c_str());
+    throw;
+  }
+
+  output.close();
+  if (!output || std::rename(temporary_path.c_str(),
+                             snapshot_path.c_str()) != 0) {
+    std::remove(temporary_path.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+void DatasetCache::Evict(const string& kept_path) const {
+  DIR* directory = opendir(directory_.c_str());
+  if (max_size_ == 0 || directory == nullptr) {
+    if (directory != nullptr) {
+      closedir(directory);
+    }
+    return;
+  }
+
+  vector<Snapshot> snapshots;
+  uint64_t total_size = 0;
+  while (dirent* entry = readdir(directory)) {
+    string name = entry->d_name;
+    struct stat status;
+    string path = directory_ + '/' + name;
+    if (name.size() <= kSnapshotExtension.size() ||
+        name.compare(name.size() - kSnapshotExtension.size(),
+                     kSnapshotExtension.size(), kSnapshotExtension) != 0 ||
+        stat(path.c_str(), &status) != 0) {
+      continue;
+    }
+
+    snapshots.push_back({path, static_cast<uint64_t>(status.st_size),
+                         static_cast<int64_t>(status.st_mtime)});
+    total_size += static_cast<uint64_t>(status.st_size);
+  }
+  closedir(directory);
+
+  std::sort(snapshots.begin(), snapshots.end(),
+            [](const Snapshot& first, const Snapshot& second) {
+              return first.read_time < second.read_time;
+            });
+
+  for (const Snapshot& snapshot : snapshots) {
+    if (total_size <= max_size_) {
+      break;
+    } else if (snapshot.path != kept_path &&
+               std::remove(snapshot.path.c_str()) == 0) {
+      total_size -= snapshot.size;
+    }
+  }
+}
+
+} // namespace naivebayes
@@ -0,0 +1,314 @@
+#include "core/dataset_index.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include "core/compressed_file.h"
+#include "core/image_stream.h"
+#include "core/thread_pool.h"
+#include "core/trace.h"
+
+namespace naivebayes {
+
+using std::vector;
+using std::string;
+
+const string DatasetIndex::kIndexExtension = ".idx";
+const string DatasetIndex::kIndexMagic = "\x89NBI";
+
+namespace {
+
+/**
+ * Writes a number byte by byte, lowest byte first, so the file is the same on
+ * any machine.
+ */
+void WriteLittleEndian(std::ostream& output, uint64_t value) {
+  for (size_t byte = 0; byte < sizeof(value); byte++) {
+    output.put(static_cast<char>((value >> (8 * byte)) & 0xFF));
+  }
+}
+
+/**
+ * Reads a number written by WriteLittleEndian.
+ */
+bool ReadLittleEndian(std::istream& input, uint64_t& value) {
+  uint8_t bytes[sizeof(value)];
+  if (!input.read(reinterpret_cast<char*>(bytes), sizeof(bytes))) {
+    return false;
+  }
+
+  value = 0;
+  for (size_t byte = 0; byte < sizeof(value); byte++) {
+    value |= static_cast<uint64_t>(bytes[byte]) << (8 * byte);
+  }
+  return true;
+}
+
+} // namespace
+
+DatasetIndex::DatasetIndex()
+    : height_(0), width_(0), file_size_(0), modified_time_(0) {}
+
+DatasetIndex DatasetIndex::Build(std::istream& input) {
+  DatasetIndex index;
+  string line;
+
+  // The first image is over at the first line that is not image-wide, like
+  // ImageStream infers it
+  if (!getline(input, line) || line.empty()) {
+    throw std::invalid_argument("The provided training data file is empty.");
+  }
+  index.offsets_.push_back(0);
+  index.labels_.push_back(line.at(0));
+  uint64_t offset = line.size() + 1;
+
+  string first_row;
+  if (!getline(input, first_row)) {
+    throw std::invalid_argument("The images are not of uniform size");
+  }
+  offset += first_row.size() + 1;
+  index.width_ = first_row.size();
+  index.height_ = 1;
+
+  bool has_label = false;
+  while (getline(input, line)) {
+    if (line.size() != index.width_) {
+      has_label = true;
+      break;
+    }
+    offset += line.size() + 1;
+    index.height_++;
+  }
+
+  // Every following image is a label line and height_ image-wide lines
+  while (has_label) {
+    if (line.empty()) {
+      throw std::invalid_argument("Image is missing a label.");
+    }
+    index.offsets_.push_back(offset);
+    index.labels_.push_back(line.at(0));
+    offset += line.size() + 1;
+
+    for (size_t row = 0; row < index.height_; row++) {
+      if (!getline(input, line) || line.size() != index.width_) {
+        throw std::invalid_argument("The images are not of uniform size");
+      }
+      offset += line.size() + 1;
+    }
+
+    has_label = static_cast<bool>(getline(input, line));
+  }
+
+  index.file_size_ = offset;
+  return index;
+}
+
+bool DatasetIndex::LoadOrBuild(const string& dataset_path,
+                               DatasetIndex& index) {
+  uint64_t file_size;
+  int64_t modified_time;
+  if (!GetFileStatus(dataset_path, file_size, modified_time)) {
+    return false;
+  }
+
+  string index_path = dataset_path + kIndexExtension;
+  std::ifstream index_file(index_path, std::ios::binary);
+  if (index_file >> index && index.file_size_ == file_size &&
+      index.modified_time_ == modified_time) {
+    return true;
+  }
+
+  // Binary datasets have fixed size images, so they need no index, and
+  // compressed datasets can't be sought into
+  std::ifstream input(dataset_path, std::ios::binary);
+  if (!input.is_open() ||
+      input.peek() == static_cast<unsigned char>(
+          ImageStream::kBinaryMagic.at(0)) ||
+      CompressedFile::DetectFormat(input) != CompressedFile::Format::kNone) {
+    return false;
+  }
+
+  index = Build(input);
+  index.file_size_ = file_size;
+  index.modified_time_ = modified_time;
+
+  // The index can still be used if it can't be saved
+  std::ofstream output(index_path, std::ios::binary);
+  if (output.is_open()) {
+    output << index;
+  }
+
+  return true;
+}
+
+size_t DatasetIndex::GetImageCount() const {
+  return offsets_.size();
+}
+
+char DatasetIndex::GetLabel(size_t image_index) const {
+  return labels_.at(image_index);
+}
+
+Image DatasetIndex::ReadImage(std::istream& input, size_t image_index) const {
+  vector<Image> images;
+  ReadRange(input, image_index, image_index + 1, images);
+  return images.at(0);
+}
+
+void DatasetIndex::ReadImages(const string& dataset_path, size_t first_image,
+                              size_t end_image, size_t chunk_count,
+                              vector<Image>& images) const {
+  end_image = std::min(end_image, offsets_.size());
+  if (first_image >= end_image) {
+    return;
+  }
+
+  size_t image_count = end_image - first_image;
+  chunk_count = std::max<size_t>(1, std::min(chunk_count, image_count));
+  vector<vector<Image>> chunks(chunk_count);
+
+  // Each task parses a contiguous range of images with its own file handle
+  ThreadPool::GetShared().ParallelFor(0, chunk_count, 1,
+                                      [&](size_t first, size_t last) {
+    for (size_t chunk = first; chunk < last; chunk++) {
+      TraceSpan span("Parse dataset chunk");
+      size_t chunk_first = first_image + chunk * image_count / chunk_count;
+      size_t chunk_end = first_image + (chunk + 1) * image_count / chunk_count;
+
+      std::ifstream input(dataset_path, std::ios::binary);
+      ReadRange(input, chunk_first, chunk_end, chunks[chunk]);
+    }
+  });
+
+  images.reserve(images.size() + image_count);
+  for (vector<Image>& chunk : chunks) {
+    std::move(chunk.begin(), chunk.end(), std::back_inserter(images));
+  }
+}
+
+bool DatasetIndex::ReadDataset(const string& dataset_path, size_t chunk_count,
+                               Dataset& dataset) const {
+  if (offsets_.empty()) {
+    return false;
+  }
+
+  vector<Image> images;
+  ReadImages(dataset_path, 0, offsets_.size(), chunk_count, images);
+
+  // Add the images in order so every label group keeps the order of the file
+  for (const Image& image : images) {
+    dataset.AddImage(image);
+  }
+
+  return true;
+}
+
+void DatasetIndex::ReadRange(std::istream& input, size_t first_image,
+                             size_t end_image, vector<Image>& images) const {
+  uint64_t begin_offset = offsets_.at(first_image);
+  uint64_t end_offset =
+      end_image < offsets_.size() ? offsets_[end_image] : file_size_;
+
+  // Read the whole range at once, then parse it from memory
+  string bytes(end_offset - begin_offset, '\0');
+  input.clear();
+  input.seekg(static_cast<std::streamoff>(begin_offset));
+  input.read(&bytes[0], static_cast<std::streamsize>(bytes.size()));
+  bytes.resize(static_cast<size_t>(input.gcount()));
+
+  std::istringstream range(bytes);
+  string line;
+  images.reserve(images.size() + end_image - first_image);
+  for (size_t image = first_image; image < end_image; image++) {
+    if (!getline(range, line) || line.empty() ||
+        line.at(0) != labels_[image]) {
+      throw std::invalid_argument("The dataset does not match its index.");
+    }
+
+    vector<vector<Shading>> pixels(height_, vector<Shading>(width_));
+    for (size_t row = 0; row < height_; row++) {
+      if (!getline(range, line) || line.size() != width_) {
+        throw std::invalid_argument("The images are not of uniform size");
+      }
+
+      for (size_t column = 0; column < width_; column++) {
+        pixels[row][column] = Image::kPixelShadings.at(line[column]);
+      }
+    }
+
+    images.emplace_back(pixels, labels_[image]);
+  }
+}
+
+bool DatasetIndex::GetFileStatus(const string& path, uint64_t& file_size,
+                                 int64_t& modified_time) {
+  struct stat status;
+  if (stat(path.c_str(), &status) != 0) {
+    return false;
+  }
+
+  file_size = static_cast<uint64_t>(status.st_size);
+  modified_time = static_cast<int64_t>(status.st_mtime);
+  return true;
+}
+
+std::ostream& operator<<(std::ostream& output, const DatasetIndex& index) {
+  output << DatasetIndex::kIndexMagic;
+  WriteLittleEndian(output, index.file_size_);
+  WriteLittleEndian(output, static_cast<uint64_t>(index.modified_time_));
+  WriteLittleEndian(output, index.height_);
+  WriteLittleEndian(output, index.width_);
+  WriteLittleEndian(output, index.offsets_.size());
+
+  for (size_t image = 0; image < index.offsets_.size(); image++) {
+    WriteLittleEndian(output, index.offsets_[image]);
+    output.put(index.labels_[image]);
+  }
+
+  return output;
+}
+
+std::istream& operator>>(std::istream& input, DatasetIndex& index) {
+  index = DatasetIndex();
+
+  string magic(DatasetIndex::kIndexMagic.size(), '\0');
+  uint64_t modified_time;
+  uint64_t height;
+  uint64_t width;
+  uint64_t image_count;
+  if (!input.read(&magic[0], magic.size()) ||
+      magic != DatasetIndex::kIndexMagic ||
+      !ReadLittleEndian(input, index.file_size_) ||
+      !ReadLittleEndian(input, modified_time) ||
+      !ReadLittleEndian(input, height) || !ReadLittleEndian(input, width) ||
+      !ReadLittleEndian(input, image_count)) {
+    input.setstate(std::ios::failbit);
+    return input;
+  }
+
+  index.modified_time_ = static_cast<int64_t>(modified_time);
+  index.height_ = height;
+  index.width_ = width;
+
+  // Don't trust the count to reserve with, a corrupt index could be huge
+  for (uint64_t image = 0; image < image_count; image++) {
+    uint64_t offset;
+    char label;
+    if (!ReadLittleEndian(input, offset) || !input.get(label)) {
+      index = DatasetIndex();
+      input.setstate(std::ios::failbit);
+      return input;
+    }
+
+    index.offsets_.push_back(offset);
+    index.labels_.push_back(label);
+  }
+
+  return input;
+}
+
+} // namespace naivebayes
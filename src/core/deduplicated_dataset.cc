@@ -0,0 +1,79 @@
+#include "core/deduplicated_dataset.h"
+
+#include <algorithm>
+
+namespace naivebayes {
+
+using std::vector;
+
+DeduplicatedDataset::DeduplicatedDataset()
+    : height_(0), width_(0), packed_size_(0), image_count_(0) {}
+
+bool DeduplicatedDataset::AddImage(const Image& image) {
+  return AddImage(image, 1);
+}
+
+bool DeduplicatedDataset::AddImage(const Image& image, double weight) {
+  if (image_count_ == 0) {
+    height_ = image.GetHeight();
+    width_ = image.GetWidth();
+    packed_size_ = Image::GetPackedSize(height_, width_);
+  } else if (image.GetHeight() != height_ || image.GetWidth() != width_) {
+    throw std::invalid_argument("The images are not of uniform size");
+  }
+
+  vector<uint8_t> packed = image.Pack();
+  uint64_t hash = Image::HashPacked(packed, height_, width_, image.GetLabel());
+  image_count_++;
+
+  // Compare the pixels too, since different images can share a hash
+  auto matches = index_.equal_range(hash);
+  for (auto match = matches.first; match != matches.second; match++) {
+    size_t entry = match->second;
+    if (labels_[entry] == image.GetLabel() &&
+        std::equal(packed.begin(), packed.end(),
+                   packed_pixels_.begin() + entry * packed_size_)) {
+      multiplicities_[entry]++;
+      weights_[entry] += weight;
+      return false;
+    }
+  }
+
+  index_.emplace(hash, labels_.size());
+  labels_.push_back(image.GetLabel());
+  multiplicities_.push_back(1);
+  weights_.push_back(weight);
+  packed_pixels_.insert(packed_pixels_.end(), packed.begin(), packed.end());
+  return true;
+}
+
+size_t DeduplicatedDataset::GetImageCount() const {
+  return image_count_;
+}
+
+size_t DeduplicatedDataset::GetEntryCount() const {
+  return labels_.size();
+}
+
+double DeduplicatedDataset::GetDedupRatio() const {
+  if (labels_.empty()) {
+    return 1;
+  }
+
+  return static_cast<double>(image_count_) / labels_.size();
+}
+
+Image DeduplicatedDataset::GetImage(size_t entry) const {
+  return Image::Unpack(packed_pixels_.data() + entry * packed_size_, height_,
+                       width_, labels_.at(entry));
+}
+
+size_t DeduplicatedDataset::GetMultiplicity(size_t entry) const {
+  return multiplicities_.at(entry);
+}
+
+double DeduplicatedDataset::GetWeight(size_t entry) const {
+  return weights_.at(entry);
+}
+
+} // namespace naivebayes
@@ -4,8 +4,23 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <utility>
 
+#include "core/cascade_classifier.h"
+#include "core/classification_cache.h"
+#include "core/dataset_index.h"
+#include "core/deduplicated_dataset.h"
 #include "core/executable_logic.h"
+#include "core/image_stream.h"
+#include "core/image_writer.h"
+#include "core/progress_reporter.h"
+#include "core/thread_pool.h"
+#include "core/trace.h"
 
 namespace naivebayes {
 
@@ -19,13 +34,82 @@ const string ExecutableLogic::kTestingModelMessage = "Testing model...";
 
 const string ExecutableLogic::kTrainingModelMessage = "Training model...";
 
+const string ExecutableLogic::kCrossValidatingMessage = 
+    "Cross validating model...";
+const string ExecutableLogic::kTooFewImagesMessage = 
+    "There must be at least as many images as folds!";
+const string ExecutableLogic::kFoldAccuracyMessage = "Accuracy of fold ";
+const string ExecutableLogic::kMeanAccuracyMessage = "Mean accuracy: ";
+
 const string ExecutableLogic::kLoadingModelMessage = "Loading model...";
 const string ExecutableLogic::kLoadingConflictMessage = 
     "You must either train a model or load a model, not both!";
 
+const string ExecutableLogic::kSavingCountsMessage = "Saving counts...";
+const string ExecutableLogic::kSavingTraceMessage = "Saving trace...";
+const string ExecutableLogic::kTrainingProgressPhase = "Training";
+const string ExecutableLogic::kParsingProgressPhase = "Parsing";
+const string ExecutableLogic::kMergingCountsMessage = "Merging counts from ";
+const string ExecutableLogic::kNoCountsMessage =
+    "Counts can only be saved for a model trained in this run!";
+
+const string ExecutableLogic::kPruningModelMessage = "Pruning model...";
+const string ExecutableLogic::kPixelsKeptMessage = "Pixels kept: ";
+const string ExecutableLogic::kDedupImagesMessage = "Training images: ";
+const string ExecutableLogic::kDedupDistinctMessage = "Distinct images: ";
+const string ExecutableLogic::kDedupRatioMessage = "Dedup ratio: ";
+const string ExecutableLogic::kPruneReportMessage = 
+    "Accuracy by fraction of pixels kept:";
+
+const vector<float> ExecutableLogic::kPruneReportFractions = 
+    {1.0f, 0.5f, 0.25f, 0.1f, 0.05f, 0.02f};
+
+const string ExecutableLogic::kCalibratingCascadeMessage = 
+    "Calibrating cascade...";
+const string ExecutableLogic::kCascadePixelsMessage = "Stage one pixels: ";
+const string ExecutableLogic::kCascadeThresholdMessage = "Margin threshold: ";
+const string ExecutableLogic::kCascadeAccuracyMessage = "Cascade accuracy: ";
+const string ExecutableLogic::kEscalatedFractionMessage = 
+    "Fraction of images escalated: ";
+const string ExecutableLogic::kModelThroughputMessage = 
+    "Model images per second: ";
+const string ExecutableLogic::kCascadeThroughputMessage = 
+    "Cascade images per second: ";
+
+const string ExecutableLogic::kClassifyingMessage = "Classifying images...";
+const string ExecutableLogic::kClassifiedCountMessage = "Images classified: ";
+const string ExecutableLogic::kImageSizeMismatchMessage = 
+    "This image isn't the size of the model: ";
+const string ExecutableLogic::kCacheHitsMessage = "Cache hits: ";
+const string ExecutableLogic::kCacheMissesMessage = "Cache misses: ";
+const string ExecutableLogic::kCacheEvictionsMessage = "Cache evictions: ";
+const string ExecutableLogic::kConvertingMessage = "Converting dataset...";
+const string ExecutableLogic::kSampledMessage = "sampled ";
+const string ExecutableLogic::kReadBandwidthMessage = "Read bandwidth: ";
+const string ExecutableLogic::kReadBandwidthUnit = " MB/s";
+const string ExecutableLogic::kNodeThroughputMessage = "Node ";
+const string ExecutableLogic::kNodeThroughputUnit = " images per second: ";
+const string ExecutableLogic::kCountersUnavailableMessage = 
+    "Hardware counters are unavailable: ";
+const string ExecutableLogic::kTrainingCountersMessage = "Training counters:";
+const string ExecutableLogic::kTestingCountersMessage = "Testing counters:";
+const string ExecutableLogic::kClassifyingCountersMessage = 
+    "Classifying counters:";
+const string ExecutableLogic::kInstructionsPerCycleMessage = 
+    "  Instructions per cycle: ";
+const string ExecutableLogic::kL1MissesMessage = "  L1 misses per image: ";
+const string ExecutableLogic::kLlcMissesMessage = "  LLC misses per image: ";
+const string ExecutableLogic::kBranchMissesMessage = 
+    "  Branch misses per image: ";
+const string ExecutableLogic::kCounterUnavailableMessage = "unavailable";
+
+const string ExecutableLogic::kStandardStreamPath = "-";
+
 const string ExecutableLogic::kSavingModelMessage = "Saving model...";
 const string ExecutableLogic::kSavingConfusionMatrixMessage = 
     "Saving confusion matrix...";
+const string ExecutableLogic::kSavingPredictionsMessage = 
+    "Saving predictions...";
 const string ExecutableLogic::kConfusionMatrixColumnLabel = "Predicted";
 const string ExecutableLogic::kConfusionMatrixRowLabel = "Actual";
 const string ExecutableLogic::kConfusionMatrixLabelIndicator = "Label";
@@ -34,91 +118,493 @@ const string ExecutableLogic::kFinishedMessage = "done.";
 const string ExecutableLogic::kFailedMessage = "failed.";
 
 ExecutableLogic::ExecutableLogic(size_t laplace_factor) 
-    : model_(Model(laplace_factor)) {}
+    : model_(Model(laplace_factor)),
+      message_output_(&std::cout),
+      is_indexing_datasets_(false),
+      is_reading_ahead_(false),
+      is_printing_verbose_(false) {}
+
+int ExecutableLogic::Execute(const ExecutionFlags& flags) {
+  // Predictions are piped from stdout, so nothing else may be printed there
+  if (!flags.classify_.empty()) {
+    message_output_ = &std::cerr;
+  }
+
+  try {
+    sampler_ = CreateSampler(flags);
+    is_indexing_datasets_ = flags.is_indexing_datasets_;
+    is_reading_ahead_ = flags.is_reading_ahead_;
+    is_printing_verbose_ = flags.is_printing_verbose_;
+    Tracer::SetEnabled(!flags.trace_out_.empty());
+    ThreadPool::Placement placement = ThreadPool::Placement::kAnywhere;
+    if (flags.is_replicating_model_) {
+      placement = ThreadPool::Placement::kReplicated;
+    } else if (flags.is_pinning_threads_) {
+      placement = ThreadPool::Placement::kPinned;
+    }
+
+    // Counters only count threads started after they are opened, so they
+    // must be opened before the pool's workers are
+    if (flags.is_printing_metrics_ && !perf_counters_.Open()) {
+      *message_output_ << kCountersUnavailableMessage;
+      *message_output_ << perf_counters_.GetError() << std::endl;
+    }
+    ThreadPool::GetShared().SetThreadCount(flags.thread_count_, placement);
+    dataset_cache_ = DatasetCache(flags.dataset_cache_,
+                                  flags.dataset_cache_mb_ * kBytesPerMegabyte);
+  } catch (const std::invalid_argument& error) {
+    *message_output_ << error.what() << std::endl;
+    return EXIT_FAILURE;
+  }
 
-int ExecutableLogic::Execute(const string& train_flag, const string& load_flag, 
-                             const string& save_flag, const string& test_flag,
-                             const string& confusion_flag, 
-                             bool is_printing_verbose) {
   // We can't allow the user to both train a model and load a model
-  bool should_train = !train_flag.empty();
-  bool should_load = !load_flag.empty();
-  
-  if (should_train && should_load) {
-    std::cout << kLoadingConflictMessage;
-    std::cout << std::endl;
+  bool should_train = !flags.train_.empty();
+  bool should_load = !flags.load_.empty();
 
-    return EXIT_FAILURE; 
-  } else if (should_train) {
-    TrainModel(train_flag);
-  } else if (should_load) {
-    LoadModel(load_flag);
+  // Datasets and weights files are only checked as they are read
+  try {
+    if (!flags.convert_.empty()) {
+      ConvertDataset(flags.convert_, flags.convert_out_, flags.weights_);
+    }
+
+    if (should_train && should_load) {
+      *message_output_ << kLoadingConflictMessage;
+      *message_output_ << std::endl;
+
+      return EXIT_FAILURE; 
+    } else if (should_train && flags.fold_count_ > 0) {
+      if (!CrossValidateModel(flags.train_, flags.fold_count_,
+                              flags.fold_confusion_, flags.weights_,
+                              flags.is_balancing_classes_)) {
+        return EXIT_FAILURE;
+      }
+    } else if (should_train) {
+      TrainModel(flags.train_, flags.shard_index_, flags.shard_count_,
+                 flags.is_deduplicating_, flags.weights_,
+                 flags.is_balancing_classes_);
+    } else if (should_load) {
+      LoadModel(flags.load_);
+    }
+  } catch (const std::invalid_argument& error) {
+    *message_output_ << kFailedMessage << std::endl;
+    *message_output_ << error.what() << std::endl;
+    return EXIT_FAILURE;
   }
 
-  if (!save_flag.empty()) {
-    SaveModel(save_flag);
+  // Report on the model as trained or loaded, before it is pruned
+  bool has_model = should_train || should_load;
+  if (flags.is_printing_prune_report_ && has_model) {
+    ReportPruning(flags.test_);
+  }
+
+  if (has_model && (flags.prune_top_ > 0 || flags.prune_below_ > 0)) {
+    *message_output_ << kPruningModelMessage;
+    if (flags.prune_top_ > 0) {
+      model_.Prune(flags.prune_top_);
+    }
+    if (flags.prune_below_ > 0) {
+      model_.PruneBelow(flags.prune_below_);
+    }
+    *message_output_ << kFinishedMessage << std::endl;
+
+    *message_output_ << kPixelsKeptMessage;
+    *message_output_ << model_.GetRetainedPixels().size() << " of ";
+    *message_output_ << model_.GetImageHeight() * model_.GetImageWidth();
+    *message_output_ << std::endl;
+  }
+
+  if (!flags.save_.empty()) {
+    SaveModel(flags.save_);
+  }
+
+  // Only a model trained here has counts, a loaded model only has likelihoods
+  if (!flags.save_counts_.empty()) {
+    if (!should_train) {
+      *message_output_ << kNoCountsMessage << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    SaveCounts(flags.save_counts_);
   }
   
   // We can only test if we have a dataset and have a model loaded
-  if (!test_flag.empty() && (should_train || should_load)) {
-    TestModel(test_flag, confusion_flag, is_printing_verbose);
+  if (!flags.test_.empty() && (should_train || should_load)) {
+    TestModel(flags.test_, flags.confusion_, flags.is_printing_verbose_,
+              flags.predictions_, flags.top_k_);
+  }
+
+  if (!flags.cascade_.empty() && (should_train || should_load)) {
+    CascadeModel(flags.cascade_, flags.cascade_tolerance_, flags.test_);
+  }
+
+  if (!flags.classify_.empty() && (should_train || should_load) &&
+      !ClassifyImages(flags.classify_, flags.is_printing_scores_,
+                      flags.cache_size_)) {
+    return EXIT_FAILURE;
+  }
+
+  if (!flags.trace_out_.empty()) {
+    SaveTrace(flags.trace_out_);
   }
   
   return EXIT_SUCCESS;
 }
 
+int ExecutableLogic::Merge(const vector<string>& checkpoint_paths,
+                           const string& save_flag,
+                           const string& save_counts_flag) {
+  counts_ = TrainingCounts();
+
+  // Summing counts is exact, so the order the checkpoints are merged is moot
+  for (const string& checkpoint_path : checkpoint_paths) {
+    std::ifstream checkpoint_file(checkpoint_path);
+
+    *message_output_ << kMergingCountsMessage << checkpoint_path << "...";
+    if (!checkpoint_file.is_open()) {
+      *message_output_ << kFailedMessage << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // A shard that failed partway leaves a truncated or malformed checkpoint
+    try {
+      TrainingCounts checkpoint;
+      checkpoint_file >> checkpoint;
+      counts_.Merge(checkpoint);
+    } catch (const nlohmann::json::exception& error) {
+      *message_output_ << kFailedMessage << std::endl;
+      *message_output_ << checkpoint_path << ": " << error.what() << std::endl;
+      return EXIT_FAILURE;
+    } catch (const std::invalid_argument& error) {
+      *message_output_ << kFailedMessage << std::endl;
+      *message_output_ << checkpoint_path << ": " << error.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+    *message_output_ << kFinishedMessage << std::endl;
+  }
+
+  *message_output_ << kTrainingModelMessage;
+  if (counts_.GetImageCount() == 0) {
+    *message_output_ << kFailedMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  model_.Train(counts_);
+  *message_output_ << kFinishedMessage << std::endl;
+
+  if (!save_flag.empty()) {
+    SaveModel(save_flag);
+  }
+
+  if (!save_counts_flag.empty()) {
+    SaveCounts(save_counts_flag);
+  }
+
+  return EXIT_SUCCESS;
+}
+
 void ExecutableLogic::SaveModel(const string& file_path) const {
+  TraceSpan span("Save model");
   std::ofstream output_file(file_path);
 
-  std::cout << kSavingModelMessage;
+  *message_output_ << kSavingModelMessage;
   if (output_file.is_open()) {
     output_file << model_;  // Serialize the model and save to the given file
-    std::cout << kFinishedMessage << std::endl;
+    *message_output_ << kFinishedMessage << std::endl;
+  } else {
+    *message_output_ << kFailedMessage << std::endl;
+  }
+}
+
+void ExecutableLogic::SaveCounts(const string& file_path) const {
+  TraceSpan span("Save counts");
+  std::ofstream output_file(file_path);
+
+  *message_output_ << kSavingCountsMessage;
+  if (output_file.is_open()) {
+    output_file << counts_;  // Serialize the counts and save to the given file
+    *message_output_ << kFinishedMessage << std::endl;
   } else {
-    std::cout << kFailedMessage << std::endl;
+    *message_output_ << kFailedMessage << std::endl;
+  }
+}
+
+void ExecutableLogic::SaveTrace(const string& file_path) const {
+  std::ofstream output_file(file_path);
+
+  *message_output_ << kSavingTraceMessage;
+  if (output_file.is_open()) {
+    Tracer::Write(output_file);
+    *message_output_ << kFinishedMessage << std::endl;
+  } else {
+    *message_output_ << kFailedMessage << std::endl;
   }
 }
 
 void ExecutableLogic::LoadModel(const string& model_path) {
+  TraceSpan span("Load model");
   std::ifstream model_file(model_path);
 
-  std::cout << kLoadingModelMessage;
+  *message_output_ << kLoadingModelMessage;
   if (model_file.is_open()) {
     model_file >> model_;  // Deserialize the model and load it in the stack
-    std::cout << kFinishedMessage << std::endl;
+    *message_output_ << kFinishedMessage << std::endl;
   } else {
-    std::cout << kFailedMessage << std::endl;
+    *message_output_ << kFailedMessage << std::endl;
   }
 }
 
-void ExecutableLogic::TrainModel(const string& dataset_path) {
-  std::ifstream input_file(dataset_path);
+void ExecutableLogic::TrainModel(const string& dataset_path,
+                                 size_t shard_index, size_t shard_count,
+                                 bool is_deduplicating,
+                                 const string& weights_path,
+                                 bool is_balancing_classes) {
+  *message_output_ << kTrainingModelMessage;
+  DatasetIndex index;
+  bool is_indexed = LoadIndex(dataset_path, index);
+  DatasetFiles dataset_files;
+  std::istream* input =
+      is_indexed ? nullptr : OpenDataset(dataset_path, dataset_files);
+  std::ifstream weights_file;
+  if (!weights_path.empty()) {
+    weights_file.open(weights_path);
+  }
 
-  std::cout << kTrainingModelMessage;
-  if (input_file.is_open()) {
-    Dataset dataset = Dataset();
-    input_file >> dataset;  // Add images from the training file to the dataset
-    
-    model_.Train(dataset);
-    std::cout << kFinishedMessage << std::endl;
+  if ((is_indexed || input != nullptr) &&
+      (weights_path.empty() || weights_file)) {
+    perf_counters_.Start();
+    counts_ = TrainingCounts();
+    DeduplicatedDataset distinct_images;
+    vector<Image> chunk;
+    vector<double> weights;
+    size_t image_index = 0;
+
+    // An indexed dataset is parsed on the pool, anything else as a stream
+    std::unique_ptr<ImageStream> image_stream;
+    if (!is_indexed) {
+      image_stream.reset(new ImageStream(*input));
+    }
+    ImageSampler sampler = sampler_;
+    size_t next_image = 0;
+    std::istream* weights_input =
+        weights_path.empty() ? nullptr : &weights_file;
+
+    std::unique_ptr<ProgressReporter> progress;
+    if (is_printing_verbose_) {
+      progress.reset(new ProgressReporter(*message_output_,
+                                          kTrainingProgressPhase, 0));
+    }
+
+    // Count one chunk of images at a time so memory does not grow with the file
+    while (is_indexed ? ReadIndexedChunk(dataset_path, index, weights_input,
+                                         next_image, chunk, weights)
+                      : ReadWeightedChunk(*image_stream, weights_input,
+                                          sampler, chunk, weights)) {
+      if (progress) {
+        progress->Add(chunk.size());
+      }
+
+      // Keep only this shard's images, moved to the front of the chunk
+      size_t shard_size = 0;
+      for (size_t index = 0; index < chunk.size(); index++, image_index++) {
+        if (image_index % shard_count != shard_index) {
+          continue;
+        } else if (shard_size != index) {
+          chunk[shard_size] = std::move(chunk[index]);
+          weights[shard_size] = weights[index];
+        }
+        shard_size++;
+      }
+      chunk.resize(shard_size);
+      weights.resize(shard_size);
+
+      if (is_deduplicating) {
+        for (size_t index = 0; index < chunk.size(); index++) {
+          distinct_images.AddImage(chunk[index], weights[index]);
+        }
+      } else {
+        counts_.AddImages(chunk, weights);
+      }
+    }
+
+    if (progress) {
+      progress->Stop();
+    }
+
+    // Count each distinct image once, weighted by how often it was read
+    counts_.AddDataset(distinct_images);
+    TrainOnCounts(is_balancing_classes);
+    PerfCounters::Reading reading = perf_counters_.Stop();
+    *message_output_ << kFinishedMessage << std::endl;
+    ReportReadBandwidth(dataset_files);
+    ReportCounters(kTrainingCountersMessage, image_index, reading);
+
+    if (is_deduplicating) {
+      *message_output_ << kDedupImagesMessage;
+      *message_output_ << distinct_images.GetImageCount() << std::endl;
+      *message_output_ << kDedupDistinctMessage;
+      *message_output_ << distinct_images.GetEntryCount() << std::endl;
+      *message_output_ << kDedupRatioMessage;
+      *message_output_ << distinct_images.GetDedupRatio() << std::endl;
+    }
   } else {
-    std::cout << kFailedMessage << std::endl;
+    *message_output_ << kFailedMessage << std::endl;
+  }
+}
+
+bool ExecutableLogic::CrossValidateModel(const string& dataset_path,
+                                         size_t fold_count,
+                                         const string& confusion_csv_path,
+                                         const string& weights_path,
+                                         bool is_balancing_classes) {
+  *message_output_ << kCrossValidatingMessage << std::endl;
+  DatasetIndex index;
+  bool is_indexed = LoadIndex(dataset_path, index);
+  DatasetFiles dataset_files;
+  std::istream* input =
+      is_indexed ? nullptr : OpenDataset(dataset_path, dataset_files);
+  std::ifstream weights_file;
+  if (!weights_path.empty()) {
+    weights_file.open(weights_path);
+  }
+
+  if ((!is_indexed && input == nullptr) ||
+      (!weights_path.empty() && !weights_file)) {
+    *message_output_ << kFailedMessage << std::endl;
+    return false;
+  }
+
+  // An indexed dataset is parsed on the pool, anything else as a stream
+  std::unique_ptr<ImageStream> image_stream;
+  if (!is_indexed) {
+    image_stream.reset(new ImageStream(*input));
+  }
+  vector<TrainingCounts> fold_counts(fold_count);
+  vector<Dataset> fold_datasets(fold_count);
+  counts_ = TrainingCounts();
+
+  // Count every fold in a single pass, keeping the images to test on later
+  ImageSampler sampler = sampler_;
+  size_t next_image = 0;
+  std::istream* weights_input = weights_path.empty() ? nullptr : &weights_file;
+  vector<Image> chunk;
+  vector<double> weights;
+  size_t image_count = 0;
+  while (is_indexed ? ReadIndexedChunk(dataset_path, index, weights_input,
+                                       next_image, chunk, weights)
+                    : ReadWeightedChunk(*image_stream, weights_input, sampler,
+                                        chunk, weights)) {
+    // Each fold is counted by a task of its own, which only reads the chunk
+    ThreadPool::GetShared().ParallelFor(0, fold_count, 1,
+                                        [&](size_t first, size_t last) {
+      TraceSpan span("Count folds");
+      for (size_t fold = first; fold < last; fold++) {
+        size_t index = (fold + fold_count - image_count % fold_count) %
+                       fold_count;
+        for (; index < chunk.size(); index += fold_count) {
+          fold_counts.at(fold).AddImage(chunk[index], weights[index]);
+        }
+      }
+    });
+
+    for (size_t index = 0; index < chunk.size(); index++, image_count++) {
+      fold_datasets.at(image_count % fold_count).AddImage(chunk[index]);
+    }
+  }
+
+  // The folds split every image between them, so they sum to the total
+  for (const TrainingCounts& counts : fold_counts) {
+    counts_.Merge(counts);
+  }
+
+  ReportReadBandwidth(dataset_files);
+  if (image_count < fold_count) {
+    *message_output_ << kTooFewImagesMessage << std::endl;
+    return false;
+  }
+
+  // Every fold model keeps all labels, so their confusion matrices line up
+  vector<vector<vector<size_t>>> fold_matrices(fold_count);
+  ThreadPool::GetShared().ParallelFor(0, fold_count, 1,
+                                      [&](size_t first, size_t last) {
+    for (size_t fold = first; fold < last; fold++) {
+      TrainingCounts training_counts = counts_;
+      training_counts.Subtract(fold_counts.at(fold));
+      if (is_balancing_classes) {
+        training_counts.BalanceClasses();
+      }
+
+      Model fold_model = model_;  // copies the smoothing factor to use
+      fold_model.Train(training_counts);
+      fold_matrices.at(fold) = fold_model.Test(fold_datasets.at(fold), false);
+    }
+  });
+
+  TrainOnCounts(is_balancing_classes);
+
+  vector<vector<size_t>> summed_matrix = fold_matrices.at(0);
+  float accuracy_sum = 0;
+  for (size_t fold = 0; fold < fold_count; fold++) {
+    float accuracy = Model::CalculateAccuracy(fold_matrices.at(fold));
+    accuracy_sum += accuracy;
+    *message_output_ << kFoldAccuracyMessage << fold << ": " << accuracy;
+    *message_output_ << std::endl;
+
+    // The first fold's matrix is already in the sum
+    for (size_t row = 0; fold > 0 && row < summed_matrix.size(); row++) {
+      for (size_t col = 0; col < summed_matrix.size(); col++) {
+        summed_matrix.at(row).at(col) += fold_matrices.at(fold).at(row).at(col);
+      }
+    }
   }
+
+  *message_output_ << kMeanAccuracyMessage;
+  *message_output_ << accuracy_sum / static_cast<float>(fold_count);
+  *message_output_ << std::endl;
+
+  if (!confusion_csv_path.empty()) {
+    SaveConfusionMatrix(confusion_csv_path, summed_matrix);
+  }
+
+  return true;
 }
 
 void ExecutableLogic::TestModel(const string& dataset_path,
                                 const string& confusion_csv_path,
-                                bool is_printing_verbose) const {
-  std::ifstream input_file(dataset_path);
-
-  std::cout << kTestingModelMessage << std::endl;
-  if (input_file.is_open()) {
-    Dataset dataset = Dataset();
-    input_file >> dataset; // Add images from the training file to the dataset
+                                bool is_printing_verbose,
+                                const string& predictions_path,
+                                size_t top_k) const {
+  *message_output_ << kTestingModelMessage << std::endl;
+  Dataset dataset = Dataset();
+  if (LoadDataset(dataset_path, dataset)) {
     
+    ThreadPool::GetShared().ResetNodeIndexCounts();
+    auto start = std::chrono::steady_clock::now();
+    perf_counters_.Start();
+
     // Test the model via the method defined with command line flags
-    vector<vector<size_t>> confusion_matrix 
-        = model_.Test(dataset, is_printing_verbose);
+    TraceSpan span("Test model");
+    vector<vector<size_t>> confusion_matrix;
+    if (predictions_path.empty()) {
+      confusion_matrix = model_.Test(dataset, is_printing_verbose,
+                                     message_output_);
+    } else {
+      std::ofstream predictions_file(predictions_path);
+
+      *message_output_ << kSavingPredictionsMessage;
+      if (!predictions_file.is_open()) {
+        *message_output_ << kFailedMessage << std::endl;
+        return;
+      }
+
+      confusion_matrix = model_.Test(dataset, top_k, predictions_file);
+      *message_output_ << kFinishedMessage << std::endl;
+    }
+
+    PerfCounters::Reading reading = perf_counters_.Stop();
+    std::chrono::duration<double> seconds =
+        std::chrono::steady_clock::now() - start;
+    ReportNodeThroughput(seconds.count());
+    ReportCounters(kTestingCountersMessage, dataset.GetSize(), reading);
     
     // Save the confusion matrix, if specified
     if (!confusion_csv_path.empty()) {
@@ -126,17 +612,519 @@ void ExecutableLogic::TestModel(const string& dataset_path,
     }
     
     float score = Model::CalculateAccuracy(confusion_matrix);
-    std::cout << kModelAccuracyMessage << score << std::endl;
+    *message_output_ << kModelAccuracyMessage << score << std::endl;
+  } else {
+    *message_output_ << kFailedMessage << std::endl;
+  }
+}
+
+void ExecutableLogic::ReportPruning(const string& test_path) const {
+  *message_output_ << kPruneReportMessage << std::endl;
+  Dataset dataset;
+  if (!LoadDataset(test_path, dataset)) {
+    *message_output_ << kFailedMessage << std::endl;
+    return;
+  }
+
+  size_t pixel_count = model_.GetImageHeight() * model_.GetImageWidth();
+
+  for (float fraction : kPruneReportFractions) {
+    auto kept_pixel_count = static_cast<size_t>(
+        std::round(fraction * static_cast<float>(pixel_count)));
+
+    Model pruned_model = model_;
+    pruned_model.Prune(kept_pixel_count);
+    float accuracy = 
+        Model::CalculateAccuracy(pruned_model.Test(dataset, false));
+
+    *message_output_ << fraction << " (" << kept_pixel_count << " of ";
+    *message_output_ << pixel_count << "): " << accuracy << std::endl;
+  }
+}
+
+void ExecutableLogic::CascadeModel(const string& calibration_path,
+                                   float tolerance,
+                                   const string& test_path) const {
+  *message_output_ << kCalibratingCascadeMessage;
+  Dataset calibration_dataset;
+  if (!LoadDataset(calibration_path, calibration_dataset)) {
+    *message_output_ << kFailedMessage << std::endl;
+    return;
+  }
+
+  CascadeClassifier cascade(model_);
+  cascade.Calibrate(calibration_dataset, tolerance);
+  *message_output_ << kFinishedMessage << std::endl;
+
+  *message_output_ << kCascadePixelsMessage << cascade.GetPixelCount();
+  *message_output_ << " of ";
+  *message_output_ << model_.GetImageHeight() * model_.GetImageWidth();
+  *message_output_ << std::endl;
+  *message_output_ << kCascadeThresholdMessage << cascade.GetMarginThreshold();
+  *message_output_ << std::endl;
+
+  Dataset test_dataset;
+  if (!LoadDataset(test_path, test_dataset)) {
+    test_dataset = calibration_dataset;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  vector<vector<size_t>> model_matrix = model_.Test(test_dataset, false);
+  auto model_end = std::chrono::steady_clock::now();
+  size_t escalated_count = 0;
+  vector<vector<size_t>> cascade_matrix = 
+      cascade.Test(test_dataset, escalated_count);
+  auto cascade_end = std::chrono::steady_clock::now();
+
+  auto image_count = static_cast<double>(test_dataset.GetSize());
+  std::chrono::duration<double> model_seconds = model_end - start;
+  std::chrono::duration<double> cascade_seconds = cascade_end - model_end;
+
+  *message_output_ << kModelAccuracyMessage;
+  *message_output_ << Model::CalculateAccuracy(model_matrix) << std::endl;
+  *message_output_ << kCascadeAccuracyMessage;
+  *message_output_ << Model::CalculateAccuracy(cascade_matrix) << std::endl;
+  *message_output_ << kEscalatedFractionMessage;
+  *message_output_ << static_cast<double>(escalated_count) / image_count;
+  *message_output_ << std::endl;
+  *message_output_ << kModelThroughputMessage;
+  *message_output_ << image_count / model_seconds.count() << std::endl;
+  *message_output_ << kCascadeThroughputMessage;
+  *message_output_ << image_count / cascade_seconds.count() << std::endl;
+}
+
+bool ExecutableLogic::ClassifyImages(const string& input_path,
+                                     bool is_printing_scores,
+                                     size_t cache_size) const {
+  DatasetFiles dataset_files;
+  std::istream* input = &std::cin;
+  if (input_path != kStandardStreamPath) {
+    input = OpenDataset(input_path, dataset_files);
+  }
+
+  *message_output_ << kClassifyingMessage << std::endl;
+  vector<char> labels = model_.GetLabels();
+  if (input == nullptr || !*input || labels.empty()) {
+    *message_output_ << kFailedMessage << std::endl;
+    return false;
+  }
+
+  // Reading stdin would otherwise flush stdout before every read
+  std::cin.tie(nullptr);
+
+  ImageStream image_stream(*input);
+  ClassificationCache cache(cache_size);
+  vector<Image> chunk;
+  size_t image_count = 0;
+  perf_counters_.Start();
+
+  // An empty upstream in a pipeline has no images, which isn't an error
+  bool is_input_empty = input->peek() == std::char_traits<char>::eof();
+
+  try {
+    while (!is_input_empty &&
+           image_stream.ReadChunk(chunk, kClassifyChunkSize) > 0) {
+      TraceSpan span("Classify batch");
+
+      // Scoring reads every pixel the model has, so any other size would
+      // either throw in a pool task or be scored on just part of the image
+      for (size_t idx = 0; idx < chunk.size(); idx++) {
+        if (chunk[idx].GetHeight() != model_.GetImageHeight() ||
+            chunk[idx].GetWidth() != model_.GetImageWidth()) {
+          throw std::invalid_argument(kImageSizeMismatchMessage +
+                                      std::to_string(image_count + idx));
+        }
+      }
+
+      vector<vector<float>> scores(chunk.size());
+
+      if (cache_size == 0) {
+        scores = model_.CalculateLikelihoodScores(chunk);
+      } else {
+        // Only score the images the cache has not seen, still as one batch
+        vector<Image> missed_images;
+        vector<size_t> missed_idxs;
+        for (size_t idx = 0; idx < chunk.size(); idx++) {
+          if (!cache.Find(chunk[idx], model_.GetGeneration(), scores[idx])) {
+            missed_images.push_back(chunk[idx]);
+            missed_idxs.push_back(idx);
+          }
+        }
+
+        vector<vector<float>> missed_scores = 
+            model_.CalculateLikelihoodScores(missed_images);
+        for (size_t idx = 0; idx < missed_idxs.size(); idx++) {
+          scores[missed_idxs[idx]] = missed_scores[idx];
+          cache.Insert(missed_images[idx], model_.GetGeneration(),
+                       missed_scores[idx]);
+        }
+      }
+
+      for (const vector<float>& image_scores : scores) {
+        size_t best_idx = 0;
+        for (size_t label_idx = 1; label_idx < labels.size(); label_idx++) {
+          if (image_scores[label_idx] > image_scores[best_idx]) {
+            best_idx = label_idx;
+          }
+        }
+
+        std::cout << labels[best_idx];
+        for (size_t label_idx = 0; is_printing_scores && 
+             label_idx < labels.size(); label_idx++) {
+          std::cout << kCsvElementDelimiter << image_scores[label_idx];
+        }
+        std::cout << '\n';  // std::endl would flush after every image
+      }
+
+      image_count += chunk.size();
+    }
+  } catch (const std::invalid_argument& error) {
+    // The predictions made before the malformed image are still written
+    std::cout.flush();
+    perf_counters_.Stop();
+    *message_output_ << error.what() << std::endl;
+    *message_output_ << kFailedMessage << std::endl;
+    return false;
+  }
+
+  std::cout.flush();
+  PerfCounters::Reading reading = perf_counters_.Stop();
+  *message_output_ << kClassifiedCountMessage << image_count << std::endl;
+
+  if (cache_size > 0) {
+    *message_output_ << kCacheHitsMessage << cache.GetHitCount() << std::endl;
+    *message_output_ << kCacheMissesMessage << cache.GetMissCount();
+    *message_output_ << std::endl;
+    *message_output_ << kCacheEvictionsMessage << cache.GetEvictionCount();
+    *message_output_ << std::endl;
+  }
+
+  ReportCounters(kClassifyingCountersMessage, image_count, reading);
+  return true;
+}
+
+void ExecutableLogic::ConvertDataset(const string& input_path,
+                                     const string& output_path,
+                                     const string& weights_path) const {
+  *message_output_ << kConvertingMessage;
+  DatasetFiles dataset_files;
+  std::istream* input = OpenDataset(input_path, dataset_files);
+  std::ofstream output_file(output_path, std::ios::binary);
+  std::ifstream weights_file;
+  if (!weights_path.empty()) {
+    weights_file.open(weights_path);
+  }
+
+  if (input != nullptr && output_file.is_open() &&
+      (weights_path.empty() || weights_file)) {
+    ImageStream image_stream(*input);
+    ImageWriter image_writer(output_file, weights_path.empty()
+                                 ? ImageWriter::Format::kBinary
+                                 : ImageWriter::Format::kWeightedBinary);
+
+    ImageSampler sampler = sampler_;
+    vector<Image> chunk;
+    vector<double> weights;
+    while (ReadWeightedChunk(image_stream,
+                             weights_path.empty() ? nullptr : &weights_file,
+                             sampler, chunk, weights)) {
+      for (size_t index = 0; index < chunk.size(); index++) {
+        image_writer.Write(chunk[index], weights[index]);
+      }
+    }
+
+    *message_output_ << kFinishedMessage << std::endl;
+    ReportReadBandwidth(dataset_files);
+  } else {
+    *message_output_ << kFailedMessage << std::endl;
+  }
+}
+
+void ExecutableLogic::TrainOnCounts(bool is_balancing_classes) {
+  TraceSpan span("Train model");
+  if (!is_balancing_classes) {
+    model_.Train(counts_);
+    return;
+  }
+
+  TrainingCounts balanced_counts = counts_;
+  balanced_counts.BalanceClasses();
+  model_.Train(balanced_counts);
+}
+
+bool ExecutableLogic::ReadWeightedChunk(ImageStream& image_stream,
+                                        std::istream* weights_file,
+                                        ImageSampler& sampler,
+                                        vector<Image>& chunk,
+                                        vector<double>& weights) const {
+  TraceSpan span("Parse dataset chunk");
+  if (sampler.IsKeepingEveryImage()) {
+    image_stream.ReadChunk(chunk, weights, kTrainingChunkSize);
+  } else {
+    // A fraction keeps or drops each image as it is offered, so its sample
+    // is taken a chunk at a time. A reservoir's sample is not known until
+    // every image is offered, so the whole stream is read as one chunk.
+    size_t chunk_size = sampler.IsDecidingOnOffer()
+                            ? kTrainingChunkSize
+                            : std::numeric_limits<size_t>::max();
+    size_t offered_count = sampler.GetOfferedCount();
+    Image image;
+    double weight;
+    while (sampler.GetOfferedCount() - offered_count < chunk_size &&
+           image_stream.ReadImage(image, weight)) {
+      if (weights_file != nullptr) {
+        weight *= ReadSampleWeight(*weights_file);
+      }
+      sampler.Offer(image, weight);
+    }
+
+    if (sampler.GetOfferedCount() == offered_count) {
+      chunk.clear();
+      weights.clear();
+      if (offered_count > 0) {
+        *message_output_ << kSampledMessage << sampler.GetSampledCount();
+        *message_output_ << " of " << offered_count << " images... ";
+      }
+      return false;
+    }
+
+    // A chunk may keep no images, and more chunks can still follow it
+    sampler.TakeSample(chunk, weights);
+    return true;
+  }
+
+  // Every image has a weight in the sidecar, even those that are not counted
+  for (size_t index = 0; weights_file != nullptr && index < chunk.size();
+       index++) {
+    weights[index] *= ReadSampleWeight(*weights_file);
+  }
+
+  return !chunk.empty();
+}
+
+bool ExecutableLogic::ReadIndexedChunk(const string& dataset_path,
+                                       const DatasetIndex& index,
+                                       std::istream* weights_file,
+                                       size_t& next_image,
+                                       vector<Image>& chunk,
+                                       vector<double>& weights) const {
+  TraceSpan span("Parse indexed chunk");
+  size_t thread_count = ThreadPool::GetShared().GetThreadCount();
+  size_t end_image = std::min(index.GetImageCount(),
+                              next_image + kTrainingChunkSize * thread_count);
+
+  chunk.clear();
+  index.ReadImages(dataset_path, next_image, end_image,
+                   thread_count * kParseChunksPerThread, chunk);
+  next_image = end_image;
+
+  weights.assign(chunk.size(), 1);
+  for (size_t image = 0; weights_file != nullptr && image < chunk.size();
+       image++) {
+    weights[image] = ReadSampleWeight(*weights_file);
+  }
+
+  return !chunk.empty();
+}
+
+bool ExecutableLogic::LoadIndex(const string& dataset_path,
+                                DatasetIndex& index) const {
+  // A snapshot is faster to read than even a text dataset parsed in parallel
+  return is_indexing_datasets_ && !dataset_cache_.IsEnabled() &&
+         sampler_.IsKeepingEveryImage() &&
+         DatasetIndex::LoadOrBuild(dataset_path, index);
+}
+
+bool ExecutableLogic::LoadDataset(const string& dataset_path,
+                                  Dataset& dataset) const {
+  TraceSpan span("Parse dataset");
+
+  DatasetIndex index;
+  if (LoadIndex(dataset_path, index)) {
+    return index.ReadDataset(
+        dataset_path,
+        ThreadPool::GetShared().GetThreadCount() * kParseChunksPerThread,
+        dataset);
+  }
+
+  DatasetFiles dataset_files;
+  std::istream* input = OpenDataset(dataset_path, dataset_files);
+  if (input == nullptr) {
+    return false;
+  } else if (sampler_.IsKeepingEveryImage() && !is_printing_verbose_) {
+    *input >> dataset;
+    ReportReadBandwidth(dataset_files);
+    return true;
+  } else if (sampler_.IsKeepingEveryImage()) {
+    // Parse in chunks so progress is counted once per chunk, not per image
+    ProgressReporter progress(*message_output_, kParsingProgressPhase, 0);
+    ImageStream image_stream(*input);
+    vector<Image> chunk;
+    while (image_stream.ReadChunk(chunk, kTrainingChunkSize) > 0) {
+      for (const Image& image : chunk) {
+        dataset.AddImage(image);
+      }
+      progress.Add(chunk.size());
+    }
+
+    progress.Stop();
+    ReportReadBandwidth(dataset_files);
+    return true;
+  }
+
+  // Only the sampled images are ever held, never the whole file
+  ImageStream image_stream(*input);
+  ImageSampler sampler = sampler_;
+  vector<Image> sample;
+  vector<double> weights;
+  while (ReadWeightedChunk(image_stream, nullptr, sampler, sample, weights)) {
+    for (const Image& image : sample) {
+      dataset.AddImage(image);
+    }
+  }
+
+  ReportReadBandwidth(dataset_files);
+  return true;
+}
+
+std::istream* ExecutableLogic::OpenDataset(const string& dataset_path,
+                                           DatasetFiles& dataset_files) const {
+  if (dataset_cache_.Open(dataset_path, dataset_files.snapshot)) {
+    return &dataset_files.snapshot.GetStream();
+  } else if (dataset_files.compressed_file.Open(dataset_path)) {
+    return &dataset_files.compressed_file.GetStream();
+  } else if (is_reading_ahead_) {
+    return dataset_files.read_ahead_file.Open(dataset_path)
+               ? &dataset_files.read_ahead_file.GetStream()
+               : nullptr;
+  }
+
+  dataset_files.plain_file.open(dataset_path);
+  return dataset_files.plain_file.is_open() ? &dataset_files.plain_file
+                                            : nullptr;
+}
+
+void ExecutableLogic::ReportReadBandwidth(
+    const DatasetFiles& dataset_files) const {
+  const ReadAheadFile& read_ahead_file = dataset_files.read_ahead_file;
+  double read_seconds = read_ahead_file.GetReadSeconds();
+  if (!read_ahead_file.IsOpen() || read_seconds <= 0) {
+    return;
+  }
+
+  double megabytes = static_cast<double>(read_ahead_file.GetReadBytes()) /
+                     static_cast<double>(kBytesPerMegabyte);
+  *message_output_ << kReadBandwidthMessage << megabytes / read_seconds;
+  *message_output_ << kReadBandwidthUnit << std::endl;
+}
+
+void ExecutableLogic::ReportNodeThroughput(double seconds) const {
+  const ThreadPool& pool = ThreadPool::GetShared();
+  if (pool.GetPlacement() == ThreadPool::Placement::kAnywhere || seconds <= 0) {
+    return;
+  }
+
+  vector<size_t> node_index_counts = pool.GetNodeIndexCounts();
+  for (size_t node = 0; node < node_index_counts.size(); node++) {
+    *message_output_ << kNodeThroughputMessage << node << kNodeThroughputUnit;
+    *message_output_ << static_cast<double>(node_index_counts[node]) / seconds;
+    *message_output_ << std::endl;
+  }
+}
+
+void ExecutableLogic::ReportCounters(
+    const string& phase_message, size_t image_count,
+    const PerfCounters::Reading& reading) const {
+  if (!perf_counters_.IsOpen()) {
+    return;
+  }
+
+  *message_output_ << phase_message << std::endl;
+  *message_output_ << kInstructionsPerCycleMessage;
+  if (reading.is_counted_[PerfCounters::kCycles] &&
+      reading.is_counted_[PerfCounters::kInstructions] &&
+      reading.counts_[PerfCounters::kCycles] > 0) {
+    *message_output_ << reading.counts_[PerfCounters::kInstructions] /
+                        reading.counts_[PerfCounters::kCycles];
   } else {
-    std::cout << kFailedMessage << std::endl;
+    *message_output_ << kCounterUnavailableMessage;
+  }
+  *message_output_ << std::endl;
+
+  const vector<pair<PerfCounters::Event, const string*>> miss_messages = {
+      {PerfCounters::kL1Misses, &kL1MissesMessage},
+      {PerfCounters::kLlcMisses, &kLlcMissesMessage},
+      {PerfCounters::kBranchMisses, &kBranchMissesMessage}};
+  for (const pair<PerfCounters::Event, const string*>& miss : miss_messages) {
+    *message_output_ << *miss.second;
+    if (reading.is_counted_[miss.first]) {
+      *message_output_ << reading.counts_[miss.first] /
+                          static_cast<double>(std::max<size_t>(1, image_count));
+    } else {
+      *message_output_ << kCounterUnavailableMessage;
+    }
+    *message_output_ << std::endl;
   }
 }
 
+ImageSampler ExecutableLogic::CreateSampler(const ExecutionFlags& flags) {
+  if (flags.sample_size_ > 0) {
+    return ImageSampler::Reservoir(flags.sample_size_, flags.sample_seed_);
+  } else if (flags.sample_fraction_ > 0) {
+    return ImageSampler::Fraction(flags.sample_fraction_, flags.sample_seed_);
+  } else if (flags.sample_quotas_.empty()) {
+    return ImageSampler();
+  }
+
+  // A single count is the quota of every label
+  std::map<char, size_t> label_quotas;
+  size_t default_quota = 0;
+  std::stringstream quotas(flags.sample_quotas_);
+  string quota;
+  while (getline(quotas, quota, kQuotaDelimiter)) {
+    size_t separator = quota.find(kQuotaLabelSeparator);
+    string count = quota.substr(separator + 1);
+    if (count.empty() ||
+        count.find_first_not_of("0123456789") != string::npos ||
+        (separator != string::npos && separator != 1)) {
+      throw std::invalid_argument("The sample quotas are invalid.");
+    }
+
+    // Only digits are left, but there can be too many for a size_t
+    size_t label_quota = 0;
+    try {
+      label_quota = std::stoul(count);
+    } catch (const std::out_of_range&) {
+      throw std::invalid_argument("The sample quotas are invalid.");
+    }
+
+    if (separator == string::npos || quota.at(0) == kQuotaWildcardLabel) {
+      default_quota = label_quota;
+    } else {
+      label_quotas[quota.at(0)] = label_quota;
+    }
+  }
+
+  return ImageSampler::Stratified(label_quotas, default_quota,
+                                  flags.sample_seed_);
+}
+
+double ExecutableLogic::ReadSampleWeight(std::istream& weights_file) {
+  double weight;
+  if (!(weights_file >> weight)) {
+    throw std::invalid_argument("The weights file has fewer weights than "
+                                "the dataset has images.");
+  }
+
+  return weight;
+}
+
 void ExecutableLogic::SaveConfusionMatrix(
     const string& save_path, const vector<vector<size_t>>& matrix) const {
+  TraceSpan span("Write confusion matrix");
   std::ofstream output_file(save_path);
 
-  std::cout << kSavingConfusionMatrixMessage;
+  *message_output_ << kSavingConfusionMatrixMessage;
   if (output_file.is_open()) {
     size_t middle_index = matrix.size() / 2; // middle is half the size...
     size_t count_after_middle = matrix.size() - middle_index;
@@ -151,9 +1139,9 @@ void ExecutableLogic::SaveConfusionMatrix(
     WriteConfusionMatrixCounts(output_file, matrix, middle_index - 1);
     
     output_file.close();
-    std::cout << kFinishedMessage << std::endl;
+    *message_output_ << kFinishedMessage << std::endl;
   } else {
-    std::cout << kFailedMessage << std::endl;
+    *message_output_ << kFailedMessage << std::endl;
   }
 }
 
@@ -40,6 +40,68 @@ Shading Image::MapStringDigitEncodingToShading(const std::string& to_map) {
   throw std::invalid_argument("The shading encoding string provided is invalid.");
 }
 
+vector<uint8_t> Image::Pack() const {
+  size_t width = GetWidth();
+  vector<uint8_t> packed(GetPackedSize(GetHeight(), width), 0);
+
+  for (size_t row = 0; row < pixels_.size(); row++) {
+    for (size_t column = 0; column < width; column++) {
+      size_t index = row * width + column;
+      auto encoding = static_cast<uint8_t>(pixels_[row][column]);
+
+      // Each pixel takes 2 bits, starting from the lowest bits of the byte
+      packed[index / kPackedPixelsPerByte] |= 
+          encoding << (2 * (index % kPackedPixelsPerByte));
+    }
+  }
+
+  return packed;
+}
+
+Image Image::Unpack(const uint8_t* packed, size_t height, size_t width,
+                    char label) {
+  vector<vector<Shading>> pixels(height, vector<Shading>(width));
+
+  for (size_t row = 0; row < height; row++) {
+    for (size_t column = 0; column < width; column++) {
+      size_t index = row * width + column;
+      size_t encoding = (packed[index / kPackedPixelsPerByte] >> 
+          (2 * (index % kPackedPixelsPerByte))) & 0x3;
+
+      if (encoding >= kDistinctShadingEncodings.size()) {
+        throw std::invalid_argument("The packed shading encoding is invalid.");
+      }
+      pixels[row][column] = static_cast<Shading>(encoding);
+    }
+  }
+
+  return Image(pixels, label);
+}
+
+size_t Image::GetPackedSize(size_t height, size_t width) {
+  // Round up so the last pixels get a byte even if they don't fill it
+  return (height * width + kPackedPixelsPerByte - 1) / kPackedPixelsPerByte;
+}
+
+uint64_t Image::HashPacked(const vector<uint8_t>& packed_pixels,
+                           size_t height, size_t width, char label) {
+  const uint64_t kOffsetBasis = 14695981039346656037ULL;
+  const uint64_t kPrime = 1099511628211ULL;
+
+  uint64_t hash = kOffsetBasis;
+  for (uint64_t field : {static_cast<uint64_t>(height),
+                         static_cast<uint64_t>(width),
+                         static_cast<uint64_t>(static_cast<uint8_t>(label))}) {
+    hash = (hash ^ field) * kPrime;
+  }
+
+  for (uint8_t byte : packed_pixels) {
+    hash = (hash ^ byte) * kPrime;
+  }
+
+  return hash;
+}
+
 char Image::GetLabel() const { 
   return label_; 
 }
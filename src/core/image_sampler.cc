@@ -0,0 +1,150 @@
+#include "core/image_sampler.h"
+
+#include <algorithm>
+
+namespace naivebayes {
+
+using std::vector;
+using std::map;
+
+constexpr char ImageSampler::kWholeSampleKey;
+
+ImageSampler::ImageSampler() : ImageSampler(Mode::kEveryImage, 0) {}
+
+ImageSampler::ImageSampler(Mode mode, uint64_t seed)
+    : mode_(mode),
+      generator_(seed),
+      offered_count_(0),
+      sampled_count_(0),
+      default_quota_(0),
+      fraction_(1) {}
+
+ImageSampler ImageSampler::Reservoir(size_t sample_size, uint64_t seed) {
+  ImageSampler sampler(Mode::kReservoir, seed);
+  sampler.reservoirs_[kWholeSampleKey] = SampleReservoir{sample_size, 0, {}};
+  return sampler;
+}
+
+ImageSampler ImageSampler::Stratified(const map<char, size_t>& label_quotas,
+                                      size_t default_quota, uint64_t seed) {
+  ImageSampler sampler(Mode::kStratified, seed);
+  sampler.label_quotas_ = label_quotas;
+  sampler.default_quota_ = default_quota;
+  return sampler;
+}
+
+ImageSampler ImageSampler::Fraction(double fraction, uint64_t seed) {
+  if (!(fraction >= 0 && fraction <= 1)) {
+    throw std::invalid_argument("The sample fraction must be from 0 to 1.");
+  }
+
+  ImageSampler sampler(Mode::kFraction, seed);
+  sampler.fraction_ = fraction;
+  return sampler;
+}
+
+bool ImageSampler::IsKeepingEveryImage() const {
+  return mode_ == Mode::kEveryImage;
+}
+
+bool ImageSampler::IsDecidingOnOffer() const {
+  return mode_ == Mode::kEveryImage || mode_ == Mode::kFraction;
+}
+
+void ImageSampler::Offer(const Image& image, double weight) {
+  SampledImage sampled_image = {offered_count_, image, weight};
+  offered_count_++;
+
+  switch (mode_) {
+    case Mode::kEveryImage:
+      kept_images_.push_back(sampled_image);
+      break;
+    case Mode::kReservoir:
+      OfferToReservoir(reservoirs_.at(kWholeSampleKey), sampled_image);
+      break;
+    case Mode::kStratified: {
+      // Each label gets its own reservoir the first time it is seen
+      auto reservoir = reservoirs_.find(image.GetLabel());
+      if (reservoir == reservoirs_.end()) {
+        auto quota = label_quotas_.find(image.GetLabel());
+        size_t capacity =
+            quota == label_quotas_.end() ? default_quota_ : quota->second;
+        reservoir = reservoirs_.emplace(
+            image.GetLabel(), SampleReservoir{capacity, 0, {}}).first;
+      }
+
+      OfferToReservoir(reservoir->second, sampled_image);
+      break;
+    }
+    case Mode::kFraction:
+      if (std::bernoulli_distribution(fraction_)(generator_)) {
+        kept_images_.push_back(sampled_image);
+      }
+      break;
+  }
+}
+
+void ImageSampler::OfferStream(ImageStream& image_stream) {
+  Image image;
+  double weight;
+  while (image_stream.ReadImage(image, weight)) {
+    Offer(image, weight);
+  }
+}
+
+size_t ImageSampler::GetOfferedCount() const {
+  return offered_count_;
+}
+
+size_t ImageSampler::GetSampledCount() const {
+  return sampled_count_;
+}
+
+size_t ImageSampler::TakeSample(vector<Image>& images,
+                                vector<double>& weights) {
+  vector<SampledImage> sample;
+  sample.swap(kept_images_);
+
+  for (auto& reservoir : reservoirs_) {
+    sample.insert(sample.end(), reservoir.second.images_.begin(),
+                  reservoir.second.images_.end());
+    reservoir.second.images_.clear();
+  }
+
+  // Reservoirs keep images out of order, so restore the order of the file
+  std::sort(sample.begin(), sample.end(),
+            [](const SampledImage& first, const SampledImage& second) {
+              return first.offer_index_ < second.offer_index_;
+            });
+
+  images.clear();
+  weights.clear();
+  images.reserve(sample.size());
+  weights.reserve(sample.size());
+  for (const SampledImage& sampled_image : sample) {
+    images.push_back(sampled_image.image_);
+    weights.push_back(sampled_image.weight_);
+  }
+
+  sampled_count_ += images.size();
+  return images.size();
+}
+
+void ImageSampler::OfferToReservoir(SampleReservoir& reservoir,
+                                    const SampledImage& image) {
+  reservoir.offered_count_++;
+  if (reservoir.images_.size() < reservoir.capacity_) {
+    reservoir.images_.push_back(image);
+    return;
+  }
+
+  // The nth image replaces a kept image with probability capacity / n
+  std::uniform_int_distribution<size_t> distribution(
+      0, reservoir.offered_count_ - 1);
+  size_t slot = distribution(generator_);
+  if (slot < reservoir.capacity_) {
+    reservoir.images_[slot] = image;
+  }
+}
+
+} // namespace naivebayes
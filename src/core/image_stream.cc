@@ -0,0 +1,205 @@
+#include "core/image_stream.h"
+
+#include <cstring>
+
+namespace naivebayes {
+
+using std::istream;
+using std::vector;
+using std::string;
+
+const string ImageStream::kBinaryMagic = "\x89NBD";
+const string ImageStream::kWeightedBinaryMagic = "\x89NBW";
+
+ImageStream::ImageStream(istream& input)
+    : input_(input),
+      height_(0),
+      width_(0),
+      has_pending_label_(false),
+      is_binary_(false),
+      is_weighted_(false) {}
+
+size_t ImageStream::GetHeight() const {
+  return height_;
+}
+
+size_t ImageStream::GetWidth() const {
+  return width_;
+}
+
+size_t ImageStream::ReadChunk(vector<Image>& chunk, size_t max_images) {
+  chunk.clear();
+
+  Image image;
+  while (chunk.size() < max_images && ReadImage(image)) {
+    chunk.push_back(image);
+  }
+
+  return chunk.size();
+}
+
+size_t ImageStream::ReadChunk(vector<Image>& chunk, vector<double>& weights,
+                              size_t max_images) {
+  chunk.clear();
+  weights.clear();
+
+  Image image;
+  double weight;
+  while (chunk.size() < max_images && ReadImage(image, weight)) {
+    chunk.push_back(image);
+    weights.push_back(weight);
+  }
+
+  return chunk.size();
+}
+
+bool ImageStream::ReadImage(Image& image) {
+  double weight;
+  return ReadImage(image, weight);
+}
+
+bool ImageStream::ReadImage(Image& image, double& weight) {
+  weight = 1;
+  if (is_binary_) {
+    return ReadBinaryImage(image, weight);
+  } else if (height_ == 0) {
+    return ReadFirstImage(image, weight);
+  }
+
+  string current_label;
+  if (has_pending_label_) {
+    current_label = pending_label_;
+    has_pending_label_ = false;
+  } else if (!getline(input_, current_label)) {
+    return false;  // continue while there is a label
+  }
+
+  if (current_label.empty()) {
+    throw std::invalid_argument("Image is missing a label.");
+  }
+
+  char label = current_label.at(0);  // assume, for now the label is 1st char
+  vector<vector<Shading>> pixels;
+  pixels.reserve(height_);
+
+  // aggregate all the lines in the image, assuming all images are same size
+  string next_line;
+  for (size_t line_index = 0; line_index < height_; line_index++) {
+    // Only need to check width because if height was off line would be a label
+    if (!getline(input_, next_line) || next_line.size() != width_) {
+      // label lengths are also different than line lengths
+      throw std::invalid_argument("The images are not of uniform size");
+    }
+    pixels.push_back(ParsePixelRow(next_line));
+  }
+
+  image = Image(pixels, label);
+  return true;
+}
+
+bool ImageStream::ReadFirstImage(Image& image, double& weight) {
+  if (input_.peek() == static_cast<unsigned char>(kBinaryMagic.at(0))) {
+    ReadBinaryHeader();
+    return ReadBinaryImage(image, weight);
+  }
+
+  string label_string;
+  getline(input_, label_string);
+
+  // If the file is empty, the first line will be empty!
+  if (label_string.empty()) {
+    throw std::invalid_argument("The provided training data file is empty.");
+  }
+
+  // The label will be the first (and only) character in label_string
+  char label = label_string.at(0);
+
+  string first_line;
+  getline(input_, first_line);
+  vector<vector<Shading>> pixels = {ParsePixelRow(first_line)};
+
+  // Add lines to the image until we read the next label or reach end of file
+  string line;
+  while (getline(input_, line)) {
+    if (line.size() != first_line.size()) {
+      pending_label_ = line;
+      has_pending_label_ = true;
+      break;
+    }
+    pixels.push_back(ParsePixelRow(line));
+  }
+
+  height_ = pixels.size();
+  width_ = first_line.size();
+
+  image = Image(pixels, label);
+  return true;
+}
+
+void ImageStream::ReadBinaryHeader() {
+  string magic(kBinaryMagic.size(), '\0');
+  uint8_t dimensions[4];
+
+  if (!input_.read(&magic[0], magic.size()) ||
+      (magic != kBinaryMagic && magic != kWeightedBinaryMagic) ||
+      !input_.read(reinterpret_cast<char*>(dimensions), sizeof(dimensions))) {
+    throw std::invalid_argument("The binary dataset header is invalid.");
+  }
+
+  height_ = dimensions[0] | (dimensions[1] << 8);
+  width_ = dimensions[2] | (dimensions[3] << 8);
+  if (height_ == 0 || width_ == 0) {
+    throw std::invalid_argument("The binary dataset header is invalid.");
+  }
+
+  is_binary_ = true;
+  is_weighted_ = magic == kWeightedBinaryMagic;
+  packed_pixels_.resize(Image::GetPackedSize(height_, width_));
+}
+
+bool ImageStream::ReadBinaryImage(Image& image, double& weight) {
+  char label;
+  if (!input_.get(label)) {
+    return false;
+  }
+
+  if (is_weighted_) {
+    uint8_t weight_bytes[4];
+    if (!input_.read(reinterpret_cast<char*>(weight_bytes),
+                     sizeof(weight_bytes))) {
+      throw std::invalid_argument("The binary dataset ends within an image.");
+    }
+
+    // Assemble the bits byte by byte so the file is the same on any machine
+    uint32_t weight_bits = weight_bytes[0] | (weight_bytes[1] << 8) |
+        (weight_bytes[2] << 16) | (static_cast<uint32_t>(weight_bytes[3]) << 24);
+    float stored_weight;
+    std::memcpy(&stored_weight, &weight_bits, sizeof(stored_weight));
+    weight = stored_weight;
+  }
+
+  if (!input_.read(reinterpret_cast<char*>(packed_pixels_.data()),
+                   packed_pixels_.size())) {
+    throw std::invalid_argument("The binary dataset ends within an image.");
+  }
+
+  image = Image::Unpack(packed_pixels_.data(), height_, width_, label);
+  return true;
+}
+
+vector<Shading> ImageStream::ParsePixelRow(const string& line) {
+  vector<Shading> pixel_row;
+  pixel_row.reserve(line.size());
+
+  for (char pixel : line) {
+    auto shading = Image::kPixelShadings.find(pixel);
+    if (shading == Image::kPixelShadings.end()) {
+      throw std::invalid_argument("An image has a pixel that isn't a shading.");
+    }
+    pixel_row.push_back(shading->second);
+  }
+
+  return pixel_row;
+}
+
+} // namespace naivebayes
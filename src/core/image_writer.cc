@@ -0,0 +1,92 @@
+#include "core/image_writer.h"
+
+#include <cstring>
+
+#include "core/image_stream.h"
+
+namespace naivebayes {
+
+using std::vector;
+
+ImageWriter::ImageWriter(std::ostream& output, Format format)
+    : output_(output),
+      format_(format),
+      height_(0),
+      width_(0),
+      shading_chars_(Image::kDistinctShadingEncodings.size()) {
+  for (const auto& pixel_shading : Image::kPixelShadings) {
+    shading_chars_.at(static_cast<size_t>(pixel_shading.second)) =
+        pixel_shading.first;
+  }
+}
+
+void ImageWriter::Write(const Image& image) {
+  Write(image, 1);
+}
+
+void ImageWriter::Write(const Image& image, double weight) {
+  if (format_ != Format::kWeightedBinary && weight != 1) {
+    throw std::invalid_argument("Only the weighted format can store weights.");
+  }
+
+  if (height_ == 0) {
+    height_ = image.GetHeight();
+    width_ = image.GetWidth();
+
+    if (format_ != Format::kText) {
+      WriteBinaryHeader();
+    }
+  } else if (image.GetHeight() != height_ || image.GetWidth() != width_) {
+    throw std::invalid_argument("The images are not of uniform size");
+  }
+
+  if (format_ != Format::kText) {
+    vector<uint8_t> packed = image.Pack();
+    output_.put(image.GetLabel());
+    if (format_ == Format::kWeightedBinary) {
+      WriteWeight(static_cast<float>(weight));
+    }
+    output_.write(reinterpret_cast<const char*>(packed.data()), packed.size());
+    return;
+  }
+
+  output_ << image.GetLabel() << '\n';
+  for (size_t row = 0; row < height_; row++) {
+    for (size_t column = 0; column < width_; column++) {
+      Shading shading = image.GetPixel(row, column);
+      output_ << shading_chars_[static_cast<size_t>(shading)];
+    }
+    output_ << '\n';
+  }
+}
+
+void ImageWriter::WriteBinaryHeader() {
+  if (height_ > UINT16_MAX || width_ > UINT16_MAX) {
+    throw std::invalid_argument("The images are too large to write in binary.");
+  }
+
+  // Write the sizes byte by byte so the file is the same on any machine
+  uint8_t dimensions[4] = {
+      static_cast<uint8_t>(height_ & 0xFF), static_cast<uint8_t>(height_ >> 8),
+      static_cast<uint8_t>(width_ & 0xFF), static_cast<uint8_t>(width_ >> 8)};
+
+  output_ << (format_ == Format::kWeightedBinary
+                  ? ImageStream::kWeightedBinaryMagic
+                  : ImageStream::kBinaryMagic);
+  output_.write(reinterpret_cast<const char*>(dimensions), sizeof(dimensions));
+}
+
+void ImageWriter::WriteWeight(float weight) {
+  uint32_t weight_bits;
+  std::memcpy(&weight_bits, &weight, sizeof(weight_bits));
+
+  uint8_t weight_bytes[4] = {
+      static_cast<uint8_t>(weight_bits & 0xFF),
+      static_cast<uint8_t>((weight_bits >> 8) & 0xFF),
+      static_cast<uint8_t>((weight_bits >> 16) & 0xFF),
+      static_cast<uint8_t>(weight_bits >> 24)};
+  output_.write(reinterpret_cast<const char*>(weight_bytes),
+                sizeof(weight_bytes));
+}
+
+} // namespace naivebayes
@@ -0,0 +1,66 @@
+#include "core/live_classifier.h"
+
+namespace naivebayes {
+
+using std::vector;
+
+LiveClassifier::LiveClassifier() : model_(nullptr) {}
+
+LiveClassifier::LiveClassifier(const Model& model, size_t height,
+                               size_t width) : model_(&model) {
+  const std::map<char, size_t>& label_indices = model.GetLabelIndices();
+  labels_ = vector<char>(label_indices.size());
+  baseline_scores_ = vector<float>(label_indices.size());
+
+  // Score a blank image once so clearing never has to rescore every pixel
+  vector<vector<Shading>> blank_pixels(height,
+                                       vector<Shading>(width, Shading::kWhite));
+  Image blank_image(blank_pixels, Image::kDefaultLabel);
+
+  for (const auto& label_index : label_indices) {
+    labels_.at(label_index.second) = label_index.first;
+    baseline_scores_.at(label_index.second) =
+        model.CalculateLikelihoodScore(label_index.first, blank_image);
+  }
+
+  scores_ = baseline_scores_;
+}
+
+void LiveClassifier::UpdatePixel(size_t row, size_t column,
+                                 Shading previous, Shading current) {
+  if (previous == current) {
+    return;
+  }
+
+  // Swap the likelihood of the old shading for that of the new shading
+  for (size_t label_idx = 0; label_idx < scores_.size(); label_idx++) {
+    scores_[label_idx] +=
+        model_->GetIndexedFeatureLikelihood(label_idx, current, row, column) -
+        model_->GetIndexedFeatureLikelihood(label_idx, previous, row, column);
+  }
+}
+
+void LiveClassifier::Reset() {
+  scores_ = baseline_scores_;
+}
+
+char LiveClassifier::GetPrediction() const {
+  if (scores_.empty()) {
+    return Image::kDefaultLabel;
+  }
+
+  size_t best_idx = 0;
+  for (size_t label_idx = 1; label_idx < scores_.size(); label_idx++) {
+    if (scores_[label_idx] > scores_[best_idx]) {
+      best_idx = label_idx;
+    }
+  }
+
+  return labels_[best_idx];
+}
+
+const vector<float>& LiveClassifier::GetScores() const {
+  return scores_;
+}
+
+} // namespace naivebayes
@@ -0,0 +1,130 @@
+#include "core/load_generator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "core/classify_connection.h"
+
+namespace naivebayes {
+
+using std::chrono::steady_clock;
+using std::vector;
+using std::string;
+
+const vector<double> LoadGenerator::kReportedPercentiles =
+    {50, 90, 99, 99.9, 100};
+
+const string LoadGenerator::kConnectFailedMessage =
+    "Could not connect to the server.";
+const string LoadGenerator::kRequestFailedMessage =
+    "Some requests did not get a response.";
+const string LoadGenerator::kThroughputMessage = "Requests per second: ";
+const string LoadGenerator::kLatencyMessage = "Latency (us) at percentile ";
+
+LoadGenerator::LoadGenerator(const vector<Image>& images,
+                             size_t connection_count, size_t request_count)
+    : images_(images),
+      connection_count_(connection_count > 0 ? connection_count : 1),
+      request_count_(request_count) {}
+
+int LoadGenerator::Run(const string& socket_path) const {
+  vector<vector<double>> connection_latencies(connection_count_);
+  vector<char> connection_succeeded(connection_count_, false);
+  vector<std::thread> connection_threads;
+
+  steady_clock::time_point start = steady_clock::now();
+
+  // Split the requests as evenly as possible between the connections
+  size_t first_request = 0;
+  for (size_t connection = 0; connection < connection_count_; connection++) {
+    size_t request_count = request_count_ / connection_count_ +
+        (connection < request_count_ % connection_count_ ? 1 : 0);
+
+    connection_threads.emplace_back([&, connection, first_request,
+                                     request_count]() {
+      connection_succeeded[connection] = SendRequests(
+          socket_path, first_request, request_count,
+          connection_latencies[connection]);
+    });
+    first_request += request_count;
+  }
+
+  for (std::thread& connection_thread : connection_threads) {
+    connection_thread.join();
+  }
+
+  std::chrono::duration<double> elapsed = steady_clock::now() - start;
+
+  vector<double> latencies;
+  for (const vector<double>& connection_latency : connection_latencies) {
+    latencies.insert(latencies.end(), connection_latency.begin(),
+                     connection_latency.end());
+  }
+  std::sort(latencies.begin(), latencies.end());
+
+  if (latencies.empty()) {
+    std::cout << kConnectFailedMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << kThroughputMessage;
+  std::cout << static_cast<double>(latencies.size()) / elapsed.count();
+  std::cout << std::endl;
+
+  for (double percentile : kReportedPercentiles) {
+    std::cout << kLatencyMessage << percentile << ": ";
+    std::cout << FindPercentile(latencies, percentile) << std::endl;
+  }
+
+  if (std::find(connection_succeeded.begin(), connection_succeeded.end(),
+                false) != connection_succeeded.end()) {
+    std::cout << kRequestFailedMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+bool LoadGenerator::SendRequests(const string& socket_path,
+                                 size_t first_request, size_t request_count,
+                                 vector<double>& latencies) const {
+  ClassifyConnection connection(ClassifyConnection::Connect(socket_path));
+  ClassifyResponse response;
+  latencies.reserve(request_count);
+
+  for (size_t request = first_request;
+       request < first_request + request_count; request++) {
+    steady_clock::time_point sent = steady_clock::now();
+
+    if (!connection.WriteRequest(images_.at(request % images_.size())) ||
+        !connection.ReadResponse(response)) {
+      return false;
+    }
+
+    std::chrono::duration<double, std::micro> latency =
+        steady_clock::now() - sent;
+    latencies.push_back(latency.count());
+  }
+
+  return true;
+}
+
+double LoadGenerator::FindPercentile(const vector<double>& sorted_latencies,
+                                     double percentile) {
+  if (sorted_latencies.empty()) {
+    return 0;
+  }
+
+  // The nearest rank is the smallest one with at least the percentile of the
+  // latencies at or below it
+  double rank = std::ceil(percentile / 100 *
+                          static_cast<double>(sorted_latencies.size())) - 1;
+  double last_rank = static_cast<double>(sorted_latencies.size() - 1);
+
+  return sorted_latencies[static_cast<size_t>(
+      std::min(std::max(rank, 0.0), last_rank))];
+}
+
+} // namespace naivebayes
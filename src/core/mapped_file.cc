@@ -0,0 +1,75 @@
+#include "core/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace naivebayes {
+
+void MappedFile::MemoryBuffer::Reset(char* data, size_t size) {
+  setg(data, data, data + size);
+}
+
+MappedFile::MappedFile() : data_(nullptr), size_(0), stream_(&buffer_) {}
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+bool MappedFile::Open(const std::string& path) {
+  Close();
+
+  int file_descriptor = open(path.c_str(), O_RDONLY);
+  if (file_descriptor < 0) {
+    return false;
+  }
+
+  struct stat status;
+  if (fstat(file_descriptor, &status) != 0) {
+    close(file_descriptor);
+    return false;
+  }
+
+  // An empty file can't be mapped, but it is still an empty stream
+  size_t size = static_cast<size_t>(status.st_size);
+  if (size > 0) {
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    if (data == MAP_FAILED) {
+      close(file_descriptor);
+      return false;
+    }
+
+    // Datasets are read front to back, so let the kernel read ahead
+    madvise(data, size, MADV_SEQUENTIAL);
+    data_ = data;
+    size_ = size;
+  }
+
+  // The mapping stays valid after the file is closed
+  close(file_descriptor);
+  buffer_.Reset(static_cast<char*>(data_), size_);
+  stream_.clear();
+  return true;
+}
+
+std::istream& MappedFile::GetStream() {
+  return stream_;
+}
+
+size_t MappedFile::GetSize() const {
+  return size_;
+}
+
+void MappedFile::Close() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+
+  data_ = nullptr;
+  size_ = 0;
+  buffer_.Reset(nullptr, 0);
+  stream_.clear();
+}
+
+} // namespace naivebayes
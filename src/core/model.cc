@@ -2,10 +2,17 @@
 // Created by Neil Kaushikkar on 4/1/21.
 //
 
+#include <algorithm>
+#include <memory>
 #include <numeric>
+#include <stdexcept>
 #include <cmath>
 
 #include "core/model.h"
+#include "core/model_replicas.h"
+#include "core/progress_reporter.h"
+#include "core/thread_pool.h"
+#include "core/trace.h"
 
 namespace naivebayes {
 
@@ -22,10 +29,22 @@ const string Model::kJsonSchemaLabelKey = "label";
 const string Model::kJsonSchemaClassKey = "class_likelihood";
 const string Model::kJsonSchemaShadingKey = "shading_likelihoods";
 
-const string Model::kModelTestingIndexFeedback = "Index: ";
+const string Model::kTestingProgressPhase = "Testing";
+
+const string Model::kPredictionsActualColumn = "actual";
+const string Model::kPredictionsLabelColumn = "label_";
+const string Model::kPredictionsScoreColumn = "score_";
+const string Model::kPredictionsPosteriorColumn = "posterior_";
+
+std::atomic<uint64_t> Model::next_generation_(1);
 
 Model::Model(size_t laplace_smoothing) 
-    : laplace_smoothing_(static_cast<float>(laplace_smoothing)) {}
+    : laplace_smoothing_(static_cast<float>(laplace_smoothing)),
+      generation_(next_generation_++) {}
+
+uint64_t Model::GetGeneration() const {
+  return generation_;
+}
 
 float Model::GetClassLikelihood(char class_label) const {
   return classifications_.at(class_label).class_likelihood_;
@@ -40,31 +59,213 @@ float Model::GetFeatureLikelihood(char class_label, Shading shading,
   return shading_likelihood.at(row).at(column);
 }
 
+float Model::GetIndexedFeatureLikelihood(size_t label_index, Shading shading,
+                                         size_t row, size_t column) const {
+  return feature_likelihoods_.at(label_index)
+      .at(static_cast<size_t>(shading))
+      .at(row)
+      .at(column);
+}
+
+vector<size_t> Model::RankPixels() const {
+  vector<float> variances = CalculatePixelVariances();
+
+  vector<size_t> pixel_idxs(variances.size());
+  std::iota(pixel_idxs.begin(), pixel_idxs.end(), 0);
+  // Stable, so pixels of equal variance keep their row major order
+  std::stable_sort(pixel_idxs.begin(), pixel_idxs.end(), 
+                   [&variances](size_t left, size_t right) {
+    return variances[left] > variances[right];
+  });
+
+  return pixel_idxs;
+}
+
+void Model::Prune(size_t kept_pixel_count) {
+  vector<size_t> ranked_pixels = RankPixels();
+  vector<bool> is_kept(ranked_pixels.size(), false);
+  kept_pixel_count = std::min(kept_pixel_count, ranked_pixels.size());
+
+  for (size_t rank = 0; rank < kept_pixel_count; rank++) {
+    is_kept.at(ranked_pixels.at(rank)) = true;
+  }
+
+  RetainPixels(is_kept);
+}
+
+void Model::PruneBelow(float min_variance) {
+  vector<float> variances = CalculatePixelVariances();
+  vector<bool> is_kept(variances.size(), false);
+
+  for (size_t pixel = 0; pixel < variances.size(); pixel++) {
+    is_kept.at(pixel) = variances.at(pixel) >= min_variance;
+  }
+
+  RetainPixels(is_kept);
+}
+
+vector<size_t> Model::GetRetainedPixels() const {
+  size_t width = GetImageWidth();
+  vector<size_t> pixels;
+  pixels.reserve(retained_pixels_.size());
+
+  for (const pair<size_t, size_t>& pixel : retained_pixels_) {
+    pixels.push_back(pixel.first * width + pixel.second);
+  }
+
+  return pixels;
+}
+
+vector<float> Model::CalculatePixelVariances() const {
+  size_t height = GetImageHeight();
+  size_t width = GetImageWidth();
+  auto label_count = static_cast<float>(class_likelihoods_.size());
+  vector<float> variances(height * width, 0);
+
+  for (size_t row = 0; row < height; row++) {
+    for (size_t column = 0; column < width; column++) {
+      for (const Shading& shading : Image::kDistinctShadingEncodings) {
+        auto shading_encoding = static_cast<size_t>(shading);
+        float sum = 0;
+        float squared_sum = 0;
+
+        for (const vector<FloatMatrix>& class_likelihoods :
+             feature_likelihoods_) {
+          float likelihood = 
+              class_likelihoods.at(shading_encoding).at(row).at(column);
+          sum += likelihood;
+          squared_sum += likelihood * likelihood;
+        }
+
+        float mean = sum / label_count;
+        variances.at(row * width + column) += 
+            squared_sum / label_count - mean * mean;
+      }
+    }
+  }
+
+  return variances;
+}
+
+void Model::RetainPixels(const vector<bool>& is_kept) {
+  size_t width = GetImageWidth();
+
+  // Zero the serialized likelihoods too, so a saved model stays pruned
+  for (auto& classification : classifications_) {
+    for (auto& shading_likelihood : 
+         classification.second.shading_likelihoods_) {
+      for (size_t pixel = 0; pixel < is_kept.size(); pixel++) {
+        if (!is_kept.at(pixel)) {
+          shading_likelihood.second.at(pixel / width).at(pixel % width) = 0;
+        }
+      }
+    }
+  }
+
+  SetVectorFeatureLikelihoods();
+  SetRetainedPixels();
+  generation_ = next_generation_++;
+}
+
+void Model::SetRetainedPixels() {
+  size_t height = GetImageHeight();
+  size_t width = GetImageWidth();
+  retained_pixels_.clear();
+
+  for (size_t row = 0; row < height; row++) {
+    for (size_t column = 0; column < width; column++) {
+      bool is_pruned = true;
+
+      // A smoothed likelihood is never 1, so its log is only 0 when pruned
+      for (const vector<FloatMatrix>& class_likelihoods : 
+           feature_likelihoods_) {
+        for (const FloatMatrix& likelihoods : class_likelihoods) {
+          is_pruned = is_pruned && likelihoods.at(row).at(column) == 0;
+        }
+      }
+
+      if (!is_pruned) {
+        retained_pixels_.emplace_back(row, column);
+      }
+    }
+  }
+}
+
 const map<char, size_t>& Model::GetLabelIndices() const {
   return label_indices_;
 }
 
+vector<char> Model::GetLabels() const {
+  vector<char> labels(label_indices_.size());
+
+  for (const auto& label_index : label_indices_) {
+    labels.at(label_index.second) = label_index.first;
+  }
+
+  return labels;
+}
+
+size_t Model::GetImageHeight() const {
+  if (feature_likelihoods_.empty()) {
+    return 0;
+  }
+
+  return feature_likelihoods_.at(0).at(0).size();
+}
+
+size_t Model::GetImageWidth() const {
+  if (GetImageHeight() == 0) {
+    return 0;
+  }
+
+  return feature_likelihoods_.at(0).at(0).at(0).size();
+}
+
 void Model::Train(const Dataset& dataset) {
-  vector<char> labels = dataset.GetDistinctLabels();
+  TrainingCounts counts;
+  counts.AddDataset(dataset);
+
+  Train(counts);
+}
+
+void Model::Train(const DeduplicatedDataset& dataset) {
+  TrainingCounts counts;
+  counts.AddDataset(dataset);
+
+  Train(counts);
+}
+
+void Model::Train(const TrainingCounts& counts) {
+  vector<char> labels = counts.GetDistinctLabels();
   size_t label_index = 0;
 
+  classifications_.clear();
+  label_indices_.clear();
+
   float laplace_smoothing = 
       static_cast<float>(labels.size()) * laplace_smoothing_;
   float smoothed_dataset_size = 
-      laplace_smoothing + static_cast<float>(dataset.GetSize());
+      laplace_smoothing + static_cast<float>(counts.GetImageCount());
+
+  // Each class is its own task on the shared pool
+  vector<map<Shading, FloatMatrix>> class_feature_likelihoods(labels.size());
+  ThreadPool::GetShared().ParallelFor(0, labels.size(), 1,
+                                      [&](size_t first, size_t last) {
+    TraceSpan span("Train labels");
+    for (size_t index = first; index < last; index++) {
+      class_feature_likelihoods[index] =
+          CalculateFeatureLikelihoods(counts, labels[index]);
+    }
+  });
 
   for (char label : labels) {
-    const vector<Image>& group = dataset.GetImageGroup(label);
-
     float smoothed_class_count = 
-        static_cast<float>(group.size()) + laplace_smoothing_;
+        static_cast<float>(counts.GetClassCount(label)) + laplace_smoothing_;
 
     float class_likelihood = log10(smoothed_class_count / smoothed_dataset_size);
 
-    map<Shading, FloatMatrix> feature_likelihoods =
-        CalculateFeatureLikelihoods(group, labels.size());
-
-    Classification classification = {class_likelihood, feature_likelihoods};
+    Classification classification = {
+        class_likelihood, std::move(class_feature_likelihoods[label_index])};
     classifications_[label] = classification;
 
     // Assign each char class label an index in our confusion matrix
@@ -74,76 +275,43 @@ void Model::Train(const Dataset& dataset) {
   
   SetClassLikelihoods();
   SetVectorFeatureLikelihoods();
+  SetRetainedPixels();
+  generation_ = next_generation_++;
 }
 
 map<Shading, FloatMatrix> Model::CalculateFeatureLikelihoods(
-    const vector<Image>& class_group, size_t label_count) const {
-  size_t row_count = class_group.at(0).GetHeight();
-  size_t column_count = class_group.at(0).GetWidth();
+    const TrainingCounts& counts, char class_label) const {
+  size_t row_count = counts.GetHeight();
+  size_t column_count = counts.GetWidth();
+  size_t label_count = counts.GetDistinctLabels().size();
 
-  // Initialize the empty map so we can fill it by indexing as we iterate
-  map<Shading, FloatMatrix> feature_likelihoods = 
-      InitializeEmptyFeatureMap(row_count, column_count);
-  
   float group_size_smooth_factor =
       laplace_smoothing_ * static_cast<float>(label_count);
-  float smoothed_group_count = 
-      group_size_smooth_factor + static_cast<float>(class_group.size());
+  float smoothed_group_count = group_size_smooth_factor + 
+      static_cast<float>(counts.GetClassCount(class_label));
 
-  // Go through each pixel and calculate each feature likelihood
-  for (size_t row = 0; row < row_count; row++) {
-    for (size_t column = 0; column < column_count; column++) {
-      map<Shading, size_t> pixel_shading_counts = 
-          CountPixelShadings(class_group, row, column);
+  map<Shading, FloatMatrix> feature_likelihoods;
+
+  // Go through all Shading types and calculate likelihood for each pixel
+  for (const Shading& shading : Image::kDistinctShadingEncodings) {
+    FloatMatrix likelihoods(row_count, vector<float>(column_count));
 
-      // Go through all Shading types and calculate likelihood for each
-      for (const auto& shading_count : pixel_shading_counts) {
+    for (size_t row = 0; row < row_count; row++) {
+      for (size_t column = 0; column < column_count; column++) {
+        double shading_count = 
+            counts.GetShadingCount(class_label, shading, row, column);
         float smoothed_pixel_shading_count =
-            laplace_smoothing_ + static_cast<float>(shading_count.second);
+            laplace_smoothing_ + static_cast<float>(shading_count);
 
-        float likelihood = 
+        likelihoods.at(row).at(column) =
             log10(smoothed_pixel_shading_count / smoothed_group_count);
-        
-        feature_likelihoods.at(shading_count.first).at(row).at(column) = 
-            likelihood;
       }
     }
-  }
-
-  return feature_likelihoods;
-}
-
-map<Shading, FloatMatrix> Model::InitializeEmptyFeatureMap(
-    size_t row_count, size_t column_count) {
-  map<Shading, FloatMatrix> feature_likelihoods;
-  
-  // Fill in the feature map so we explicitly say that there can be 0 images
-  for (const Shading& shading : Image::kDistinctShadingEncodings) {
-    FloatMatrix empty_vector(row_count, vector<float>(column_count));
-    feature_likelihoods[shading] = empty_vector;
-  }
-  
-  return feature_likelihoods;
-}
 
-map<Shading, size_t> Model::CountPixelShadings(
-    const vector<Image>& group, size_t row, size_t column) {
-  // map has key shading_class and value image_count
-  map<Shading, size_t> pixel_shading_counts;
-  
-  // Initialize all image_counts to 0
-  for (const Shading& shading : Image::kDistinctShadingEncodings) {
-    pixel_shading_counts[shading] = 0;
+    feature_likelihoods[shading] = likelihoods;
   }
 
-  for (const Image& image : group) {
-    Shading shading_class = image.GetPixel(row, column);
-
-    // increment the count of the specified shading
-    pixel_shading_counts.at(shading_class)++;
-  }
-
-  return pixel_shading_counts;
+  return feature_likelihoods;
 }
 
 std::ostream& operator<<(std::ostream& output, const Model& model) {
@@ -212,6 +380,8 @@ std::istream& operator>>(std::istream& input, Model& model) {
   
   model.SetClassLikelihoods();
   model.SetVectorFeatureLikelihoods();
+  model.SetRetainedPixels();
+  model.generation_ = Model::next_generation_++;
   
   return input;
 }
@@ -236,27 +406,182 @@ char Model::Classify(const Image& image) const {
   return most_likely_label;
 }
 
+char Model::Classify(const uint8_t* codes, size_t height, size_t width,
+                     size_t stride) const {
+  CheckImageSize(height, width);
+  if (stride < width) {
+    throw std::invalid_argument("The stride is smaller than the width.");
+  }
+
+  return ClassifyEncodings([codes, stride](size_t row, size_t column) {
+    return static_cast<size_t>(codes[row * stride + column]);
+  });
+}
+
+char Model::ClassifyPacked(const uint8_t* packed, size_t height,
+                           size_t width) const {
+  CheckImageSize(height, width);
+
+  return ClassifyEncodings([packed, width](size_t row, size_t column) {
+    size_t index = row * width + column;
+    return static_cast<size_t>((packed[index / Image::kPackedPixelsPerByte] >>
+        (2 * (index % Image::kPackedPixelsPerByte))) & 0x3);
+  });
+}
+
+vector<Prediction> Model::ClassifyTopK(const Image& image, size_t k) const {
+  vector<float> scores(class_likelihoods_.size());
+
+  for (const auto& label_index : label_indices_) {
+    scores.at(label_index.second) = 
+        CalculateLikelihoodScore(label_index.first, image);
+  }
+
+  return RankScores(scores, k);
+}
+
+vector<vector<Prediction>> Model::ClassifyTopK(const vector<Image>& images,
+                                               size_t k) const {
+  vector<vector<Prediction>> predictions;
+  predictions.reserve(images.size());
+
+  for (const vector<float>& scores : CalculateLikelihoodScores(images)) {
+    predictions.push_back(RankScores(scores, k));
+  }
+
+  return predictions;
+}
+
+vector<Prediction> Model::RankScores(const vector<float>& scores,
+                                     size_t k) const {
+  if (scores.empty()) {
+    return vector<Prediction>();
+  }
+
+  // Scores are log10 likelihoods far below 0, so shift them by the largest
+  // before exponentiating to keep the sum from underflowing
+  float max_score = *std::max_element(scores.begin(), scores.end());
+  double exponent_sum = 0;
+  for (float score : scores) {
+    exponent_sum += std::pow(10.0, score - max_score);
+  }
+  double log_evidence = max_score + std::log10(exponent_sum);
+
+  // Only the top k need to be in order, so leave the rest unsorted
+  vector<size_t> label_idxs(scores.size());
+  std::iota(label_idxs.begin(), label_idxs.end(), 0);
+  k = std::min(k, scores.size());
+  std::partial_sort(label_idxs.begin(), label_idxs.begin() + k, 
+                    label_idxs.end(), [&scores](size_t left, size_t right) {
+    return scores[left] > scores[right] || 
+        (scores[left] == scores[right] && left < right);
+  });
+
+  vector<char> labels = GetLabels();
+  vector<Prediction> predictions(k);
+  for (size_t rank = 0; rank < k; rank++) {
+    size_t label_idx = label_idxs[rank];
+    predictions[rank].label_ = labels[label_idx];
+    predictions[rank].score_ = scores[label_idx];
+    predictions[rank].posterior_ = 
+        static_cast<float>(std::pow(10.0, scores[label_idx] - log_evidence));
+  }
+
+  return predictions;
+}
+
 float Model::CalculateLikelihoodScore(char label, const Image& image) const {
   size_t label_idx = label_indices_.at(label);
 
   float score = class_likelihoods_.at(label_idx);
 
   // Go through each pixel to retrieve likelihoods of the shading of the pixel
-  for (size_t row = 0; row < image.GetHeight(); row++) {
-    for (size_t column = 0; column < image.GetWidth(); column++) {
-      auto shading_encoding = static_cast<size_t>(image.GetPixel(row, column));
-
-      // Access the specified element from the 4D vector
-      score += feature_likelihoods_.at(label_idx)
-          .at(shading_encoding)
-          .at(row)
-          .at(column);
-    }
+  for (const pair<size_t, size_t>& pixel : retained_pixels_) {
+    size_t row = pixel.first;
+    size_t column = pixel.second;
+    auto shading_encoding = static_cast<size_t>(image.GetPixel(row, column));
+
+    // Access the specified element from the 4D vector
+    score += feature_likelihoods_.at(label_idx)
+        .at(shading_encoding)
+        .at(row)
+        .at(column);
   }
 
   return score;
 }
 
+template <typename EncodingGetter>
+char Model::ClassifyEncodings(const EncodingGetter& get_encoding) const {
+  char most_likely_label = Image::kDefaultLabel;
+  float max_likelihood = 0;
+
+  // Labels and pixels are visited in the same order as Classify(const Image&)
+  // so both sum each score in the same order and predict the same label
+  for (const auto& label_index : label_indices_) {
+    const vector<FloatMatrix>& shading_likelihoods = 
+        feature_likelihoods_[label_index.second];
+    float score = class_likelihoods_[label_index.second];
+
+    for (const pair<size_t, size_t>& pixel : retained_pixels_) {
+      size_t shading_encoding = get_encoding(pixel.first, pixel.second);
+      if (shading_encoding >= shading_likelihoods.size()) {
+        throw std::invalid_argument("The shading encoding is invalid.");
+      }
+
+      score += shading_likelihoods[shading_encoding][pixel.first][pixel.second];
+    }
+
+    if (score > max_likelihood || most_likely_label == Image::kDefaultLabel) {
+      max_likelihood = score;
+      most_likely_label = label_index.first;
+    }
+  }
+
+  return most_likely_label;
+}
+
+void Model::CheckImageSize(size_t height, size_t width) const {
+  if (height != GetImageHeight() || width != GetImageWidth()) {
+    throw std::invalid_argument("The image size doesn't match the model.");
+  }
+}
+
+vector<vector<float>> Model::CalculateLikelihoodScores(
+    const vector<Image>& images) const {
+  vector<vector<float>> scores(images.size(),
+                               vector<float>(class_likelihoods_.size()));
+
+  // Each task scores a range of images, one class at a time so only that
+  // class's likelihoods need to be cached
+  ThreadPool::GetShared().ParallelFor(0, images.size(), kScoringGrainSize,
+                                      [&](size_t first, size_t last) {
+    TraceSpan span("Score images");
+    for (size_t label_idx = 0; label_idx < class_likelihoods_.size(); 
+         label_idx++) {
+      const vector<FloatMatrix>& shading_likelihoods = 
+          feature_likelihoods_.at(label_idx);
+
+      for (size_t image_idx = first; image_idx < last; image_idx++) {
+        const Image& image = images[image_idx];
+        float score = class_likelihoods_[label_idx];
+
+        for (const pair<size_t, size_t>& pixel : retained_pixels_) {
+          auto shading_encoding = 
+              static_cast<size_t>(image.GetPixel(pixel.first, pixel.second));
+          score += shading_likelihoods.at(shading_encoding)
+              .at(pixel.first)
+              .at(pixel.second);
+        }
+
+        scores[image_idx][label_idx] = score;
+      }
+    }
+  });
+
+  return scores;
+}
+
 void Model::SetVectorFeatureLikelihoods() {
   feature_likelihoods_ = vector<vector<FloatMatrix>>(label_indices_.size());
   
@@ -291,29 +616,98 @@ void Model::SetClassLikelihoods() {
   }
 }
 
-LongMatrix Model::Test(const Dataset& dataset, bool is_printing_verbose) const {
+LongMatrix Model::Test(const Dataset& dataset, bool is_printing_verbose,
+                       std::ostream* progress_output) const {
   map<char, size_t> label_indices = GetLabelIndices();
   
   vector<size_t> matrix_row(label_indices.size(), 0);
   LongMatrix confusion_matrix(label_indices.size(), matrix_row);
 
-  size_t index = 0;
-  // Go through each subset of images in the dataset
+  // The label groups are very uneven, so classify the images of every group
+  // as one range for the pool to split
+  vector<const Image*> images;
   for (char label : dataset.GetDistinctLabels()) {
-    const vector<Image>& images = dataset.GetImageGroup(label);
+    for (const Image& image : dataset.GetImageGroup(label)) {
+      images.push_back(&image);
+    }
+  }
 
-    // Go through each image in the subset and try to predict its label
-    for (const Image& image : images) {
-      if (is_printing_verbose && index % kLinearTestingFeedbackRate == 0) {
-        std::cout << kModelTestingIndexFeedback << index << std::endl;
-      }
-      char predicted = Classify(image);
+  // Replicated pools score with a copy of the model on each NUMA node
+  ThreadPool& pool = ThreadPool::GetShared();
+  bool is_replicated = pool.GetPlacement() == ThreadPool::Placement::kReplicated;
+  ModelReplicas replicas(*this, pool.GetNodeCount());
+
+  std::unique_ptr<ProgressReporter> progress;
+  if (is_printing_verbose) {
+    progress.reset(new ProgressReporter(
+        *progress_output, kTestingProgressPhase, images.size()));
+  }
+
+  vector<char> predictions(images.size());
+  pool.ParallelFor(0, images.size(), kScoringGrainSize,
+                   [&](size_t first, size_t last) {
+    TraceSpan span("Classify images");
+    const Model& model = is_replicated
+                             ? replicas.Get(ThreadPool::GetCurrentNode())
+                             : *this;
+    for (size_t index = first; index < last; index++) {
+      predictions[index] = model.Classify(*images[index]);
+    }
 
-      size_t row = label_indices.at(image.GetLabel());
-      size_t column = label_indices.at(predicted);
+    if (progress) {
+      progress->Add(last - first);
+    }
+  });
+
+  if (progress) {
+    progress->Stop();
+  }
+
+  for (size_t index = 0; index < images.size(); index++) {
+    size_t row = label_indices.at(images[index]->GetLabel());
+    size_t column = label_indices.at(predictions[index]);
+
+    confusion_matrix.at(row).at(column)++;
+  }
+
+  return confusion_matrix;
+}
+
+LongMatrix Model::Test(const Dataset& dataset, size_t k,
+                       std::ostream& predictions_output) const {
+  map<char, size_t> label_indices = GetLabelIndices();
+  // The top prediction is always needed to fill in the confusion matrix
+  k = std::min(std::max(k, static_cast<size_t>(1)), label_indices.size());
+
+  vector<size_t> matrix_row(label_indices.size(), 0);
+  LongMatrix confusion_matrix(label_indices.size(), matrix_row);
+
+  predictions_output << kPredictionsActualColumn;
+  for (size_t rank = 1; rank <= k; rank++) {
+    predictions_output << ',' << kPredictionsLabelColumn << rank;
+    predictions_output << ',' << kPredictionsScoreColumn << rank;
+    predictions_output << ',' << kPredictionsPosteriorColumn << rank;
+  }
+  predictions_output << '\n';
+
+  // Each group of images is already in a vector, so score it as one batch
+  for (char label : dataset.GetDistinctLabels()) {
+    const vector<Image>& images = dataset.GetImageGroup(label);
+    vector<vector<Prediction>> predictions = ClassifyTopK(images, k);
+
+    for (const vector<Prediction>& image_predictions : predictions) {
+      predictions_output << label;
+      for (const Prediction& prediction : image_predictions) {
+        predictions_output << ',' << prediction.label_;
+        predictions_output << ',' << prediction.score_;
+        predictions_output << ',' << prediction.posterior_;
+      }
+      predictions_output << '\n';
 
+      // Ties are broken the same way as Classify, so the matrix is the same
+      size_t row = label_indices.at(label);
+      size_t column = label_indices.at(image_predictions.at(0).label_);
       confusion_matrix.at(row).at(column)++;
-      index++;
     }
   }
 
@@ -0,0 +1,18 @@
+#include "core/model_replicas.h"
+
+namespace naivebayes {
+
+ModelReplicas::ModelReplicas(const Model& model, size_t node_count)
+    : model_(model), replicas_(node_count) {}
+
+const Model& ModelReplicas::Get(size_t node) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<Model>& replica = replicas_.at(node);
+  if (!replica) {
+    replica.reset(new Model(model_));
+  }
+
+  return *replica;
+}
+
+} // namespace naivebayes
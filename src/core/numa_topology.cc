@@ -0,0 +1,111 @@
+#include "core/numa_topology.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "core/thread_pool.h"
+
+namespace naivebayes {
+
+using std::string;
+using std::vector;
+
+const string NumaTopology::kSysfsNodeDirectory = "/sys/devices/system/node/";
+
+NumaTopology::NumaTopology(size_t core_count)
+    : node_cores_(1, vector<size_t>(std::max<size_t>(1, core_count))) {
+  for (size_t core = 0; core < node_cores_[0].size(); core++) {
+    node_cores_[0][core] = core;
+  }
+}
+
+NumaTopology::NumaTopology(const vector<vector<size_t>>& node_cores)
+    : node_cores_(node_cores) {}
+
+NumaTopology NumaTopology::Detect() {
+  vector<vector<size_t>> node_cores;
+
+  // Nodes are numbered from 0 with no gaps on every machine we run on, and
+  // a node without cores, like one of only memory, can't run threads
+  for (size_t node = 0;; node++) {
+    std::ifstream cpu_list_file(kSysfsNodeDirectory + "node" +
+                                std::to_string(node) + "/cpulist");
+    string cpu_list;
+    if (!getline(cpu_list_file, cpu_list)) {
+      break;
+    }
+
+    try {
+      vector<size_t> cores = ParseCpuList(cpu_list);
+      if (!cores.empty()) {
+        node_cores.push_back(cores);
+      }
+    } catch (const std::invalid_argument&) {
+      break;
+    }
+  }
+
+  if (node_cores.empty()) {
+    return NumaTopology(ThreadPool::GetCoreCount());
+  }
+
+  return NumaTopology(node_cores);
+}
+
+vector<size_t> NumaTopology::ParseCpuList(const string& cpu_list) {
+  vector<size_t> cores;
+  std::istringstream list_stream(cpu_list);
+  string range;
+
+  while (getline(list_stream, range, ',')) {
+    if (range.empty() || range.find_first_not_of("0123456789-") !=
+                             string::npos) {
+      throw std::invalid_argument("The cpu list is malformed.");
+    }
+
+    size_t dash = range.find('-');
+    size_t first_core = std::stoul(range.substr(0, dash));
+    size_t last_core = dash == string::npos
+                           ? first_core
+                           : std::stoul(range.substr(dash + 1));
+    if (last_core < first_core) {
+      throw std::invalid_argument("The cpu list is malformed.");
+    }
+
+    for (size_t core = first_core; core <= last_core; core++) {
+      cores.push_back(core);
+    }
+  }
+
+  return cores;
+}
+
+size_t NumaTopology::GetNodeCount() const {
+  return node_cores_.size();
+}
+
+const vector<size_t>& NumaTopology::GetNodeCores(size_t node) const {
+  return node_cores_.at(node);
+}
+
+vector<std::pair<size_t, size_t>> NumaTopology::InterleaveCores() const {
+  size_t core_count = 0;
+  for (const vector<size_t>& node_cores : node_cores_) {
+    core_count += node_cores.size();
+  }
+
+  vector<std::pair<size_t, size_t>> cores;
+  for (size_t rank = 0; cores.size() < core_count; rank++) {
+    for (size_t node = 0; node < node_cores_.size(); node++) {
+      if (rank < node_cores_[node].size()) {
+        cores.emplace_back(node_cores_[node][rank], node);
+      }
+    }
+  }
+
+  return cores;
+}
+
+} // namespace naivebayes
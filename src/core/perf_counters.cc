@@ -0,0 +1,154 @@
+#include "core/perf_counters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+namespace naivebayes {
+
+PerfCounters::PerfCounters() : file_descriptors_(kEventCount, -1) {}
+
+PerfCounters::~PerfCounters() {
+  Close();
+}
+
+PerfCounters::PerfCounters(PerfCounters&& other)
+    : file_descriptors_(std::move(other.file_descriptors_)),
+      error_(std::move(other.error_)) {
+  other.file_descriptors_.assign(kEventCount, -1);
+}
+
+bool PerfCounters::Open() {
+  Close();
+
+#ifdef __linux__
+  // The type and config of each event, in the order of Event
+  const uint32_t kTypes[kEventCount] = {
+      PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+      PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE};
+  const uint64_t kConfigs[kEventCount] = {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+      PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+      PERF_COUNT_HW_BRANCH_MISSES};
+
+  bool is_any_open = false;
+  for (size_t event = 0; event < kEventCount; event++) {
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = kTypes[event];
+    attributes.config = kConfigs[event];
+    attributes.disabled = 1;
+    // Threads started after opening, like the pool's workers, are counted
+    // too, and only user space is counted so no privileges are needed
+    attributes.inherit = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                             PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    long file_descriptor = syscall(__NR_perf_event_open, &attributes, 0, -1,
+                                   -1, PERF_FLAG_FD_CLOEXEC);
+    if (file_descriptor < 0) {
+      if (error_.empty()) {
+        error_ = std::strerror(errno);
+      }
+      continue;
+    }
+
+    file_descriptors_[event] = static_cast<int>(file_descriptor);
+    is_any_open = true;
+  }
+
+  if (is_any_open) {
+    error_.clear();
+  }
+  return is_any_open;
+#else
+  error_ = "perf_event_open is only available on Linux";
+  return false;
+#endif
+}
+
+bool PerfCounters::IsOpen() const {
+  for (int file_descriptor : file_descriptors_) {
+    if (file_descriptor >= 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+const std::string& PerfCounters::GetError() const {
+  return error_;
+}
+
+void PerfCounters::Start() const {
+#ifdef __linux__
+  for (int file_descriptor : file_descriptors_) {
+    if (file_descriptor >= 0) {
+      ioctl(file_descriptor, PERF_EVENT_IOC_RESET, 0);
+      ioctl(file_descriptor, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+#endif
+}
+
+PerfCounters::Reading PerfCounters::Stop() const {
+  Reading reading;
+  reading.counts_.fill(0);
+  reading.is_counted_.fill(false);
+
+#ifdef __linux__
+  for (size_t event = 0; event < kEventCount; event++) {
+    int file_descriptor = file_descriptors_[event];
+    if (file_descriptor < 0) {
+      continue;
+    }
+
+    ioctl(file_descriptor, PERF_EVENT_IOC_DISABLE, 0);
+
+    // The value, then the time the event was enabled and the time it ran
+    uint64_t values[3];
+    if (read(file_descriptor, values, sizeof(values)) !=
+        static_cast<ssize_t>(sizeof(values)) || values[2] == 0) {
+      continue;
+    }
+
+    // More events than the CPU has counters are taken in turns, so scale
+    // each count up to the whole time it was enabled
+    reading.counts_[event] = static_cast<double>(values[0]) *
+                             static_cast<double>(values[1]) /
+                             static_cast<double>(values[2]);
+    reading.is_counted_[event] = true;
+  }
+#endif
+
+  return reading;
+}
+
+void PerfCounters::Close() {
+#ifdef __linux__
+  for (int& file_descriptor : file_descriptors_) {
+    if (file_descriptor >= 0) {
+      close(file_descriptor);
+    }
+    file_descriptor = -1;
+  }
+#endif
+  error_.clear();
+}
+
+} // namespace naivebayes
@@ -0,0 +1,89 @@
+#include "core/progress_reporter.h"
+
+#include <sstream>
+
+namespace naivebayes {
+
+using std::chrono::steady_clock;
+
+const std::chrono::milliseconds ProgressReporter::kDefaultInterval(1000);
+
+ProgressReporter::ProgressReporter(std::ostream& output,
+                                   const std::string& phase,
+                                   size_t total_count,
+                                   std::chrono::milliseconds interval)
+    : output_(output),
+      phase_(phase),
+      total_count_(total_count),
+      interval_(interval),
+      start_time_(steady_clock::now()),
+      count_(0),
+      is_stopping_(false) {
+  reporter_ = std::thread(&ProgressReporter::Report, this);
+}
+
+ProgressReporter::~ProgressReporter() {
+  Stop();
+}
+
+void ProgressReporter::Add(size_t count) {
+  count_.fetch_add(count, std::memory_order_relaxed);
+}
+
+size_t ProgressReporter::GetCount() const {
+  return count_.load(std::memory_order_relaxed);
+}
+
+void ProgressReporter::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (is_stopping_) {
+      return;
+    }
+    is_stopping_ = true;
+  }
+  stopped_.notify_all();
+
+  reporter_.join();
+  Print();
+}
+
+void ProgressReporter::Report() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopped_.wait_for(lock, interval_, [this]() {
+    return is_stopping_;
+  })) {
+    Print();
+  }
+}
+
+void ProgressReporter::Print() const {
+  size_t count = GetCount();
+  std::chrono::duration<double> seconds = steady_clock::now() - start_time_;
+  double rate = seconds.count() > 0
+                    ? static_cast<double>(count) / seconds.count()
+                    : 0;
+
+  // The whole line is built first so lines of other threads can't split it
+  std::ostringstream line;
+  line << phase_ << ": " << count;
+  if (total_count_ > 0) {
+    line << " of " << total_count_ << " images ("
+         << 100.0 * static_cast<double>(count) /
+                static_cast<double>(total_count_)
+         << "%)";
+  } else {
+    line << " images";
+  }
+  line << ", " << rate << " images/s";
+
+  if (total_count_ > count && rate > 0) {
+    line << ", " << static_cast<double>(total_count_ - count) / rate
+         << "s left";
+  }
+  line << '\n';
+
+  output_ << line.str() << std::flush;
+}
+
+} // namespace naivebayes
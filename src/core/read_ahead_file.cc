@@ -0,0 +1,217 @@
+#include "core/read_ahead_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <stdexcept>
+
+namespace naivebayes {
+
+using std::string;
+
+ReadAheadFile::RingBuffer::RingBuffer(ReadAheadFile& file) : file_(file) {}
+
+void ReadAheadFile::RingBuffer::Reset() {
+  setg(nullptr, nullptr, nullptr);
+}
+
+ReadAheadFile::RingBuffer::int_type ReadAheadFile::RingBuffer::underflow() {
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+
+  // Filled buffers are never empty, so a buffer that was taken has a byte
+  char* data;
+  size_t size;
+  if (!file_.TakeBuffer(data, size)) {
+    setg(nullptr, nullptr, nullptr);
+    return traits_type::eof();
+  }
+
+  setg(data, data, data + size);
+  return traits_type::to_int_type(*gptr());
+}
+
+ReadAheadFile::ReadAheadFile()
+    : file_descriptor_(-1),
+      filled_sizes_(kBufferCount, 0),
+      filled_count_(0),
+      read_index_(0),
+      is_holding_buffer_(false),
+      is_finished_(true),
+      is_stopping_(false),
+      read_bytes_(0),
+      ring_buffer_(*this),
+      stream_(&ring_buffer_) {
+  // A failed read() on the reading thread is rethrown by underflow(), so a
+  // disk error isn't mistaken by the parser for the end of the dataset
+  stream_.exceptions(std::ios::badbit);
+}
+
+ReadAheadFile::~ReadAheadFile() {
+  Close();
+}
+
+bool ReadAheadFile::Open(const string& path) {
+  Close();
+
+  file_descriptor_ = open(path.c_str(), O_RDONLY);
+  if (file_descriptor_ < 0) {
+    return false;
+  }
+
+  // The ring is only allocated once a file is read through it
+  if (buffers_.empty()) {
+    buffers_.assign(kBufferCount, string(kBufferSize, '\0'));
+  }
+
+  // Let the kernel read ahead of the reader thread as well
+#if defined(POSIX_FADV_SEQUENTIAL)
+  posix_fadvise(file_descriptor_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#elif defined(F_RDAHEAD)
+  fcntl(file_descriptor_, F_RDAHEAD, 1);
+#endif
+
+  is_finished_ = false;
+  is_stopping_ = false;
+  start_time_ = std::chrono::steady_clock::now();
+  end_time_ = start_time_;
+  reader_ = std::thread(&ReadAheadFile::ReadFile, this);
+  return true;
+}
+
+bool ReadAheadFile::IsOpen() const {
+  return file_descriptor_ >= 0;
+}
+
+std::istream& ReadAheadFile::GetStream() {
+  return stream_;
+}
+
+uint64_t ReadAheadFile::GetReadBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return read_bytes_;
+}
+
+double ReadAheadFile::GetReadSeconds() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::chrono::steady_clock::time_point end_time =
+      is_finished_ ? end_time_ : std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end_time - start_time_).count();
+}
+
+void ReadAheadFile::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  buffer_released_.notify_all();
+
+  if (reader_.joinable()) {
+    reader_.join();
+  }
+
+  if (file_descriptor_ >= 0) {
+    close(file_descriptor_);
+  }
+
+  file_descriptor_ = -1;
+  filled_count_ = 0;
+  read_index_ = 0;
+  is_holding_buffer_ = false;
+  is_finished_ = true;
+  error_ = nullptr;
+  read_bytes_ = 0;
+  ring_buffer_.Reset();
+  stream_.clear();
+}
+
+void ReadAheadFile::ReadFile() {
+  size_t write_index = 0;
+  uint64_t offset = 0;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      buffer_released_.wait(lock, [this]() {
+        return is_stopping_ || filled_count_ < kBufferCount;
+      });
+
+      if (is_stopping_) {
+        return;
+      }
+    }
+
+    // Hint the next buffer too, so the disk is busy while this one is read
+#if defined(POSIX_FADV_WILLNEED)
+    posix_fadvise(file_descriptor_, static_cast<off_t>(offset + kBufferSize),
+                  kBufferSize, POSIX_FADV_WILLNEED);
+#endif
+
+    // The buffer is not filled yet, so the stream can't be reading it
+    string& buffer = buffers_[write_index];
+    size_t size = 0;
+    while (size < kBufferSize) {
+      ssize_t count =
+          read(file_descriptor_, &buffer[size], kBufferSize - size);
+      if (count < 0 && errno == EINTR) {
+        continue;
+      } else if (count < 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::make_exception_ptr(
+            std::runtime_error("The dataset could not be read."));
+        is_finished_ = true;
+        end_time_ = std::chrono::steady_clock::now();
+        buffer_filled_.notify_all();
+        return;
+      } else if (count == 0) {
+        break;
+      }
+      size += static_cast<size_t>(count);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    read_bytes_ += size;
+    offset += size;
+    if (size == 0) {
+      is_finished_ = true;
+      end_time_ = std::chrono::steady_clock::now();
+      buffer_filled_.notify_all();
+      return;
+    }
+
+    filled_sizes_[write_index] = size;
+    filled_count_++;
+    write_index = (write_index + 1) % kBufferCount;
+    buffer_filled_.notify_one();
+  }
+}
+
+bool ReadAheadFile::TakeBuffer(char*& data, size_t& size) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (is_holding_buffer_) {
+    filled_count_--;
+    read_index_ = (read_index_ + 1) % kBufferCount;
+    is_holding_buffer_ = false;
+    buffer_released_.notify_one();
+  }
+
+  buffer_filled_.wait(lock, [this]() {
+    return is_finished_ || filled_count_ > 0;
+  });
+
+  if (filled_count_ == 0) {
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return false;
+  }
+
+  is_holding_buffer_ = true;
+  data = &buffers_[read_index_][0];
+  size = filled_sizes_[read_index_];
+  return true;
+}
+
+} // namespace naivebayes
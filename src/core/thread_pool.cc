@@ -0,0 +1,306 @@
+#include "core/thread_pool.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <exception>
+
+#include "core/numa_topology.h"
+
+namespace naivebayes {
+
+using std::function;
+
+namespace {
+
+// The NUMA node of the thread, which only pinned workers set
+thread_local size_t current_node = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t thread_count)
+    : thread_count_(1),
+      placement_(Placement::kAnywhere),
+      node_count_(1),
+      queued_count_(0),
+      is_stopping_(false),
+      next_queue_(0) {
+  StartWorkers(thread_count, Placement::kAnywhere);
+}
+
+ThreadPool::~ThreadPool() {
+  StopWorkers();
+}
+
+ThreadPool& ThreadPool::GetShared() {
+  static ThreadPool shared_pool(0);
+  return shared_pool;
+}
+
+size_t ThreadPool::GetCoreCount() {
+  // hardware_concurrency() is 0 when the number of cores is unknown
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+size_t ThreadPool::GetThreadCount() const {
+  return thread_count_;
+}
+
+void ThreadPool::SetThreadCount(size_t thread_count, Placement placement) {
+  StopWorkers();
+  StartWorkers(thread_count, placement);
+}
+
+ThreadPool::Placement ThreadPool::GetPlacement() const {
+  return placement_;
+}
+
+size_t ThreadPool::GetNodeCount() const {
+  return node_count_;
+}
+
+size_t ThreadPool::GetCurrentNode() {
+  return current_node;
+}
+
+std::vector<size_t> ThreadPool::GetNodeIndexCounts() const {
+  std::vector<size_t> counts;
+  for (const std::atomic<size_t>& count : node_index_counts_) {
+    counts.push_back(count);
+  }
+  return counts;
+}
+
+void ThreadPool::ResetNodeIndexCounts() {
+  for (std::atomic<size_t>& count : node_index_counts_) {
+    count = 0;
+  }
+}
+
+void ThreadPool::ParallelFor(size_t begin, size_t end, size_t grain_size,
+                             const function<void(size_t, size_t)>& body) {
+  if (end <= begin) {
+    return;
+  }
+
+  size_t count = end - begin;
+  if (grain_size == 0) {
+    grain_size = std::max<size_t>(1, count / (thread_count_ * kTasksPerThread));
+  }
+
+  if (count <= grain_size) {
+    RunRange(begin, end, body);
+    return;
+  }
+
+  // Without workers the tasks run in order, but still one grain at a time
+  if (workers_.empty()) {
+    std::exception_ptr error;
+    for (size_t first = begin; first < end; first += grain_size) {
+      try {
+        RunRange(first, std::min(end, first + grain_size), body);
+      } catch (...) {
+        error = error ? error : std::current_exception();
+      }
+    }
+
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    return;
+  }
+
+  // The tasks of this call count down as they finish, even if they throw
+  struct Job {
+    std::mutex mutex_;
+    std::condition_variable finished_;
+    size_t remaining_;
+    std::exception_ptr error_;
+  } job;
+  job.remaining_ = (count + grain_size - 1) / grain_size;
+
+  for (size_t first = begin; first < end; first += grain_size) {
+    size_t last = std::min(end, first + grain_size);
+    PushTask([this, &job, &body, first, last]() {
+      std::exception_ptr error;
+      try {
+        RunRange(first, last, body);
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      std::lock_guard<std::mutex> lock(job.mutex_);
+      if (error && !job.error_) {
+        job.error_ = error;
+      }
+      if (--job.remaining_ == 0) {
+        job.finished_.notify_all();
+      }
+    });
+  }
+
+  // Help run queued tasks rather than block a thread the pool could use.
+  // The job is only left once its count is seen at 0 under its lock, so no
+  // task can still be using it.
+  function<void()> task;
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(job.mutex_);
+      if (job.remaining_ == 0) {
+        break;
+      }
+    }
+
+    if (TakeTask(queues_.size(), task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+
+    // Every task left is already running on a worker
+    std::unique_lock<std::mutex> lock(job.mutex_);
+    job.finished_.wait(lock, [&job]() { return job.remaining_ == 0; });
+    break;
+  }
+
+  if (job.error_) {
+    std::rethrow_exception(job.error_);
+  }
+}
+
+void ThreadPool::StartWorkers(size_t thread_count, Placement placement) {
+  thread_count_ = thread_count == 0 ? GetCoreCount() : thread_count;
+  placement_ = placement;
+  is_stopping_ = false;
+
+  // Unpinned workers could be anywhere, so they are all counted as node 0
+  NumaTopology topology = placement == Placement::kAnywhere
+                              ? NumaTopology(GetCoreCount())
+                              : NumaTopology::Detect();
+  std::vector<std::pair<size_t, size_t>> cores = topology.InterleaveCores();
+  node_count_ = topology.GetNodeCount();
+  std::vector<std::atomic<size_t>> node_index_counts(node_count_);
+  node_index_counts_.swap(node_index_counts);
+  ResetNodeIndexCounts();
+
+  // WorkerQueue holds a mutex, so it can only be built in place
+  for (size_t worker = 0; worker + 1 < thread_count_; worker++) {
+    queues_.emplace_back();
+  }
+
+  // The thread that starts the work is unpinned, so the workers take every
+  // core in turn, and wrap around if there are more workers than cores
+  for (size_t worker = 0; worker + 1 < thread_count_; worker++) {
+    const std::pair<size_t, size_t>& core = cores[worker % cores.size()];
+    workers_.emplace_back(&ThreadPool::RunWorker, this, worker, core.first,
+                          core.second);
+  }
+}
+
+void ThreadPool::StopWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    is_stopping_ = true;
+  }
+  task_queued_.notify_all();
+
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+
+  workers_.clear();
+  queues_.clear();
+  queued_count_ = 0;
+}
+
+void ThreadPool::RunWorker(size_t worker_index, size_t core, size_t node) {
+  if (placement_ != Placement::kAnywhere) {
+    current_node = node;
+
+    // Other platforms have no way to pin a thread, so it is only counted
+#ifdef __linux__
+    cpu_set_t core_set;
+    CPU_ZERO(&core_set);
+    CPU_SET(core, &core_set);
+    pthread_setaffinity_np(pthread_self(), sizeof(core_set), &core_set);
+#else
+    (void) core;
+#endif
+  }
+
+  function<void()> task;
+  while (true) {
+    if (TakeTask(worker_index, task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    task_queued_.wait(lock, [this]() {
+      return is_stopping_ || queued_count_ > 0;
+    });
+
+    if (is_stopping_) {
+      return;
+    }
+  }
+}
+
+void ThreadPool::RunRange(size_t first, size_t last,
+                          const function<void(size_t, size_t)>& body) {
+  body(first, last);
+  node_index_counts_[current_node % node_count_] += last - first;
+}
+
+void ThreadPool::PushTask(function<void()> task) {
+  // Count the task before it can be taken, so the count never drops below 0
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    queued_count_++;
+  }
+
+  WorkerQueue& queue = queues_[next_queue_++ % queues_.size()];
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex_);
+    queue.tasks_.push_back(std::move(task));
+  }
+
+  task_queued_.notify_one();
+}
+
+bool ThreadPool::TakeTask(size_t worker_index, function<void()>& task) {
+  if (worker_index < queues_.size()) {
+    WorkerQueue& own_queue = queues_[worker_index];
+    std::lock_guard<std::mutex> lock(own_queue.mutex_);
+    if (!own_queue.tasks_.empty()) {
+      task = std::move(own_queue.tasks_.back());
+      own_queue.tasks_.pop_back();
+      queued_count_--;
+      return true;
+    }
+  }
+
+  for (size_t offset = 1; offset <= queues_.size(); offset++) {
+    size_t victim = (worker_index + offset) % queues_.size();
+    if (victim == worker_index) {
+      continue;
+    }
+
+    WorkerQueue& queue = queues_[victim];
+    std::lock_guard<std::mutex> lock(queue.mutex_);
+    if (!queue.tasks_.empty()) {
+      task = std::move(queue.tasks_.front());
+      queue.tasks_.pop_front();
+      queued_count_--;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+} // namespace naivebayes
@@ -0,0 +1,131 @@
+#include "core/trace.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include <nlohmann/json.hpp>
+
+namespace naivebayes {
+
+using std::chrono::steady_clock;
+
+namespace {
+
+/**
+ * A phase of the pipeline one thread spent time in.
+ */
+struct Span {
+  const char* name_;
+  double start_microseconds_;
+  double duration_microseconds_;
+};
+
+/**
+ * The spans of one thread, which only that thread appends to. Buffers
+ * outlive their threads, so the spans of finished threads are kept.
+ */
+struct ThreadBuffer {
+  size_t thread_index_;
+  std::vector<Span> spans_;
+};
+
+std::atomic<bool> is_tracing(false);
+
+// Spans are timed from when the program started, not from when tracing was
+// enabled, so spans kept across several enabled periods share one timeline
+const steady_clock::time_point trace_epoch = steady_clock::now();
+
+// Only registering a thread's buffer takes the lock, never recording a span
+std::mutex buffers_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> thread_buffers;
+
+thread_local ThreadBuffer* thread_buffer = nullptr;
+
+// Every span is a complete event of a single process in the trace format
+const char* const kCompleteEventPhase = "X";
+constexpr size_t kProcessId = 1;
+
+/**
+ * Getter for the buffer of the calling thread, creating it the first time
+ * the thread records a span.
+ * @return a reference to the ThreadBuffer of the calling thread
+ */
+ThreadBuffer& GetThreadBuffer() {
+  if (thread_buffer == nullptr) {
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    thread_buffers.emplace_back(new ThreadBuffer());
+    thread_buffers.back()->thread_index_ = thread_buffers.size() - 1;
+    thread_buffer = thread_buffers.back().get();
+  }
+
+  return *thread_buffer;
+}
+
+} // namespace
+
+void Tracer::SetEnabled(bool is_enabled) {
+  is_tracing = is_enabled;
+}
+
+bool Tracer::IsEnabled() {
+  return is_tracing;
+}
+
+size_t Tracer::GetSpanCount() {
+  std::lock_guard<std::mutex> lock(buffers_mutex);
+  size_t span_count = 0;
+  for (const std::unique_ptr<ThreadBuffer>& buffer : thread_buffers) {
+    span_count += buffer->spans_.size();
+  }
+
+  return span_count;
+}
+
+void Tracer::Clear() {
+  std::lock_guard<std::mutex> lock(buffers_mutex);
+  for (const std::unique_ptr<ThreadBuffer>& buffer : thread_buffers) {
+    buffer->spans_.clear();
+  }
+}
+
+void Tracer::Write(std::ostream& output) {
+  nlohmann::json events = nlohmann::json::array();
+
+  std::lock_guard<std::mutex> lock(buffers_mutex);
+  for (const std::unique_ptr<ThreadBuffer>& buffer : thread_buffers) {
+    for (const Span& span : buffer->spans_) {
+      events.push_back({{"name", span.name_},
+                        {"ph", kCompleteEventPhase},
+                        {"ts", span.start_microseconds_},
+                        {"dur", span.duration_microseconds_},
+                        {"pid", kProcessId},
+                        {"tid", buffer->thread_index_}});
+    }
+  }
+
+  output << nlohmann::json({{"traceEvents", events}}) << std::endl;
+}
+
+void Tracer::Record(const char* name, steady_clock::time_point start,
+                    steady_clock::time_point end) {
+  std::chrono::duration<double, std::micro> start_time = start - trace_epoch;
+  std::chrono::duration<double, std::micro> duration = end - start;
+  GetThreadBuffer().spans_.push_back(
+      {name, start_time.count(), duration.count()});
+}
+
+TraceSpan::TraceSpan(const char* name)
+    : name_(name), is_recording_(Tracer::IsEnabled()) {
+  if (is_recording_) {
+    start_ = steady_clock::now();
+  }
+}
+
+TraceSpan::~TraceSpan() {
+  if (is_recording_) {
+    Tracer::Record(name_, start_, steady_clock::now());
+  }
+}
+
+} // namespace naivebayes
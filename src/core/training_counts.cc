@@ -0,0 +1,300 @@
+#include "core/training_counts.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "core/thread_pool.h"
+#include "core/trace.h"
+
+namespace naivebayes {
+
+using nlohmann::json;
+using std::vector;
+using std::string;
+
+const string TrainingCounts::kJsonSchemaHeightKey = "height";
+const string TrainingCounts::kJsonSchemaWidthKey = "width";
+const string TrainingCounts::kJsonSchemaClassesKey = "classes";
+const string TrainingCounts::kJsonSchemaLabelKey = "label";
+const string TrainingCounts::kJsonSchemaClassCountKey = "class_count";
+const string TrainingCounts::kJsonSchemaShadingCountsKey = "shading_counts";
+
+TrainingCounts::TrainingCounts() : height_(0), width_(0), image_count_(0) {}
+
+void TrainingCounts::AddImage(const Image& image) {
+  AddImage(image, 1);
+}
+
+void TrainingCounts::AddImage(const Image& image, double weight) {
+  if (weight < 0 || !std::isfinite(weight)) {
+    throw std::invalid_argument("Image weights must be finite and not negative.");
+  } else if (height_ == 0) {
+    height_ = image.GetHeight();
+    width_ = image.GetWidth();
+  } else if (image.GetHeight() != height_ || image.GetWidth() != width_) {
+    throw std::invalid_argument("The images are not of uniform size");
+  }
+
+  vector<double>& counts = shading_counts_[image.GetLabel()];
+  if (counts.empty()) {
+    counts = vector<double>(
+        Image::kDistinctShadingEncodings.size() * height_ * width_, 0);
+  }
+
+  for (size_t row = 0; row < height_; row++) {
+    for (size_t column = 0; column < width_; column++) {
+      counts[GetFeatureIndex(image.GetPixel(row, column), row, column)] +=
+          weight;
+    }
+  }
+
+  class_counts_[image.GetLabel()] += weight;
+  image_count_ += weight;
+}
+
+void TrainingCounts::AddImages(const vector<Image>& images,
+                               const vector<double>& weights) {
+  AddInParallel(images.size(), [&](TrainingCounts& counts, size_t index) {
+    counts.AddImage(images[index], weights[index]);
+  });
+}
+
+void TrainingCounts::AddDataset(const Dataset& dataset) {
+  // Classes can differ a lot in size, so split the images, not the classes
+  vector<const Image*> images;
+  images.reserve(dataset.GetSize());
+  for (char label : dataset.GetDistinctLabels()) {
+    for (const Image& image : dataset.GetImageGroup(label)) {
+      images.push_back(&image);
+    }
+  }
+
+  AddInParallel(images.size(), [&](TrainingCounts& counts, size_t index) {
+    counts.AddImage(*images[index]);
+  });
+}
+
+void TrainingCounts::AddDataset(const DeduplicatedDataset& dataset) {
+  AddInParallel(dataset.GetEntryCount(),
+                [&](TrainingCounts& counts, size_t entry) {
+    counts.AddImage(dataset.GetImage(entry), dataset.GetWeight(entry));
+  });
+}
+
+void TrainingCounts::Merge(const TrainingCounts& other) {
+  if (other.height_ == 0) {
+    return;
+  } else if (height_ == 0) {
+    height_ = other.height_;
+    width_ = other.width_;
+  } else if (other.height_ != height_ || other.width_ != width_) {
+    throw std::invalid_argument("The images are not of uniform size");
+  }
+
+  for (const auto& class_count : other.class_counts_) {
+    class_counts_[class_count.first] += class_count.second;
+  }
+
+  // Sum the shading counts of each class feature by feature
+  for (const auto& other_counts : other.shading_counts_) {
+    vector<double>& counts = shading_counts_[other_counts.first];
+    if (counts.empty()) {
+      counts = other_counts.second;
+      continue;
+    }
+
+    for (size_t index = 0; index < counts.size(); index++) {
+      counts[index] += other_counts.second[index];
+    }
+  }
+
+  image_count_ += other.image_count_;
+}
+
+void TrainingCounts::Subtract(const TrainingCounts& other) {
+  if (other.height_ == 0) {
+    return;
+  } else if (IsBelow(image_count_, other.image_count_) ||
+             other.height_ != height_ || other.width_ != width_) {
+    throw std::invalid_argument("Only counted images can be subtracted.");
+  }
+
+  // Check every count first so a failed subtraction leaves these counts intact
+  for (const auto& other_counts : other.shading_counts_) {
+    auto counts = shading_counts_.find(other_counts.first);
+    if (counts == shading_counts_.end() ||
+        IsBelow(class_counts_.at(other_counts.first),
+                other.class_counts_.at(other_counts.first))) {
+      throw std::invalid_argument("Only counted images can be subtracted.");
+    }
+
+    for (size_t index = 0; index < other_counts.second.size(); index++) {
+      if (IsBelow(counts->second[index], other_counts.second[index])) {
+        throw std::invalid_argument("Only counted images can be subtracted.");
+      }
+    }
+  }
+
+  // Clamp at 0 so rounding never leaves a count negative
+  for (const auto& other_counts : other.shading_counts_) {
+    vector<double>& counts = shading_counts_.at(other_counts.first);
+    for (size_t index = 0; index < counts.size(); index++) {
+      counts[index] = std::max(0.0, counts[index] - other_counts.second[index]);
+    }
+
+    double& class_count = class_counts_.at(other_counts.first);
+    class_count = std::max(
+        0.0, class_count - other.class_counts_.at(other_counts.first));
+  }
+
+  image_count_ = std::max(0.0, image_count_ - other.image_count_);
+}
+
+void TrainingCounts::BalanceClasses() {
+  if (class_counts_.empty()) {
+    return;
+  }
+
+  double balanced_count = image_count_ / class_counts_.size();
+
+  // Scaling a class's counts is the same as scaling the weight of its images
+  for (auto& class_count : class_counts_) {
+    if (class_count.second <= 0) {
+      continue;  // a class with no weight can't be scaled up to any weight
+    }
+
+    double scale = balanced_count / class_count.second;
+    for (double& count : shading_counts_.at(class_count.first)) {
+      count *= scale;
+    }
+    class_count.second = balanced_count;
+  }
+
+  // Classes with no weight do not get any, so the total can shrink
+  image_count_ = 0;
+  for (const auto& class_count : class_counts_) {
+    image_count_ += class_count.second;
+  }
+}
+
+double TrainingCounts::GetImageCount() const {
+  return image_count_;
+}
+
+size_t TrainingCounts::GetHeight() const {
+  return height_;
+}
+
+size_t TrainingCounts::GetWidth() const {
+  return width_;
+}
+
+vector<char> TrainingCounts::GetDistinctLabels() const {
+  vector<char> labels;
+
+  for (const auto& class_count : class_counts_) {
+    labels.push_back(class_count.first);
+  }
+
+  return labels;
+}
+
+double TrainingCounts::GetClassCount(char class_label) const {
+  return class_counts_.at(class_label);
+}
+
+double TrainingCounts::GetShadingCount(char class_label, Shading shading,
+                                       size_t row, size_t column) const {
+  return shading_counts_.at(class_label).at(
+      GetFeatureIndex(shading, row, column));
+}
+
+void TrainingCounts::AddInParallel(
+    size_t image_count,
+    const std::function<void(TrainingCounts&, size_t)>& count_image) {
+  // Each task writes only to its own counts, so counting never takes a lock
+  size_t grain_size = kCountingGrainSize;
+  vector<TrainingCounts> task_counts((image_count + grain_size - 1) /
+                                     grain_size);
+  ThreadPool::GetShared().ParallelFor(0, image_count, grain_size,
+                                      [&](size_t first, size_t last) {
+    TraceSpan span("Count images");
+    TrainingCounts& counts = task_counts[first / grain_size];
+    for (size_t index = first; index < last; index++) {
+      count_image(counts, index);
+    }
+  });
+
+  for (const TrainingCounts& counts : task_counts) {
+    Merge(counts);
+  }
+}
+
+bool TrainingCounts::IsBelow(double count, double subtracted_count) {
+  return count < subtracted_count * (1 - kSubtractTolerance);
+}
+
+size_t TrainingCounts::GetFeatureIndex(Shading shading, size_t row,
+                                       size_t column) const {
+  return (static_cast<size_t>(shading) * height_ + row) * width_ + column;
+}
+
+std::ostream& operator<<(std::ostream& output, const TrainingCounts& counts) {
+  json serialized_classes = json::array();
+
+  // Store only counts, so checkpoints can be summed before any smoothing
+  for (const auto& class_count : counts.class_counts_) {
+    json class_object;
+    class_object[TrainingCounts::kJsonSchemaLabelKey] =
+        string(1, class_count.first);
+    class_object[TrainingCounts::kJsonSchemaClassCountKey] = class_count.second;
+    class_object[TrainingCounts::kJsonSchemaShadingCountsKey] =
+        counts.shading_counts_.at(class_count.first);
+
+    serialized_classes.push_back(class_object);
+  }
+
+  json serialized_counts;
+  serialized_counts[TrainingCounts::kJsonSchemaHeightKey] = counts.height_;
+  serialized_counts[TrainingCounts::kJsonSchemaWidthKey] = counts.width_;
+  serialized_counts[TrainingCounts::kJsonSchemaClassesKey] = serialized_classes;
+
+  output << serialized_counts.dump(TrainingCounts::kJsonSchemaSpacing);
+  output << std::endl;
+  return output;
+}
+
+std::istream& operator>>(std::istream& input, TrainingCounts& counts) {
+  json serialized_counts;
+  input >> serialized_counts;
+
+  counts = TrainingCounts();
+  counts.height_ = serialized_counts[TrainingCounts::kJsonSchemaHeightKey];
+  counts.width_ = serialized_counts[TrainingCounts::kJsonSchemaWidthKey];
+
+  size_t feature_count =
+      Image::kDistinctShadingEncodings.size() * counts.height_ * counts.width_;
+
+  // Go through each class json object to deserialize its counts
+  for (const json& class_object :
+       serialized_counts[TrainingCounts::kJsonSchemaClassesKey]) {
+    string class_string = class_object[TrainingCounts::kJsonSchemaLabelKey];
+    char class_label = class_string.at(0);
+
+    double class_count = class_object[TrainingCounts::kJsonSchemaClassCountKey];
+    vector<double> shading_counts =
+        class_object[TrainingCounts::kJsonSchemaShadingCountsKey];
+
+    if (shading_counts.size() != feature_count) {
+      throw std::invalid_argument("The checkpoint shading counts are invalid.");
+    }
+
+    counts.class_counts_[class_label] = class_count;
+    counts.shading_counts_[class_label] = shading_counts;
+    counts.image_count_ += class_count;
+  }
+
+  return input;
+}
+
+} // namespace naivebayes
@@ -9,7 +9,7 @@ const std::string NaiveBayesApp::kModelFilePath =
     "/Users/neilkaushikkar/Cinder/my-projects/"
     "naive-bayes-nkaush/data/cinder-app-model.json";
 const std::string NaiveBayesApp::kUsageInstructions = 
-    "Press Delete to clear the sketchpad. Press Enter to make a prediction.";
+    "Draw a digit to see a prediction. Press Delete to clear the sketchpad.";
 const std::string NaiveBayesApp::kPredictionIndicator = "Prediction: ";
 
 const char* NaiveBayesApp::kInstructionsColor = "black";
@@ -17,12 +17,17 @@ const char* NaiveBayesApp::kPredictionColor = "blue";
 
 NaiveBayesApp::NaiveBayesApp()
     : sketchpad_(glm::vec2(kMargin, kMargin), kImageDimension,
-                 kWindowSize - 2 * kMargin, 1) {
+                 kWindowSize - 2 * kMargin, 1),
+      current_prediction_(Image::kDefaultLabel) {
   std::ifstream model_file(kModelFilePath);
 
   if (model_file.is_open()) {
     model_file >> model_;  // Deserialize the model and load it in the stack
   }
+
+  // Score the blank sketchpad once, strokes only adjust these scores
+  live_classifier_ = LiveClassifier(model_, kImageDimension, kImageDimension);
+  current_prediction_ = live_classifier_.GetPrediction();
   
   ci::app::setWindowSize((int) kWindowSize, (int) kWindowSize);
 }
@@ -46,27 +51,37 @@ void NaiveBayesApp::draw() {
 }
 
 void NaiveBayesApp::mouseDown(ci::app::MouseEvent event) {
-  sketchpad_.HandleBrush(event.getPos());
+  HandleStroke(event.getPos());
 }
 
 void NaiveBayesApp::mouseDrag(ci::app::MouseEvent event) {
-  sketchpad_.HandleBrush(event.getPos());
+  HandleStroke(event.getPos());
 }
 
 void NaiveBayesApp::keyDown(ci::app::KeyEvent event) {
   switch (event.getCode()) {
-    case ci::app::KeyEvent::KEY_RETURN:
-      // Make a new Image with the pixels without specifying what label it is
-      current_prediction_ = model_.Classify(Image(sketchpad_.GetPixels(), 
-                                                  Image::kDefaultLabel));
-      break;
-
     case ci::app::KeyEvent::KEY_BACKSPACE:
       sketchpad_.Clear();
+      sketchpad_.ClearDirtyPixels();  // resetting is cheaper than replaying
+      live_classifier_.Reset();
+      current_prediction_ = live_classifier_.GetPrediction();
       break;
   }
 }
 
+void NaiveBayesApp::HandleStroke(const glm::vec2& brush_screen_coords) {
+  sketchpad_.HandleBrush(brush_screen_coords);
+
+  // Only the pixels this stroke changed can change the class scores
+  for (const PixelChange& change : sketchpad_.GetDirtyPixels()) {
+    live_classifier_.UpdatePixel(change.row_, change.column_,
+                                 change.previous_, change.current_);
+  }
+  sketchpad_.ClearDirtyPixels();
+
+  current_prediction_ = live_classifier_.GetPrediction();
+}
+
 }  // namespace visualizer
 
 }  // namespace naivebayes
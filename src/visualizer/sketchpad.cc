@@ -1,10 +1,12 @@
 #include <visualizer/sketchpad.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace naivebayes {
 
 namespace visualizer {
 
-using std::vector;
 using glm::vec2;
 
 Sketchpad::Sketchpad(const vec2& top_left_corner, size_t num_pixels_per_side,
@@ -12,54 +14,105 @@ Sketchpad::Sketchpad(const vec2& top_left_corner, size_t num_pixels_per_side,
     : top_left_corner_(top_left_corner),
       num_pixels_per_side_(num_pixels_per_side),
       pixel_side_length_(sketchpad_size / num_pixels_per_side),
-      brush_radius_(brush_radius) {
-  vector<Shading> default_rows(num_pixels_per_side_, Shading::kWhite);
-  pixels_ = vector<vector<Shading>>(num_pixels_per_side_, default_rows);
-}
+      brush_radius_(brush_radius),
+      pixels_(num_pixels_per_side * num_pixels_per_side, Shading::kWhite) {}
 
 void Sketchpad::Draw() const {
-  for (size_t row = 0; row < num_pixels_per_side_; ++row) {
-    for (size_t col = 0; col < num_pixels_per_side_; ++col) {
-      if (pixels_.at(row).at(col) == Shading::kBlack) {
-        ci::gl::color(ci::Color("black"));
-      } else {
-        ci::gl::color(ci::Color("white"));
-      }
+  // The app clears the window every frame, so the whole sketchpad is drawn
+  // again, but only the shaded pixels need a rectangle of their own
+  float sketchpad_side_length = num_pixels_per_side_ * pixel_side_length_;
+  vec2 sketchpad_bottom_right =
+      top_left_corner_ + vec2(sketchpad_side_length, sketchpad_side_length);
 
-      vec2 pixel_top_left = top_left_corner_ + vec2(col * pixel_side_length_,
-                                                    row * pixel_side_length_);
+  ci::gl::color(ci::Color("white"));
+  ci::gl::drawSolidRect(ci::Rectf(top_left_corner_, sketchpad_bottom_right));
 
-      vec2 pixel_bottom_right =
-          pixel_top_left + vec2(pixel_side_length_, pixel_side_length_);
-      ci::Rectf pixel_bounding_box(pixel_top_left, pixel_bottom_right);
+  ci::gl::color(ci::Color("black"));
+  for (size_t index : shaded_indices_) {
+    size_t row = index / num_pixels_per_side_;
+    size_t col = index % num_pixels_per_side_;
 
-      ci::gl::drawSolidRect(pixel_bounding_box);
+    vec2 pixel_top_left = top_left_corner_ + vec2(col * pixel_side_length_,
+                                                  row * pixel_side_length_);
 
-      ci::gl::color(ci::Color("black"));
-      ci::gl::drawStrokedRect(pixel_bounding_box);
-    }
+    vec2 pixel_bottom_right =
+        pixel_top_left + vec2(pixel_side_length_, pixel_side_length_);
+    ci::gl::drawSolidRect(ci::Rectf(pixel_top_left, pixel_bottom_right));
+  }
+
+  // Neighboring pixels share their borders, so each grid line is drawn once
+  for (size_t line = 0; line <= num_pixels_per_side_; ++line) {
+    float offset = line * pixel_side_length_;
+    ci::gl::drawLine(top_left_corner_ + vec2(offset, 0),
+                     top_left_corner_ + vec2(offset, sketchpad_side_length));
+    ci::gl::drawLine(top_left_corner_ + vec2(0, offset),
+                     top_left_corner_ + vec2(sketchpad_side_length, offset));
   }
 }
 
 void Sketchpad::HandleBrush(const vec2& brush_screen_coords) {
   vec2 brush_sketchpad_coords =
       (brush_screen_coords - top_left_corner_) / (float)pixel_side_length_;
+  double brush_x = brush_sketchpad_coords.x;
+  double brush_y = brush_sketchpad_coords.y;
 
-  for (size_t row = 0; row < num_pixels_per_side_; ++row) {
-    for (size_t col = 0; col < num_pixels_per_side_; ++col) {
-      vec2 pixel_center = {col + 0.5, row + 0.5};
+  // Pixel centers sit at (col + 0.5, row + 0.5), so only the pixels in this
+  // box around the brush can be within brush_radius_ of it
+  double max_index = static_cast<double>(num_pixels_per_side_) - 1;
+  double reach = brush_radius_ + 0.5;
+  double first_row = std::max(0.0, std::ceil(brush_y - reach));
+  double last_row = std::min(max_index, std::floor(brush_y + reach - 1));
+  double first_col = std::max(0.0, std::ceil(brush_x - reach));
+  double last_col = std::min(max_index, std::floor(brush_x + reach - 1));
 
-      if (glm::distance(brush_sketchpad_coords, pixel_center) <=
-          brush_radius_) {
-        pixels_.at(row).at(col) = Shading::kBlack;
+  if (first_row > last_row || first_col > last_col) {
+    return;  // the brush is entirely off of the sketchpad
+  }
+
+  double squared_radius = brush_radius_ * brush_radius_;
+  for (auto row = static_cast<size_t>(first_row);
+       row <= static_cast<size_t>(last_row); ++row) {
+    double y_offset = row + 0.5 - brush_y;
+
+    for (auto col = static_cast<size_t>(first_col);
+         col <= static_cast<size_t>(last_col); ++col) {
+      double x_offset = col + 0.5 - brush_x;
+
+      if (x_offset * x_offset + y_offset * y_offset <= squared_radius) {
+        SetPixel(row, col, Shading::kBlack);
       }
     }
   }
 }
 
 void Sketchpad::Clear() {
-  vector<Shading> default_rows(num_pixels_per_side_, Shading::kWhite);
-  pixels_ = vector<vector<Shading>>(num_pixels_per_side_, default_rows);
+  for (size_t index : shaded_indices_) {
+    SetPixel(index / num_pixels_per_side_, index % num_pixels_per_side_,
+             Shading::kWhite);
+  }
+
+  // clear() keeps the capacity around for the next drawing
+  shaded_indices_.clear();
+}
+
+void Sketchpad::ClearDirtyPixels() {
+  dirty_pixels_.clear();
+}
+
+void Sketchpad::SetPixel(size_t row, size_t col, Shading shading) {
+  size_t index = row * num_pixels_per_side_ + col;
+  Shading previous = pixels_.at(index);
+
+  if (previous == shading) {
+    return;
+  }
+
+  pixels_.at(index) = shading;
+  if (previous == Shading::kWhite) {
+    shaded_indices_.push_back(index);
+  }
+
+  dirty_pixels_.push_back({row, col, previous, shading});
 }
 
 }  // namespace visualizer
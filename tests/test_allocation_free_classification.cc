@@ -0,0 +1,136 @@
+#include <catch2/catch.hpp>
+
+#include <core/model.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+using naivebayes::Dataset;
+using naivebayes::Image;
+using naivebayes::Model;
+using std::ifstream;
+using std::vector;
+
+namespace {
+
+// Every allocation of the test binary is counted, so a test can check that
+// a call made none
+std::atomic<size_t> allocation_count(0);
+
+} // namespace
+
+// GCC checks the replaced operators against the standard allocators it
+// inlines, and wrongly warns that they don't match
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+  allocation_count++;
+  void* memory = std::malloc(size == 0 ? 1 : size);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return memory;
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+TEST_CASE("Test Allocation Free Classification") {
+  Model model = Model();
+  Dataset train_dataset = Dataset();
+
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  std::string file_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+                          "naive-bayes-nkaush/data/testing_train_dataset_5x5.txt";
+  ifstream train_input(file_path);
+  train_input >> train_dataset;
+  model.Train(train_dataset);
+
+  Dataset testing_dataset;
+  std::string test_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+                          "naive-bayes-nkaush/data/testing_test_dataset_5x5.txt";
+  ifstream test_input(test_path);
+  test_input >> testing_dataset;
+
+  // Each row is padded past the width, so a wrong stride reads the padding
+  const size_t kStride = 8;
+  vector<Image> images;
+  vector<vector<uint8_t>> code_buffers;
+  vector<vector<uint8_t>> packed_buffers;
+  for (char label : testing_dataset.GetDistinctLabels()) {
+    for (const Image& image : testing_dataset.GetImageGroup(label)) {
+      vector<uint8_t> codes(image.GetHeight() * kStride, 0xFF);
+      for (size_t row = 0; row < image.GetHeight(); row++) {
+        for (size_t column = 0; column < image.GetWidth(); column++) {
+          codes[row * kStride + column] = 
+              static_cast<uint8_t>(image.GetPixel(row, column));
+        }
+      }
+
+      images.push_back(image);
+      code_buffers.push_back(codes);
+      packed_buffers.push_back(image.Pack());
+    }
+  }
+
+  SECTION("Test classifying codes and packed pixels predicts like an Image") {
+    for (size_t idx = 0; idx < images.size(); idx++) {
+      char expected = model.Classify(images[idx]);
+
+      REQUIRE(model.Classify(code_buffers[idx].data(), 5, 5, kStride) == 
+              expected);
+      REQUIRE(model.ClassifyPacked(packed_buffers[idx].data(), 5, 5) == 
+              expected);
+    }
+  }
+
+  SECTION("Test classifying codes and packed pixels never allocates") {
+    vector<char> predictions(images.size() * 2);
+
+    size_t allocations_before = allocation_count;
+    for (size_t idx = 0; idx < images.size(); idx++) {
+      predictions[2 * idx] = 
+          model.Classify(code_buffers[idx].data(), 5, 5, kStride);
+      predictions[2 * idx + 1] = 
+          model.ClassifyPacked(packed_buffers[idx].data(), 5, 5);
+    }
+    size_t allocations_after = allocation_count;
+
+    REQUIRE(allocations_after == allocations_before);
+    REQUIRE(predictions[0] == model.Classify(images[0]));
+
+    // Packing allocates, so the hook is known to count allocations
+    vector<uint8_t> packed = images[0].Pack();
+    REQUIRE(allocation_count > allocations_after);
+  }
+
+  SECTION("Test classifying an image of the wrong size") {
+    REQUIRE_THROWS_AS(model.Classify(code_buffers[0].data(), 4, 5, kStride),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(model.ClassifyPacked(packed_buffers[0].data(), 5, 6),
+                      std::invalid_argument);
+  }
+
+  SECTION("Test classifying with a stride smaller than the width") {
+    REQUIRE_THROWS_AS(model.Classify(code_buffers[0].data(), 5, 5, 4),
+                      std::invalid_argument);
+  }
+
+  SECTION("Test classifying a code with no Shading") {
+    vector<uint8_t> codes(5 * 5, 7);
+
+    REQUIRE_THROWS_AS(model.Classify(codes.data(), 5, 5, 5),
+                      std::invalid_argument);
+  }
+}
@@ -0,0 +1,87 @@
+#include <catch2/catch.hpp>
+
+#include <core/cascade_classifier.h>
+
+#include <algorithm>
+#include <fstream>
+
+using naivebayes::CascadeClassifier;
+using naivebayes::Dataset;
+using naivebayes::Image;
+using naivebayes::Model;
+using std::ifstream;
+using std::vector;
+
+using LongMatrix = vector<vector<size_t>>;
+
+TEST_CASE("Test Cascade Classification") {
+  Model model = Model();
+  Dataset train_dataset = Dataset();
+
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  std::string file_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+                          "naive-bayes-nkaush/data/testing_train_dataset_5x5.txt";
+  ifstream train_input(file_path);
+  train_input >> train_dataset;
+  model.Train(train_dataset);
+
+  CascadeClassifier cascade(model);
+
+  SECTION("Test pixels are ranked as a permutation of every pixel") {
+    vector<size_t> ranked_pixels = model.RankPixels();
+    REQUIRE(ranked_pixels.size() == 25);
+
+    std::sort(ranked_pixels.begin(), ranked_pixels.end());
+    for (size_t idx = 0; idx < ranked_pixels.size(); idx++) {
+      REQUIRE(ranked_pixels.at(idx) == idx);
+    }
+  }
+
+  SECTION("Test uncalibrated cascade escalates every image") {
+    size_t escalated_count = 0;
+    LongMatrix actual = cascade.Test(train_dataset, escalated_count);
+
+    REQUIRE(cascade.GetPixelCount() == 0);
+    REQUIRE(escalated_count == train_dataset.GetSize());
+    REQUIRE(actual == model.Test(train_dataset, false));
+  }
+
+  SECTION("Test calibrated cascade keeps the model's accuracy") {
+    cascade.Calibrate(train_dataset, 0);
+
+    size_t escalated_count = 0;
+    LongMatrix actual = cascade.Test(train_dataset, escalated_count);
+
+    REQUIRE(Model::CalculateAccuracy(actual) >=
+            Model::CalculateAccuracy(model.Test(train_dataset, false)));
+  }
+
+  SECTION("Test images the cascade keeps are beyond the margin") {
+    cascade.Calibrate(train_dataset, 1);
+    vector<char> labels = model.GetLabels();
+
+    for (char label : train_dataset.GetDistinctLabels()) {
+      for (const Image& image : train_dataset.GetImageGroup(label)) {
+        bool is_escalated = true;
+        char predicted = cascade.Classify(image, is_escalated);
+        float margin = 0;
+        size_t stage_one_idx = cascade.ClassifyStageOne(image, margin);
+
+        if (is_escalated) {
+          REQUIRE(margin < cascade.GetMarginThreshold());
+          REQUIRE(predicted == model.Classify(image));
+        } else {
+          REQUIRE(margin >= cascade.GetMarginThreshold());
+          REQUIRE(predicted == labels.at(stage_one_idx));
+        }
+      }
+    }
+
+    // Allowing any accuracy loss, stage one should keep some of the images
+    size_t escalated_count = 0;
+    cascade.Test(train_dataset, escalated_count);
+    REQUIRE(escalated_count < train_dataset.GetSize());
+    REQUIRE(cascade.GetPixelCount() > 0);
+    REQUIRE(cascade.GetPixelCount() < 25);
+  }
+}
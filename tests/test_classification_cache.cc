@@ -0,0 +1,122 @@
+#include <catch2/catch.hpp>
+
+#include <core/classification_cache.h>
+
+#include <fstream>
+#include <thread>
+
+using naivebayes::ClassificationCache;
+using naivebayes::Dataset;
+using naivebayes::Shading;
+using naivebayes::Image;
+using naivebayes::Model;
+using std::ifstream;
+using std::vector;
+
+TEST_CASE("Test Classification Cache") {
+  Model model = Model();
+  Dataset train_dataset = Dataset();
+
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  std::string file_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+                          "naive-bayes-nkaush/data/testing_train_dataset_5x5.txt";
+  ifstream train_input(file_path);
+  train_input >> train_dataset;
+  model.Train(train_dataset);
+
+  Image zero = train_dataset.GetImageGroup('0').at(0);
+  Image one = train_dataset.GetImageGroup('1').at(0);
+
+  SECTION("Test a repeated image is a hit with the same prediction") {
+    ClassificationCache cache(8);
+
+    REQUIRE(cache.Classify(model, zero) == model.Classify(zero));
+    REQUIRE(cache.Classify(model, zero) == model.Classify(zero));
+    REQUIRE(cache.GetHitCount() == 1);
+    REQUIRE(cache.GetMissCount() == 1);
+  }
+
+  SECTION("Test cached scores match the model's scores") {
+    ClassificationCache cache(8);
+    vector<float> expected = model.CalculateLikelihoodScores({one}).at(0);
+    cache.Insert(one, model.GetGeneration(), expected);
+
+    vector<float> actual;
+    REQUIRE(cache.Find(one, model.GetGeneration(), actual));
+    REQUIRE(actual == expected);
+    REQUIRE_FALSE(cache.Find(zero, model.GetGeneration(), actual));
+  }
+
+  SECTION("Test the least recently used image is evicted") {
+    // One image per shard, so two images in the same shard evict each other
+    size_t shard_count = ClassificationCache::kShardCount;
+    ClassificationCache cache(shard_count);
+    vector<float> scores;
+    size_t inserted_count = 0;
+
+    for (char label : train_dataset.GetDistinctLabels()) {
+      for (const Image& image : train_dataset.GetImageGroup(label)) {
+        cache.Classify(model, image);
+        inserted_count++;
+      }
+    }
+
+    size_t cached_count = 0;
+    for (char label : train_dataset.GetDistinctLabels()) {
+      for (const Image& image : train_dataset.GetImageGroup(label)) {
+        cached_count += cache.Find(image, model.GetGeneration(), scores);
+      }
+    }
+
+    REQUIRE(cached_count + cache.GetEvictionCount() <= inserted_count);
+    REQUIRE(cached_count <= shard_count);
+  }
+
+  SECTION("Test a zero capacity cache never hits") {
+    ClassificationCache cache(0);
+
+    cache.Classify(model, zero);
+    cache.Classify(model, zero);
+    REQUIRE(cache.GetHitCount() == 0);
+  }
+
+  SECTION("Test changing the model invalidates the cache") {
+    ClassificationCache cache(8);
+    cache.Classify(model, zero);
+
+    uint64_t old_generation = model.GetGeneration();
+    model.Prune(3);
+    REQUIRE(model.GetGeneration() != old_generation);
+
+    vector<float> scores;
+    REQUIRE_FALSE(cache.Find(zero, model.GetGeneration(), scores));
+    REQUIRE(cache.GetInvalidationCount() == 1);
+    REQUIRE(cache.Classify(model, zero) == model.Classify(zero));
+  }
+
+  SECTION("Test many threads can share the cache") {
+    ClassificationCache cache(4);
+    vector<std::thread> threads;
+    vector<bool> is_correct(4, true);
+
+    for (size_t thread_idx = 0; thread_idx < 4; thread_idx++) {
+      threads.emplace_back([&, thread_idx]() {
+        for (size_t repeat = 0; repeat < 200; repeat++) {
+          const Image& image = (repeat + thread_idx) % 2 == 0 ? zero : one;
+          if (cache.Classify(model, image) != model.Classify(image)) {
+            is_correct[thread_idx] = false;
+          }
+        }
+      });
+    }
+
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+
+    for (bool thread_is_correct : is_correct) {
+      REQUIRE(thread_is_correct);
+    }
+    REQUIRE(cache.GetHitCount() + cache.GetMissCount() == 800);
+  }
+}
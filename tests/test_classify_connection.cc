@@ -0,0 +1,150 @@
+#include <catch2/catch.hpp>
+
+#include <core/classify_connection.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+
+using naivebayes::ClassifyConnection;
+using naivebayes::ClassifyResponse;
+using naivebayes::RequestType;
+using naivebayes::Shading;
+using naivebayes::Image;
+using std::string;
+using std::vector;
+
+namespace {
+
+/**
+ * Writes raw bytes to a socket, so malformed messages can be sent.
+ */
+void WriteRaw(int socket_fd, const vector<uint8_t>& bytes) {
+  REQUIRE(write(socket_fd, bytes.data(), bytes.size()) ==
+          static_cast<ssize_t>(bytes.size()));
+}
+
+/**
+ * Builds a classify request message with the given header fields and
+ * packed pixel bytes, sizing it to fit them.
+ */
+vector<uint8_t> BuildRequest(uint16_t height, uint16_t width,
+                             const vector<uint8_t>& packed) {
+  auto payload_size = static_cast<uint32_t>(sizeof(uint8_t) +
+                                            2 * sizeof(uint16_t) +
+                                            packed.size());
+  vector<uint8_t> message(sizeof(payload_size) + payload_size);
+  uint8_t* bytes = message.data();
+  std::memcpy(bytes, &payload_size, sizeof(payload_size));
+  bytes[sizeof(payload_size)] = static_cast<uint8_t>(RequestType::kClassify);
+  std::memcpy(bytes + sizeof(payload_size) + 1, &height, sizeof(height));
+  std::memcpy(bytes + sizeof(payload_size) + 3, &width, sizeof(width));
+  std::copy(packed.begin(), packed.end(), bytes + sizeof(payload_size) + 5);
+
+  return message;
+}
+
+} // namespace
+
+TEST_CASE("Test Classify Connection") {
+  int socket_fds[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, socket_fds) == 0);
+  ClassifyConnection client(socket_fds[0]);
+  ClassifyConnection server(socket_fds[1]);
+
+  Image image({{Shading::kBlack, Shading::kWhite, Shading::kGray},
+               {Shading::kWhite, Shading::kGray, Shading::kBlack}}, '1');
+
+  SECTION("Test a classify request round trip") {
+    REQUIRE(client.WriteRequest(image));
+
+    RequestType type;
+    Image received;
+    REQUIRE(server.ReadRequest(type, received));
+    REQUIRE(type == RequestType::kClassify);
+    REQUIRE(received.GetHeight() == 2);
+    REQUIRE(received.GetWidth() == 3);
+    REQUIRE(received.Pack() == image.Pack());
+    // Catch takes its operands by reference, which kDefaultLabel can't bind
+    char default_label = Image::kDefaultLabel;
+    REQUIRE(received.GetLabel() == default_label);
+  }
+
+  SECTION("Test a response round trip") {
+    ClassifyResponse response = {'1', {'0', '1'}, {-4.5f, -1.25f}};
+    REQUIRE(server.WriteResponse(response));
+
+    ClassifyResponse received;
+    REQUIRE(client.ReadResponse(received));
+    REQUIRE(received.label_ == '1');
+    REQUIRE(received.labels_ == response.labels_);
+    REQUIRE(received.scores_ == response.scores_);
+  }
+
+  SECTION("Test a control request round trip") {
+    REQUIRE(client.WriteControlRequest(RequestType::kStats));
+
+    RequestType type;
+    Image received;
+    REQUIRE(server.ReadRequest(type, received));
+    REQUIRE(type == RequestType::kStats);
+
+    REQUIRE(server.WriteText("{}"));
+    string text;
+    REQUIRE(client.ReadText(text));
+    REQUIRE(text == "{}");
+  }
+
+  SECTION("Test a truncated frame") {
+    // The frame claims more pixels than it carries before the client closes
+    vector<uint8_t> message = BuildRequest(2, 3, image.Pack());
+    message.pop_back();
+    WriteRaw(socket_fds[0], message);
+    shutdown(socket_fds[0], SHUT_WR);
+
+    RequestType type;
+    Image received;
+    REQUIRE_FALSE(server.ReadRequest(type, received));
+    REQUIRE_FALSE(server.IsOpen());
+  }
+
+  SECTION("Test a payload that doesn't match its image size") {
+    vector<uint8_t> packed = image.Pack();
+    packed.push_back(0);
+    WriteRaw(socket_fds[0], BuildRequest(2, 3, packed));
+
+    RequestType type;
+    Image received;
+    REQUIRE_FALSE(server.ReadRequest(type, received));
+    REQUIRE_FALSE(server.IsOpen());
+  }
+
+  SECTION("Test an image with a height of 0") {
+    WriteRaw(socket_fds[0], BuildRequest(0, 3, vector<uint8_t>()));
+
+    RequestType type;
+    Image received;
+    REQUIRE_FALSE(server.ReadRequest(type, received));
+    REQUIRE_FALSE(server.IsOpen());
+  }
+
+  SECTION("Test an image with a width of 0") {
+    WriteRaw(socket_fds[0], BuildRequest(2, 0, vector<uint8_t>()));
+
+    RequestType type;
+    Image received;
+    REQUIRE_FALSE(server.ReadRequest(type, received));
+    REQUIRE_FALSE(server.IsOpen());
+  }
+
+  SECTION("Test an unknown request type") {
+    vector<uint8_t> message = BuildRequest(2, 3, image.Pack());
+    message[sizeof(uint32_t)] = 7;
+    WriteRaw(socket_fds[0], message);
+
+    RequestType type;
+    Image received;
+    REQUIRE_FALSE(server.ReadRequest(type, received));
+  }
+}
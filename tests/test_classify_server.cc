@@ -0,0 +1,242 @@
+#include <catch2/catch.hpp>
+
+#include <core/classify_server.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+using naivebayes::ClassifyConnection;
+using naivebayes::ClassifyResponse;
+using naivebayes::ClassifyServer;
+using naivebayes::Dataset;
+using naivebayes::Image;
+using naivebayes::Model;
+using naivebayes::RequestType;
+using naivebayes::Shading;
+using nlohmann::json;
+using std::ifstream;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Need long verbose filepath since Cmake/Cinder can't locate local file path
+const string kModelPath = "/Users/neilkaushikkar/Cinder/my-projects/"
+                          "naive-bayes-nkaush/data/testing_model.json";
+const string kSocketPath = "/tmp/naive_bayes_test_classify_server.sock";
+
+// How long to wait for the server to start listening, in 10ms attempts
+const size_t kConnectAttempts = 500;
+
+/**
+ * Connects to the server, waiting for it to start listening first.
+ */
+int ConnectWhenListening() {
+  for (size_t attempt = 0; attempt < kConnectAttempts; attempt++) {
+    int socket_fd = ClassifyConnection::Connect(kSocketPath);
+    if (socket_fd >= 0) {
+      return socket_fd;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  return -1;
+}
+
+/**
+ * Sends each image on its own connection at the same time, so the server
+ * sees them as concurrent requests, and returns the responses in order.
+ */
+vector<ClassifyResponse> ClassifyConcurrently(const vector<Image>& images) {
+  vector<ClassifyResponse> responses(images.size());
+  vector<char> is_answered(images.size(), false);
+  vector<std::thread> clients;
+
+  for (size_t index = 0; index < images.size(); index++) {
+    clients.emplace_back([&, index]() {
+      ClassifyConnection connection(ConnectWhenListening());
+      is_answered[index] = connection.WriteRequest(images[index]) &&
+                           connection.ReadResponse(responses[index]);
+    });
+  }
+
+  for (std::thread& client : clients) {
+    client.join();
+  }
+
+  REQUIRE(std::find(is_answered.begin(), is_answered.end(), false) ==
+          is_answered.end());
+  return responses;
+}
+
+/**
+ * Gathers every image of a dataset into one vector.
+ */
+vector<Image> GatherImages(const Dataset& dataset) {
+  vector<Image> images;
+  for (char label : dataset.GetDistinctLabels()) {
+    for (const Image& image : dataset.GetImageGroup(label)) {
+      images.push_back(image);
+    }
+  }
+
+  return images;
+}
+
+} // namespace
+
+TEST_CASE("Test Classify Server Batching") {
+  Model model;
+  ifstream model_input(kModelPath);
+  model_input >> model;
+
+  Dataset test_dataset;
+  ifstream test_input("/Users/neilkaushikkar/Cinder/my-projects/"
+                      "naive-bayes-nkaush/data/testing_test_dataset_4x4.txt");
+  test_input >> test_dataset;
+  vector<Image> images = GatherImages(test_dataset);
+
+  SECTION("Test concurrent requests are scored as one batch") {
+    // The window is long enough that only a full batch ends it
+    ClassifyServer server(kModelPath, images.size(), 2000000, 0);
+    std::thread serving([&server]() { server.Serve(kSocketPath); });
+
+    vector<ClassifyResponse> responses = ClassifyConcurrently(images);
+    server.Stop();
+    serving.join();
+
+    for (size_t index = 0; index < images.size(); index++) {
+      REQUIRE(responses[index].label_ == model.Classify(images[index]));
+      REQUIRE(responses[index].labels_ == model.GetLabels());
+    }
+
+    json stats = json::parse(server.GetStats());
+    REQUIRE(stats["requests_served"] == images.size());
+    REQUIRE(stats["batches_scored"] == 1);
+  }
+
+  SECTION("Test batches are no bigger than the max batch size") {
+    ClassifyServer server(kModelPath, images.size() / 2, 2000000, 0);
+    std::thread serving([&server]() { server.Serve(kSocketPath); });
+
+    ClassifyConcurrently(images);
+    server.Stop();
+    serving.join();
+
+    json stats = json::parse(server.GetStats());
+    REQUIRE(stats["requests_served"] == images.size());
+    REQUIRE(stats["batches_scored"] == 2);
+  }
+
+  SECTION("Test an image of another size ends its connection") {
+    ClassifyServer server(kModelPath, 1, 0, 0);
+    std::thread serving([&server]() { server.Serve(kSocketPath); });
+
+    ClassifyConnection connection(ConnectWhenListening());
+    ClassifyResponse response;
+    REQUIRE(connection.WriteRequest(Image({{Shading::kBlack}}, '0')));
+    REQUIRE_FALSE(connection.ReadResponse(response));
+
+    server.Stop();
+    serving.join();
+    REQUIRE(json::parse(server.GetStats())["requests_served"] == 0);
+  }
+}
+
+TEST_CASE("Test Classify Server Reloading") {
+  // Reloads read a copy of the model, so the test can break it
+  const string kReloadedModelPath = "/tmp/naive_bayes_test_reload_model.json";
+  {
+    ifstream model_input(kModelPath);
+    std::ofstream model_output(kReloadedModelPath);
+    model_output << model_input.rdbuf();
+  }
+
+  Model model;
+  ifstream model_input(kModelPath);
+  model_input >> model;
+
+  Dataset test_dataset;
+  ifstream test_input("/Users/neilkaushikkar/Cinder/my-projects/"
+                      "naive-bayes-nkaush/data/testing_test_dataset_4x4.txt");
+  test_input >> test_dataset;
+  vector<Image> images = GatherImages(test_dataset);
+
+  ClassifyServer server(kReloadedModelPath, images.size(), 0, 0);
+  REQUIRE(server.Reload());
+  std::thread serving([&server]() { server.Serve(kSocketPath); });
+
+  SECTION("Test reloading while batches hold the old version") {
+    // Each reload has to wait out any batch still scoring with the version
+    // it replaces, while every request is still answered correctly
+    const size_t kReloadCount = 20;
+    std::thread reloading([&server, kReloadCount]() {
+      for (size_t reload = 0; reload < kReloadCount; reload++) {
+        server.Reload();
+      }
+    });
+
+    for (size_t round = 0; round < 10; round++) {
+      vector<ClassifyResponse> responses = ClassifyConcurrently(images);
+      for (size_t index = 0; index < images.size(); index++) {
+        REQUIRE(responses[index].label_ == model.Classify(images[index]));
+      }
+    }
+    reloading.join();
+
+    json stats = json::parse(server.GetStats());
+    REQUIRE(stats["model_version"] == kReloadCount + 1);
+    REQUIRE(stats["failed_reloads"] == 0);
+  }
+
+  SECTION("Test a failed reload keeps the old model") {
+    std::ofstream(kReloadedModelPath) << "{\"not\": \"a model\"}";
+    REQUIRE_FALSE(server.Reload());
+
+    json stats = json::parse(server.GetStats());
+    REQUIRE(stats["model_version"] == 1);
+    REQUIRE(stats["failed_reloads"] == 1);
+
+    vector<ClassifyResponse> responses = ClassifyConcurrently(images);
+    for (size_t index = 0; index < images.size(); index++) {
+      REQUIRE(responses[index].label_ == model.Classify(images[index]));
+    }
+  }
+
+  SECTION("Test the reload and stats control requests") {
+    ClassifyConnection connection(ConnectWhenListening());
+    string text;
+
+    REQUIRE(connection.WriteControlRequest(RequestType::kStats));
+    REQUIRE(connection.ReadText(text));
+    REQUIRE(json::parse(text)["model_version"] == 1);
+
+    REQUIRE(connection.WriteControlRequest(RequestType::kReload));
+    REQUIRE(connection.ReadText(text));
+    REQUIRE(json::parse(text)["model_version"] == 2);
+
+    // The connection still classifies after control requests
+    ClassifyResponse response;
+    REQUIRE(connection.WriteRequest(images.at(0)));
+    REQUIRE(connection.ReadResponse(response));
+    REQUIRE(response.label_ == model.Classify(images.at(0)));
+  }
+
+  SECTION("Test a requested reload happens while serving") {
+    server.RequestReload();
+
+    // The reload thread checks for requests every 100ms
+    size_t version = 1;
+    for (size_t attempt = 0; attempt < kConnectAttempts && version == 1;
+         attempt++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      version = json::parse(server.GetStats())["model_version"];
+    }
+    REQUIRE(version == 2);
+  }
+
+  server.Stop();
+  serving.join();
+}
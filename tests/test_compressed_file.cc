@@ -0,0 +1,173 @@
+#include <catch2/catch.hpp>
+
+#include <core/compressed_file.h>
+#include <core/dataset.h>
+
+#include <fstream>
+#include <sstream>
+
+using naivebayes::CompressedFile;
+using naivebayes::Dataset;
+using std::ifstream;
+using std::string;
+using std::stringstream;
+
+// Need long verbose filepath since Cmake/Cinder can't locate local file path
+const string kDataDirectory = "/Users/neilkaushikkar/Cinder/my-projects/"
+                              "naive-bayes-nkaush/data/";
+
+TEST_CASE("Test Detecting Compressed Formats") {
+  SECTION("Test detecting gzip") {
+    stringstream input(string("\x1f\x8b\x08\x00", 4));
+
+    REQUIRE(CompressedFile::DetectFormat(input) ==
+            CompressedFile::Format::kGzip);
+    REQUIRE(input.get() == 0x1f);
+  }
+
+  SECTION("Test detecting zstd") {
+    stringstream input(string("\x28\xb5\x2f\xfd\x00", 5));
+
+    REQUIRE(CompressedFile::DetectFormat(input) ==
+            CompressedFile::Format::kZstd);
+  }
+
+  SECTION("Test a text dataset is not compressed") {
+    stringstream input("0\n#+ \n");
+
+    REQUIRE(CompressedFile::DetectFormat(input) ==
+            CompressedFile::Format::kNone);
+    REQUIRE(input.get() == '0');
+  }
+
+  SECTION("Test a stream shorter than any magic is not compressed") {
+    stringstream input("\x1f");
+
+    REQUIRE(CompressedFile::DetectFormat(input) ==
+            CompressedFile::Format::kNone);
+  }
+}
+
+TEST_CASE("Test Reading a Compressed File") {
+  string dataset_path = kDataDirectory + "testing_train_dataset_5x5.txt";
+
+  SECTION("Test the decompressed bytes match the original dataset") {
+    CompressedFile compressed_file;
+    REQUIRE(compressed_file.Open(dataset_path + ".gz"));
+
+    std::ostringstream decompressed_bytes;
+    decompressed_bytes << compressed_file.GetStream().rdbuf();
+    std::ostringstream file_bytes;
+    file_bytes << ifstream(dataset_path).rdbuf();
+
+    REQUIRE(decompressed_bytes.str() == file_bytes.str());
+  }
+
+  SECTION("Test a dataset can be extracted from the compressed file") {
+    CompressedFile compressed_file;
+    REQUIRE(compressed_file.Open(dataset_path + ".gz"));
+    Dataset compressed_dataset;
+    compressed_file.GetStream() >> compressed_dataset;
+
+    ifstream input(dataset_path);
+    Dataset dataset;
+    input >> dataset;
+
+    REQUIRE(compressed_dataset.GetSize() == dataset.GetSize());
+    REQUIRE(compressed_dataset.GetDistinctLabels() ==
+            dataset.GetDistinctLabels());
+  }
+
+  SECTION("Test an uncompressed file is not opened") {
+    CompressedFile compressed_file;
+
+    REQUIRE_FALSE(compressed_file.Open(dataset_path));
+    REQUIRE(compressed_file.GetStream().get() == EOF);
+  }
+
+  SECTION("Test reading a truncated file") {
+    CompressedFile compressed_file;
+    REQUIRE(compressed_file.Open(kDataDirectory +
+                                 "testing_truncated_dataset_5x5.txt.gz"));
+    Dataset dataset;
+
+    REQUIRE_THROWS_AS(compressed_file.GetStream() >> dataset,
+                      std::invalid_argument);
+  }
+
+  SECTION("Test closing a file before reading all of it") {
+    CompressedFile compressed_file;
+    REQUIRE(compressed_file.Open(dataset_path + ".gz"));
+    compressed_file.GetStream().get();
+
+    REQUIRE(compressed_file.Open(dataset_path + ".gz"));
+    REQUIRE(compressed_file.GetStream().get() ==
+            ifstream(dataset_path).get());
+  }
+}
+
+TEST_CASE("Test Reading a Compressed File Larger Than a Block") {
+  // The dataset is repeated 20000 times across two frames, so the second
+  // frame's last block decompresses across the end of a full block
+  const size_t kRepeatCount = 20000;
+  Dataset dataset;
+  ifstream input(kDataDirectory + "testing_train_dataset_5x5.txt");
+  input >> dataset;
+
+  SECTION("Test every block of a gzip file is read") {
+    CompressedFile compressed_file;
+    REQUIRE(compressed_file.Open(kDataDirectory +
+                                 "testing_repeated_dataset_5x5.txt.gz"));
+    Dataset repeated_dataset;
+    compressed_file.GetStream() >> repeated_dataset;
+
+    REQUIRE(repeated_dataset.GetSize() == dataset.GetSize() * kRepeatCount);
+  }
+
+#ifdef NAIVE_BAYES_HAS_ZSTD
+  SECTION("Test every block of a zstd frame without a checksum is read") {
+    CompressedFile compressed_file;
+    REQUIRE(compressed_file.Open(kDataDirectory +
+                                 "testing_repeated_dataset_5x5.txt.zst"));
+    Dataset repeated_dataset;
+    compressed_file.GetStream() >> repeated_dataset;
+
+    REQUIRE(repeated_dataset.GetSize() == dataset.GetSize() * kRepeatCount);
+  }
+#endif
+}
+
+TEST_CASE("Test Reading a Zstd Compressed File") {
+  string dataset_path = kDataDirectory + "testing_train_dataset_5x5.txt";
+
+#ifdef NAIVE_BAYES_HAS_ZSTD
+  SECTION("Test the decompressed bytes match the original dataset") {
+    CompressedFile compressed_file;
+    REQUIRE(compressed_file.Open(dataset_path + ".zst"));
+
+    std::ostringstream decompressed_bytes;
+    decompressed_bytes << compressed_file.GetStream().rdbuf();
+    std::ostringstream file_bytes;
+    file_bytes << ifstream(dataset_path).rdbuf();
+
+    REQUIRE(decompressed_bytes.str() == file_bytes.str());
+  }
+
+  SECTION("Test reading a truncated file") {
+    CompressedFile compressed_file;
+    REQUIRE(compressed_file.Open(kDataDirectory +
+                                 "testing_truncated_dataset_5x5.txt.zst"));
+    Dataset dataset;
+
+    REQUIRE_THROWS_AS(compressed_file.GetStream() >> dataset,
+                      std::invalid_argument);
+  }
+#else
+  SECTION("Test a build without zstd refuses to open a zstd file") {
+    CompressedFile compressed_file;
+
+    REQUIRE_THROWS_AS(compressed_file.Open(dataset_path + ".zst"),
+                      std::invalid_argument);
+  }
+#endif
+}
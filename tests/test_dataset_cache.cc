@@ -0,0 +1,87 @@
+#include <catch2/catch.hpp>
+
+#include <core/dataset_cache.h>
+#include <core/dataset.h>
+
+#include <fstream>
+#include <sstream>
+
+using naivebayes::DatasetCache;
+using naivebayes::MappedFile;
+using naivebayes::Dataset;
+using std::ifstream;
+using std::string;
+
+// Need long verbose filepath since Cmake/Cinder can't locate local file path
+const string kCachedDatasetPath = "/Users/neilkaushikkar/Cinder/my-projects/"
+    "naive-bayes-nkaush/data/testing_train_dataset_5x5.txt";
+
+TEST_CASE("Test Mapped File") {
+  SECTION("Test the mapped file reads the same bytes as the file") {
+    MappedFile mapped_file;
+    REQUIRE(mapped_file.Open(kCachedDatasetPath));
+
+    std::ostringstream mapped_bytes;
+    mapped_bytes << mapped_file.GetStream().rdbuf();
+    std::ostringstream file_bytes;
+    file_bytes << ifstream(kCachedDatasetPath).rdbuf();
+
+    REQUIRE(mapped_bytes.str() == file_bytes.str());
+    REQUIRE(mapped_file.GetSize() == file_bytes.str().size());
+  }
+
+  SECTION("Test a dataset can be extracted from the mapped file") {
+    MappedFile mapped_file;
+    REQUIRE(mapped_file.Open(kCachedDatasetPath));
+    Dataset mapped_dataset;
+    mapped_file.GetStream() >> mapped_dataset;
+
+    ifstream input(kCachedDatasetPath);
+    Dataset dataset;
+    input >> dataset;
+
+    REQUIRE(mapped_dataset.GetSize() == dataset.GetSize());
+    REQUIRE(mapped_dataset.GetDistinctLabels() == dataset.GetDistinctLabels());
+  }
+
+  SECTION("Test opening a missing file") {
+    MappedFile mapped_file;
+
+    REQUIRE_FALSE(mapped_file.Open(kCachedDatasetPath + ".missing"));
+    REQUIRE(mapped_file.GetSize() == 0);
+    REQUIRE(mapped_file.GetStream().get() == EOF);
+  }
+}
+
+TEST_CASE("Test Dataset Cache") {
+  DatasetCache cache("/tmp/naive-bayes-cache", 0);
+
+  SECTION("Test a disabled cache opens no snapshot") {
+    MappedFile snapshot;
+
+    REQUIRE_FALSE(DatasetCache().IsEnabled());
+    REQUIRE_FALSE(DatasetCache().Open(kCachedDatasetPath, snapshot));
+    REQUIRE(cache.IsEnabled());
+  }
+
+  SECTION("Test the snapshot path is the same on every run") {
+    string snapshot_path = cache.GetSnapshotPath(kCachedDatasetPath);
+
+    REQUIRE(snapshot_path == cache.GetSnapshotPath(kCachedDatasetPath));
+    REQUIRE(snapshot_path.find("/tmp/naive-bayes-cache/") == 0);
+    REQUIRE(snapshot_path.substr(snapshot_path.size() - 4) ==
+            DatasetCache::kSnapshotExtension);
+  }
+
+  SECTION("Test different datasets have different snapshots") {
+    string other_path = kCachedDatasetPath;
+    other_path.replace(other_path.find("5x5"), 3, "4x4");
+
+    REQUIRE(cache.GetSnapshotPath(kCachedDatasetPath) !=
+            cache.GetSnapshotPath(other_path));
+  }
+
+  SECTION("Test a missing dataset has no snapshot") {
+    REQUIRE(cache.GetSnapshotPath(kCachedDatasetPath + ".missing").empty());
+  }
+}
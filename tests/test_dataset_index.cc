@@ -0,0 +1,142 @@
+#include <catch2/catch.hpp>
+
+#include <core/dataset_index.h>
+
+#include <fstream>
+#include <sstream>
+
+using naivebayes::DatasetIndex;
+using naivebayes::Dataset;
+using naivebayes::Image;
+using std::stringstream;
+using std::ifstream;
+using std::string;
+using std::vector;
+
+TEST_CASE("Test Dataset Index") {
+  string image_text =
+      "0\n"
+      "#+ \n"
+      "# #\n"
+      "1\n"
+      " # \n"
+      " #+\n"
+      "0\n"
+      "###\n"
+      "   \n";
+  stringstream input(image_text);
+  DatasetIndex index = DatasetIndex::Build(input);
+
+  SECTION("Test the index records every image and label") {
+    REQUIRE(index.GetImageCount() == 3);
+    REQUIRE(index.GetLabel(0) == '0');
+    REQUIRE(index.GetLabel(1) == '1');
+    REQUIRE(index.GetLabel(2) == '0');
+  }
+
+  SECTION("Test reading an image out of order") {
+    stringstream dataset_input(image_text);
+    Image image = index.ReadImage(dataset_input, 2);
+    Image first_image = index.ReadImage(dataset_input, 0);
+
+    REQUIRE(image.GetLabel() == '0');
+    REQUIRE(image.GetPixel(0, 2) == naivebayes::Shading::kBlack);
+    REQUIRE(image.GetPixel(1, 0) == naivebayes::Shading::kWhite);
+    REQUIRE(first_image.GetPixel(0, 1) == naivebayes::Shading::kGray);
+  }
+
+  SECTION("Test the index survives serialization") {
+    stringstream saved;
+    saved << index;
+    DatasetIndex loaded_index;
+
+    REQUIRE(saved >> loaded_index);
+    REQUIRE(loaded_index.GetImageCount() == 3);
+    REQUIRE(loaded_index.GetLabel(1) == '1');
+
+    stringstream dataset_input(image_text);
+    REQUIRE(loaded_index.ReadImage(dataset_input, 1).Pack() ==
+            index.ReadImage(dataset_input, 1).Pack());
+  }
+
+  SECTION("Test a truncated index fails to load") {
+    stringstream saved;
+    saved << index;
+    string bytes = saved.str();
+    stringstream truncated(bytes.substr(0, bytes.size() - 3));
+    DatasetIndex loaded_index;
+
+    REQUIRE_FALSE(truncated >> loaded_index);
+    REQUIRE(loaded_index.GetImageCount() == 0);
+  }
+
+  SECTION("Test indexing an image that ends early") {
+    stringstream truncated_input("0\n#+ \n# #\n1\n # \n");
+
+    REQUIRE_THROWS_AS(DatasetIndex::Build(truncated_input),
+                      std::invalid_argument);
+  }
+
+  SECTION("Test indexing an empty dataset") {
+    stringstream empty_input("");
+
+    REQUIRE_THROWS_AS(DatasetIndex::Build(empty_input), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Test Reading an Indexed Dataset in Parallel") {
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  string file_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+                     "naive-bayes-nkaush/data/testing_train_dataset_5x5.txt";
+  ifstream index_input(file_path);
+  DatasetIndex index = DatasetIndex::Build(index_input);
+
+  ifstream dataset_input(file_path);
+  Dataset expected_dataset;
+  dataset_input >> expected_dataset;
+
+  SECTION("Test every thread count reads the same groups in file order") {
+    for (size_t thread_count = 1; thread_count <= 8; thread_count++) {
+      Dataset dataset;
+      REQUIRE(index.ReadDataset(file_path, thread_count, dataset));
+      REQUIRE(dataset.GetSize() == expected_dataset.GetSize());
+      REQUIRE(dataset.GetDistinctLabels() ==
+              expected_dataset.GetDistinctLabels());
+
+      for (char label : expected_dataset.GetDistinctLabels()) {
+        const auto& images = dataset.GetImageGroup(label);
+        const auto& expected_images = expected_dataset.GetImageGroup(label);
+        REQUIRE(images.size() == expected_images.size());
+
+        for (size_t image = 0; image < images.size(); image++) {
+          REQUIRE(images[image].Pack() == expected_images[image].Pack());
+        }
+      }
+    }
+  }
+
+  SECTION("Test reading a range keeps the images in file order") {
+    vector<Image> images;
+    index.ReadImages(file_path, 1, 4, 2, images);
+    REQUIRE(images.size() == 3);
+
+    ifstream image_input(file_path);
+    for (size_t image = 0; image < images.size(); image++) {
+      REQUIRE(images[image].Pack() ==
+              index.ReadImage(image_input, image + 1).Pack());
+    }
+  }
+
+  SECTION("Test reading a range past the last image") {
+    vector<Image> images;
+    index.ReadImages(file_path, 3, 100, 4, images);
+
+    REQUIRE(images.size() == index.GetImageCount() - 3);
+  }
+
+  SECTION("Test reading an empty index") {
+    Dataset dataset;
+
+    REQUIRE_FALSE(DatasetIndex().ReadDataset(file_path, 2, dataset));
+  }
+}
@@ -0,0 +1,123 @@
+#include <catch2/catch.hpp>
+
+#include <core/model.h>
+
+#include <fstream>
+#include <sstream>
+
+using naivebayes::DeduplicatedDataset;
+using naivebayes::TrainingCounts;
+using naivebayes::Dataset;
+using naivebayes::Shading;
+using naivebayes::Model;
+using naivebayes::Image;
+using std::stringstream;
+using std::ifstream;
+using std::vector;
+
+TEST_CASE("Test Deduplicated Dataset") {
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  std::string file_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+      "naive-bayes-nkaush/data/testing_train_dataset_4x4.txt";
+  ifstream input(file_path);
+  Dataset dataset;
+  input >> dataset;
+
+  // Add every image of the dataset three times
+  DeduplicatedDataset distinct_images;
+  Dataset duplicated_dataset;
+  for (size_t copy = 0; copy < 3; copy++) {
+    for (char label : dataset.GetDistinctLabels()) {
+      for (const Image& image : dataset.GetImageGroup(label)) {
+        distinct_images.AddImage(image);
+        duplicated_dataset.AddImage(image);
+      }
+    }
+  }
+
+  SECTION("Test duplicates collapse into one entry each") {
+    REQUIRE(distinct_images.GetImageCount() == 27);
+    REQUIRE(distinct_images.GetEntryCount() == 9);
+    REQUIRE(distinct_images.GetDedupRatio() == Approx(3));
+
+    for (size_t entry = 0; entry < 9; entry++) {
+      REQUIRE(distinct_images.GetMultiplicity(entry) == 3);
+    }
+  }
+
+  SECTION("Test entries unpack to the images that were added") {
+    Image first = dataset.GetImageGroup('0').at(0);
+    Image entry = distinct_images.GetImage(0);
+
+    REQUIRE(entry.GetLabel() == first.GetLabel());
+    REQUIRE(entry.Pack() == first.Pack());
+  }
+
+  SECTION("Test adding reports whether an image is new") {
+    DeduplicatedDataset images;
+    Image zero = dataset.GetImageGroup('0').at(0);
+
+    REQUIRE(images.AddImage(zero));
+    REQUIRE_FALSE(images.AddImage(zero));
+    REQUIRE(images.GetEntryCount() == 1);
+  }
+
+  SECTION("Test equal pixels with different labels stay distinct") {
+    DeduplicatedDataset images;
+    Image zero = dataset.GetImageGroup('0').at(0);
+    Image relabeled = Image::Unpack(zero.Pack().data(), zero.GetHeight(),
+                                    zero.GetWidth(), '1');
+
+    images.AddImage(zero);
+    REQUIRE(images.AddImage(relabeled));
+    REQUIRE(images.GetEntryCount() == 2);
+  }
+
+  SECTION("Test an empty dataset has a dedup ratio of 1") {
+    DeduplicatedDataset images;
+
+    REQUIRE(images.GetDedupRatio() == Approx(1));
+  }
+
+  SECTION("Test adding differently sized images") {
+    DeduplicatedDataset images;
+    vector<vector<Shading>> pixels(5, vector<Shading>(5, Shading::kWhite));
+    images.AddImage(dataset.GetImageGroup('0').at(0));
+
+    REQUIRE_THROWS_AS(images.AddImage(Image(pixels, '0')),
+                      std::invalid_argument);
+  }
+
+  SECTION("Test weighted entries train the same model as every duplicate") {
+    Model duplicated_model;
+    Model deduplicated_model;
+    duplicated_model.Train(duplicated_dataset);
+    deduplicated_model.Train(distinct_images);
+
+    stringstream duplicated_serialized;
+    stringstream deduplicated_serialized;
+    duplicated_serialized << duplicated_model;
+    deduplicated_serialized << deduplicated_model;
+
+    REQUIRE(duplicated_serialized.str() == deduplicated_serialized.str());
+  }
+
+  SECTION("Test counting an image with a multiplicity") {
+    Image zero = dataset.GetImageGroup('0').at(0);
+    TrainingCounts weighted_counts;
+    TrainingCounts repeated_counts;
+    weighted_counts.AddImage(zero, 4);
+    for (size_t copy = 0; copy < 4; copy++) {
+      repeated_counts.AddImage(zero);
+    }
+
+    stringstream weighted_serialized;
+    stringstream repeated_serialized;
+    weighted_serialized << weighted_counts;
+    repeated_serialized << repeated_counts;
+
+    REQUIRE(weighted_counts.GetImageCount() == 4);
+    REQUIRE(weighted_counts.GetClassCount('0') == 4);
+    REQUIRE(weighted_serialized.str() == repeated_serialized.str());
+  }
+}
@@ -0,0 +1,212 @@
+#include <catch2/catch.hpp>
+
+#include <core/executable_logic.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using naivebayes::ExecutableLogic;
+using naivebayes::ExecutionFlags;
+using std::string;
+
+TEST_CASE("Test Classifying Images With The Command Line Logic") {
+  ExecutableLogic logic(1);
+  ExecutionFlags flags;
+
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  flags.load_ = "/Users/neilkaushikkar/Cinder/my-projects/"
+                "naive-bayes-nkaush/data/testing_model.json";
+
+  SECTION("Test images of another size than the model fail cleanly") {
+    // The model is for 4x4 images, so none of these can be classified
+    flags.classify_ = "/Users/neilkaushikkar/Cinder/my-projects/"
+                      "naive-bayes-nkaush/data/testing_test_dataset_5x5.txt";
+
+    REQUIRE(logic.Execute(flags) == EXIT_FAILURE);
+  }
+
+  SECTION("Test a missing file of images fails cleanly") {
+    flags.classify_ = "/Users/neilkaushikkar/Cinder/my-projects/"
+                      "naive-bayes-nkaush/data/missing_dataset.txt";
+
+    REQUIRE(logic.Execute(flags) == EXIT_FAILURE);
+  }
+
+  SECTION("Test an empty file of images classifies no images") {
+    flags.classify_ = "/Users/neilkaushikkar/Cinder/my-projects/"
+                      "naive-bayes-nkaush/data/testing_empty_dataset.txt";
+
+    REQUIRE(logic.Execute(flags) == EXIT_SUCCESS);
+  }
+
+  SECTION("Test an image with an invalid pixel fails cleanly") {
+    flags.classify_ = "/Users/neilkaushikkar/Cinder/my-projects/"
+                      "naive-bayes-nkaush/data/"
+                      "testing_malformed_dataset_4x4.txt";
+
+    REQUIRE(logic.Execute(flags) == EXIT_FAILURE);
+  }
+}
+
+TEST_CASE("Test Cross Validating With The Command Line Logic") {
+  ExecutableLogic logic(1);
+  ExecutionFlags flags;
+
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  flags.train_ = "/Users/neilkaushikkar/Cinder/my-projects/"
+                 "naive-bayes-nkaush/data/testing_train_dataset_5x5.txt";
+  flags.test_ = "/Users/neilkaushikkar/Cinder/my-projects/"
+                "naive-bayes-nkaush/data/testing_test_dataset_5x5.txt";
+  flags.fold_count_ = 2;
+
+  SECTION("Test the folds and the test dataset save their own matrices") {
+    flags.fold_confusion_ = "/tmp/naive_bayes_test_fold_confusion.csv";
+    flags.confusion_ = "/tmp/naive_bayes_test_confusion.csv";
+    std::remove(flags.fold_confusion_.c_str());
+    std::remove(flags.confusion_.c_str());
+
+    REQUIRE(logic.Execute(flags) == EXIT_SUCCESS);
+    REQUIRE(std::ifstream(flags.fold_confusion_).good());
+    REQUIRE(std::ifstream(flags.confusion_).good());
+  }
+
+  SECTION("Test more folds than images fails cleanly") {
+    flags.fold_count_ = 50;
+
+    REQUIRE(logic.Execute(flags) == EXIT_FAILURE);
+  }
+
+  SECTION("Test too few weights for the images fails cleanly") {
+    flags.weights_ = "/Users/neilkaushikkar/Cinder/my-projects/"
+                     "naive-bayes-nkaush/data/testing_short_weights.txt";
+
+    REQUIRE(logic.Execute(flags) == EXIT_FAILURE);
+  }
+}
+
+TEST_CASE("Test Training With The Command Line Logic") {
+  ExecutableLogic logic(1);
+  ExecutionFlags flags;
+
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  flags.train_ = "/Users/neilkaushikkar/Cinder/my-projects/"
+                 "naive-bayes-nkaush/data/testing_train_dataset_4x4.txt";
+
+  SECTION("Test the model trains without a weights file") {
+    REQUIRE(logic.Execute(flags) == EXIT_SUCCESS);
+  }
+
+  SECTION("Test too few weights for the images fails cleanly") {
+    flags.weights_ = "/Users/neilkaushikkar/Cinder/my-projects/"
+                     "naive-bayes-nkaush/data/testing_short_weights.txt";
+
+    REQUIRE(logic.Execute(flags) == EXIT_FAILURE);
+  }
+}
+
+TEST_CASE("Test Sampling With The Command Line Logic") {
+  ExecutableLogic logic(1);
+  ExecutionFlags flags;
+
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  flags.train_ = "/Users/neilkaushikkar/Cinder/my-projects/"
+                 "naive-bayes-nkaush/data/testing_train_dataset_4x4.txt";
+
+  SECTION("Test quotas of every label sample the training images") {
+    flags.sample_quotas_ = "0:2,1:2";
+
+    REQUIRE(logic.Execute(flags) == EXIT_SUCCESS);
+  }
+
+  SECTION("Test a quota too large for a size_t fails cleanly") {
+    flags.sample_quotas_ = "99999999999999999999999";
+
+    REQUIRE(logic.Execute(flags) == EXIT_FAILURE);
+  }
+
+  SECTION("Test a quota that isn't a count fails cleanly") {
+    flags.sample_quotas_ = "0:two";
+
+    REQUIRE(logic.Execute(flags) == EXIT_FAILURE);
+  }
+}
+
+TEST_CASE("Test Training On An Indexed Dataset") {
+  ExecutionFlags flags;
+
+  // The index is saved next to the dataset, so train on a copy of it
+  string dataset_path = "/tmp/naive_bayes_test_indexed_4x4.txt";
+  std::ifstream dataset_file("/Users/neilkaushikkar/Cinder/my-projects/"
+                             "naive-bayes-nkaush/data/"
+                             "testing_train_dataset_4x4.txt");
+  std::ofstream(dataset_path) << dataset_file.rdbuf();
+  std::remove((dataset_path + ".idx").c_str());
+  flags.train_ = dataset_path;
+
+  SECTION("Test the indexed dataset trains the same model") {
+    flags.save_ = "/tmp/naive_bayes_test_streamed_model.json";
+    REQUIRE(ExecutableLogic(1).Execute(flags) == EXIT_SUCCESS);
+    flags.save_ = "/tmp/naive_bayes_test_indexed_model.json";
+    flags.is_indexing_datasets_ = true;
+    REQUIRE(ExecutableLogic(1).Execute(flags) == EXIT_SUCCESS);
+
+    std::stringstream streamed_model;
+    std::stringstream indexed_model;
+    streamed_model << std::ifstream(
+        "/tmp/naive_bayes_test_streamed_model.json").rdbuf();
+    indexed_model << std::ifstream(flags.save_).rdbuf();
+    REQUIRE(indexed_model.str() == streamed_model.str());
+  }
+
+  SECTION("Test the indexed dataset cross validates the same folds") {
+    flags.fold_count_ = 3;
+    flags.fold_confusion_ = "/tmp/naive_bayes_test_streamed_folds.csv";
+    REQUIRE(ExecutableLogic(1).Execute(flags) == EXIT_SUCCESS);
+    flags.fold_confusion_ = "/tmp/naive_bayes_test_indexed_folds.csv";
+    flags.is_indexing_datasets_ = true;
+    REQUIRE(ExecutableLogic(1).Execute(flags) == EXIT_SUCCESS);
+
+    std::stringstream streamed_folds;
+    std::stringstream indexed_folds;
+    streamed_folds << std::ifstream(
+        "/tmp/naive_bayes_test_streamed_folds.csv").rdbuf();
+    indexed_folds << std::ifstream(flags.fold_confusion_).rdbuf();
+    REQUIRE(indexed_folds.str() == streamed_folds.str());
+  }
+}
+
+TEST_CASE("Test Merging Checkpoints With The Command Line Logic") {
+  ExecutableLogic logic(1);
+  ExecutionFlags flags;
+
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  string data_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+                     "naive-bayes-nkaush/data/";
+  string small_checkpoint = "/tmp/naive_bayes_test_counts_4x4.json";
+  string large_checkpoint = "/tmp/naive_bayes_test_counts_5x5.json";
+
+  flags.train_ = data_path + "testing_train_dataset_4x4.txt";
+  flags.save_counts_ = small_checkpoint;
+  REQUIRE(ExecutableLogic(1).Execute(flags) == EXIT_SUCCESS);
+  flags.train_ = data_path + "testing_train_dataset_5x5.txt";
+  flags.save_counts_ = large_checkpoint;
+  REQUIRE(ExecutableLogic(1).Execute(flags) == EXIT_SUCCESS);
+
+  SECTION("Test checkpoints of the same size merge") {
+    REQUIRE(logic.Merge({small_checkpoint, small_checkpoint}, "", "") ==
+            EXIT_SUCCESS);
+  }
+
+  SECTION("Test a corrupt checkpoint fails cleanly") {
+    REQUIRE(logic.Merge({small_checkpoint,
+                         data_path + "testing_corrupt_checkpoint.json"},
+                        "", "") == EXIT_FAILURE);
+  }
+
+  SECTION("Test checkpoints of different sizes fail cleanly") {
+    REQUIRE(logic.Merge({small_checkpoint, large_checkpoint}, "", "") ==
+            EXIT_FAILURE);
+  }
+}
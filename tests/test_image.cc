@@ -131,3 +131,47 @@ TEST_CASE("Test Image Extraction Operator on 6x6 Image") {
     }
   }
 }
+
+TEST_CASE("Test Image Packing") {
+  string image_text = "0\n"
+                      " +# \n"
+                      "#  +\n"
+                      "  ##";
+  stringstream pixel_data(image_text);
+
+  Image image;
+  pixel_data >> image;
+
+  SECTION("Test packed size rounds up to whole bytes") {
+    REQUIRE(Image::GetPackedSize(3, 4) == 3);
+    REQUIRE(Image::GetPackedSize(3, 3) == 3);
+    REQUIRE(Image::GetPackedSize(1, 1) == 1);
+  }
+
+  SECTION("Test packing stores four pixels per byte") {
+    vector<uint8_t> packed = image.Pack();
+    REQUIRE(packed.size() == 3);
+    // White, gray, black, white from the lowest bits up
+    REQUIRE(packed.at(0) == 0x18);
+  }
+
+  SECTION("Test unpacking a packed image restores every pixel") {
+    vector<uint8_t> packed = image.Pack();
+    Image unpacked = Image::Unpack(packed.data(), 3, 4, '0');
+
+    REQUIRE(unpacked.GetLabel() == '0');
+    REQUIRE(unpacked.GetHeight() == 3);
+    REQUIRE(unpacked.GetWidth() == 4);
+    for (size_t row = 0; row < 3; row++) {
+      for (size_t col = 0; col < 4; col++) {
+        REQUIRE(unpacked.GetPixel(row, col) == image.GetPixel(row, col));
+      }
+    }
+  }
+
+  SECTION("Test unpacking an unknown shading encoding") {
+    vector<uint8_t> packed = {0xFF, 0xFF, 0xFF};
+    REQUIRE_THROWS_AS(Image::Unpack(packed.data(), 3, 4, '0'),
+                      std::invalid_argument);
+  }
+}
@@ -0,0 +1,145 @@
+#include <catch2/catch.hpp>
+
+#include <core/image_sampler.h>
+
+#include <algorithm>
+#include <sstream>
+
+using naivebayes::ImageSampler;
+using naivebayes::ImageStream;
+using naivebayes::Shading;
+using naivebayes::Image;
+using std::stringstream;
+using std::vector;
+using std::map;
+
+namespace {
+
+/**
+ * Offers images with labels cycling through 0 to label_count - 1, with each
+ * weight set to the index of the image so the sample can be told apart.
+ */
+vector<double> SampleIndices(ImageSampler& sampler, size_t image_count,
+                             size_t label_count) {
+  for (size_t index = 0; index < image_count; index++) {
+    char label = static_cast<char>('0' + index % label_count);
+    sampler.Offer(Image({{Shading::kBlack}}, label),
+                  static_cast<double>(index));
+  }
+
+  vector<Image> images;
+  vector<double> indices;
+  sampler.TakeSample(images, indices);
+  return indices;
+}
+
+} // namespace
+
+TEST_CASE("Test Image Sampler") {
+  SECTION("Test a default sampler keeps every image") {
+    ImageSampler sampler;
+    vector<double> indices = SampleIndices(sampler, 5, 2);
+
+    REQUIRE(sampler.IsKeepingEveryImage());
+    REQUIRE(indices == vector<double>({0, 1, 2, 3, 4}));
+  }
+
+  SECTION("Test a reservoir keeps its size in file order") {
+    ImageSampler sampler = ImageSampler::Reservoir(10, 7);
+    vector<double> indices = SampleIndices(sampler, 1000, 2);
+
+    REQUIRE_FALSE(sampler.IsKeepingEveryImage());
+    REQUIRE(sampler.GetOfferedCount() == 1000);
+    REQUIRE(indices.size() == 10);
+    REQUIRE(std::is_sorted(indices.begin(), indices.end()));
+  }
+
+  SECTION("Test a reservoir keeps every image if too few are offered") {
+    ImageSampler sampler = ImageSampler::Reservoir(10, 7);
+
+    REQUIRE(SampleIndices(sampler, 4, 2).size() == 4);
+  }
+
+  SECTION("Test the same seed draws the same sample") {
+    ImageSampler first_sampler = ImageSampler::Reservoir(10, 7);
+    ImageSampler second_sampler = ImageSampler::Reservoir(10, 7);
+    ImageSampler other_sampler = ImageSampler::Reservoir(10, 8);
+
+    vector<double> first_indices = SampleIndices(first_sampler, 1000, 2);
+    REQUIRE(SampleIndices(second_sampler, 1000, 2) == first_indices);
+    REQUIRE(SampleIndices(other_sampler, 1000, 2) != first_indices);
+  }
+
+  SECTION("Test a reservoir samples every image about equally") {
+    // Each of 20 images should be kept in about half of the samples
+    vector<size_t> kept_counts(20, 0);
+    for (uint64_t seed = 0; seed < 2000; seed++) {
+      ImageSampler sampler = ImageSampler::Reservoir(10, seed);
+      for (double index : SampleIndices(sampler, 20, 2)) {
+        kept_counts.at(static_cast<size_t>(index))++;
+      }
+    }
+
+    for (size_t kept_count : kept_counts) {
+      REQUIRE(kept_count > 850);
+      REQUIRE(kept_count < 1150);
+    }
+  }
+
+  SECTION("Test stratified quotas sample each label") {
+    ImageSampler sampler =
+        ImageSampler::Stratified(map<char, size_t>{{'0', 5}, {'1', 2}}, 3, 7);
+    vector<double> indices = SampleIndices(sampler, 300, 3);
+
+    map<char, size_t> label_counts;
+    for (double index : indices) {
+      label_counts['0' + static_cast<size_t>(index) % 3]++;
+    }
+
+    REQUIRE(label_counts['0'] == 5);
+    REQUIRE(label_counts['1'] == 2);
+    REQUIRE(label_counts['2'] == 3);
+    REQUIRE(std::is_sorted(indices.begin(), indices.end()));
+  }
+
+  SECTION("Test a fraction keeps about that share of the images") {
+    ImageSampler sampler = ImageSampler::Fraction(0.25, 7);
+    size_t sample_size = SampleIndices(sampler, 4000, 2).size();
+
+    REQUIRE(sample_size > 900);
+    REQUIRE(sample_size < 1100);
+  }
+
+  SECTION("Test a fraction sample can be taken a chunk at a time") {
+    ImageSampler sampler = ImageSampler::Fraction(0.25, 7);
+    ImageSampler whole_sampler = ImageSampler::Fraction(0.25, 7);
+    vector<double> indices = SampleIndices(sampler, 100, 2);
+    // The weights of the second chunk count from 0 again
+    for (double index : SampleIndices(sampler, 100, 2)) {
+      indices.push_back(index + 100);
+    }
+
+    REQUIRE(sampler.IsDecidingOnOffer());
+    REQUIRE_FALSE(ImageSampler::Reservoir(10, 7).IsDecidingOnOffer());
+    REQUIRE(sampler.GetSampledCount() == indices.size());
+    REQUIRE(SampleIndices(whole_sampler, 200, 2) == indices);
+  }
+
+  SECTION("Test an invalid fraction") {
+    REQUIRE_THROWS_AS(ImageSampler::Fraction(1.5, 7), std::invalid_argument);
+  }
+
+  SECTION("Test sampling a stream") {
+    stringstream input("0\n#+\n #\n1\n  \n+ \n0\n##\n##\n");
+    ImageStream image_stream(input);
+    ImageSampler sampler = ImageSampler::Reservoir(2, 7);
+    sampler.OfferStream(image_stream);
+
+    vector<Image> images;
+    vector<double> weights;
+    REQUIRE(sampler.TakeSample(images, weights) == 2);
+    REQUIRE(sampler.GetOfferedCount() == 3);
+    REQUIRE(images.at(0).GetHeight() == 2);
+    REQUIRE(weights == vector<double>({1, 1}));
+  }
+}
@@ -0,0 +1,91 @@
+#include <catch2/catch.hpp>
+
+#include <core/image_stream.h>
+#include <core/model.h>
+
+#include <fstream>
+#include <sstream>
+
+using naivebayes::TrainingCounts;
+using naivebayes::ImageStream;
+using naivebayes::Dataset;
+using naivebayes::Shading;
+using naivebayes::Model;
+using naivebayes::Image;
+using std::stringstream;
+using std::ifstream;
+using std::vector;
+using std::string;
+
+TEST_CASE("Test Reading Images in Chunks") {
+  string image_text =
+      "0\n"
+      "## \n"
+      "# #\n"
+      "1\n"
+      " # \n"
+      " # \n"
+      "1\n"
+      "#  \n"
+      "#  \n";
+  stringstream input(image_text);
+  ImageStream image_stream(input);
+  vector<Image> chunk;
+
+  SECTION("Test chunks hold at most the requested number of images") {
+    REQUIRE(image_stream.ReadChunk(chunk, 2) == 2);
+    REQUIRE(chunk.at(0).GetLabel() == '0');
+    REQUIRE(chunk.at(1).GetLabel() == '1');
+
+    REQUIRE(image_stream.ReadChunk(chunk, 2) == 1);
+    REQUIRE(chunk.at(0).GetPixel(1, 0) == Shading::kBlack);
+    REQUIRE(chunk.at(0).GetPixel(1, 1) == Shading::kWhite);
+
+    REQUIRE(image_stream.ReadChunk(chunk, 2) == 0);
+  }
+
+  SECTION("Test stream infers the image dimension from the first image") {
+    image_stream.ReadChunk(chunk, 1);
+
+    REQUIRE(image_stream.GetHeight() == 2);
+    REQUIRE(image_stream.GetWidth() == 3);
+  }
+}
+
+TEST_CASE("Test Training From Counts Matches Training From a Dataset") {
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  std::string file_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+      "naive-bayes-nkaush/data/testing_train_dataset_5x5.txt";
+
+  Dataset dataset;
+  ifstream dataset_input(file_path);
+  dataset_input >> dataset;
+  Model dataset_model;
+  dataset_model.Train(dataset);
+
+  ifstream stream_input(file_path);
+  ImageStream image_stream(stream_input);
+  TrainingCounts counts;
+  vector<Image> chunk;
+  while (image_stream.ReadChunk(chunk, 2) > 0) {
+    for (const Image& image : chunk) {
+      counts.AddImage(image);
+    }
+  }
+  Model counts_model;
+  counts_model.Train(counts);
+
+  SECTION("Test counts record every image") {
+    REQUIRE(counts.GetImageCount() == dataset.GetSize());
+    REQUIRE(counts.GetDistinctLabels() == dataset.GetDistinctLabels());
+  }
+
+  SECTION("Test both models serialize identically") {
+    stringstream dataset_serialized;
+    stringstream counts_serialized;
+    dataset_serialized << dataset_model;
+    counts_serialized << counts_model;
+
+    REQUIRE(dataset_serialized.str() == counts_serialized.str());
+  }
+}
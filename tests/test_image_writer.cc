@@ -0,0 +1,130 @@
+#include <catch2/catch.hpp>
+
+#include <core/image_stream.h>
+#include <core/image_writer.h>
+
+#include <sstream>
+
+using naivebayes::ImageWriter;
+using naivebayes::Shading;
+using naivebayes::ImageStream;
+using naivebayes::Image;
+using std::stringstream;
+using std::vector;
+using std::string;
+
+TEST_CASE("Test Writing Images in Each Dataset Format") {
+  string image_text =
+      "0\n"
+      "#+ \n"
+      "# #\n"
+      "1\n"
+      " # \n"
+      " #+\n";
+  stringstream text_input(image_text);
+  ImageStream text_stream(text_input);
+
+  vector<Image> images;
+  text_stream.ReadChunk(images, 2);
+
+  SECTION("Test text output matches the dataset text format") {
+    stringstream output;
+    ImageWriter writer(output, ImageWriter::Format::kText);
+    for (const Image& image : images) {
+      writer.Write(image);
+    }
+
+    REQUIRE(output.str() == image_text);
+  }
+
+  SECTION("Test binary output starts with the magic and image size") {
+    stringstream output;
+    ImageWriter writer(output, ImageWriter::Format::kBinary);
+    writer.Write(images.at(0));
+
+    string bytes = output.str();
+    REQUIRE(bytes.substr(0, 4) == ImageStream::kBinaryMagic);
+    REQUIRE(bytes.substr(4, 4) == string("\x02\x00\x03\x00", 4));
+    // One label byte and two bytes of packed pixels
+    REQUIRE(bytes.size() == 8 + 1 + Image::GetPackedSize(2, 3));
+  }
+
+  SECTION("Test binary output reads back as the same images") {
+    stringstream output;
+    ImageWriter writer(output, ImageWriter::Format::kBinary);
+    for (const Image& image : images) {
+      writer.Write(image);
+    }
+
+    ImageStream binary_stream(output);
+    vector<Image> read_images;
+    REQUIRE(binary_stream.ReadChunk(read_images, 3) == 2);
+    REQUIRE(binary_stream.GetHeight() == 2);
+    REQUIRE(binary_stream.GetWidth() == 3);
+
+    for (size_t index = 0; index < images.size(); index++) {
+      REQUIRE(read_images.at(index).GetLabel() == images.at(index).GetLabel());
+      REQUIRE(read_images.at(index).Pack() == images.at(index).Pack());
+    }
+  }
+
+  SECTION("Test binary stream that ends within an image") {
+    stringstream output;
+    ImageWriter writer(output, ImageWriter::Format::kBinary);
+    writer.Write(images.at(0));
+
+    string bytes = output.str();
+    stringstream truncated(bytes.substr(0, bytes.size() - 1));
+    ImageStream binary_stream(truncated);
+
+    Image image;
+    REQUIRE_THROWS_AS(binary_stream.ReadImage(image), std::invalid_argument);
+  }
+
+  SECTION("Test weighted binary output reads back with the weights") {
+    stringstream output;
+    ImageWriter writer(output, ImageWriter::Format::kWeightedBinary);
+    writer.Write(images.at(0), 0.5);
+    writer.Write(images.at(1), 3);
+
+    string bytes = output.str();
+    REQUIRE(bytes.substr(0, 4) == ImageStream::kWeightedBinaryMagic);
+    // Each image has a label byte, a float32 weight and its packed pixels
+    REQUIRE(bytes.size() == 8 + 2 * (1 + 4 + Image::GetPackedSize(2, 3)));
+
+    ImageStream binary_stream(output);
+    vector<Image> read_images;
+    vector<double> weights;
+    REQUIRE(binary_stream.ReadChunk(read_images, weights, 3) == 2);
+    REQUIRE(weights == vector<double>({0.5, 3}));
+    REQUIRE(read_images.at(1).Pack() == images.at(1).Pack());
+  }
+
+  SECTION("Test unweighted images have a weight of 1") {
+    stringstream input(image_text);
+    ImageStream stream(input);
+    Image image;
+    double weight = 0;
+
+    REQUIRE(stream.ReadImage(image, weight));
+    REQUIRE(weight == 1);
+  }
+
+  SECTION("Test writing a weight in an unweighted format") {
+    stringstream output;
+    ImageWriter writer(output, ImageWriter::Format::kBinary);
+
+    REQUIRE_THROWS_AS(writer.Write(images.at(0), 2), std::invalid_argument);
+  }
+
+  SECTION("Test writing images of different sizes") {
+    vector<vector<Shading>> pixels(
+        1, vector<Shading>(1, Shading::kBlack));
+
+    stringstream output;
+    ImageWriter writer(output, ImageWriter::Format::kBinary);
+    writer.Write(images.at(0));
+
+    REQUIRE_THROWS_AS(writer.Write(Image(pixels, '1')), std::invalid_argument);
+  }
+}
@@ -0,0 +1,79 @@
+#include <catch2/catch.hpp>
+
+#include <core/live_classifier.h>
+
+#include <fstream>
+
+using naivebayes::LiveClassifier;
+using naivebayes::Dataset;
+using naivebayes::Shading;
+using naivebayes::Model;
+using naivebayes::Image;
+using std::ifstream;
+using std::vector;
+
+TEST_CASE("Test Live Classification Matches Full Rescoring") {
+  Model model = Model();
+
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  std::string file_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+                          "naive-bayes-nkaush/data/testing_model.json";
+  ifstream model_input(file_path);
+  model_input >> model;
+
+  Dataset testing_dataset;
+  std::string test_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+                          "naive-bayes-nkaush/data/testing_test_dataset_4x4.txt";
+  ifstream dataset_input(test_path);
+  dataset_input >> testing_dataset;
+
+  LiveClassifier live_classifier(model, 4, 4);
+  vector<char> labels = {'0', '1'};
+
+  SECTION("Test baseline scores are those of a blank image") {
+    Image blank(vector<vector<Shading>>(4, vector<Shading>(4, Shading::kWhite)),
+                Image::kDefaultLabel);
+
+    for (char label : labels) {
+      size_t label_idx = model.GetLabelIndices().at(label);
+      REQUIRE(Approx(model.CalculateLikelihoodScore(label, blank)) ==
+              live_classifier.GetScores().at(label_idx));
+    }
+  }
+
+  SECTION("Test shading pixels one at a time matches scoring the image") {
+    for (char label : labels) {
+      const Image& image = testing_dataset.GetImageGroup(label).at(0);
+      live_classifier.Reset();
+
+      for (size_t row = 0; row < image.GetHeight(); row++) {
+        for (size_t col = 0; col < image.GetWidth(); col++) {
+          live_classifier.UpdatePixel(row, col, Shading::kWhite,
+                                      image.GetPixel(row, col));
+        }
+      }
+
+      for (char score_label : labels) {
+        size_t label_idx = model.GetLabelIndices().at(score_label);
+        REQUIRE(Approx(model.CalculateLikelihoodScore(score_label, image))
+                    .epsilon(0.001) == live_classifier.GetScores().at(label_idx));
+      }
+      REQUIRE(live_classifier.GetPrediction() == model.Classify(image));
+    }
+  }
+
+  SECTION("Test reset restores the blank image baseline") {
+    vector<float> baseline = live_classifier.GetScores();
+    live_classifier.UpdatePixel(1, 1, Shading::kWhite, Shading::kBlack);
+    live_classifier.Reset();
+
+    REQUIRE(live_classifier.GetScores() == baseline);
+  }
+}
+
+TEST_CASE("Test Live Classification Without a Model") {
+  LiveClassifier live_classifier;
+  char default_label = Image::kDefaultLabel;
+
+  REQUIRE(live_classifier.GetPrediction() == default_label);
+}
@@ -0,0 +1,35 @@
+#include <catch2/catch.hpp>
+
+#include <core/load_generator.h>
+
+using naivebayes::LoadGenerator;
+using std::vector;
+
+TEST_CASE("Test Finding Latency Percentiles") {
+  vector<double> latencies = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+
+  SECTION("Test percentiles use the nearest rank") {
+    REQUIRE(LoadGenerator::FindPercentile(latencies, 50) == 5);
+    REQUIRE(LoadGenerator::FindPercentile(latencies, 90) == 9);
+    REQUIRE(LoadGenerator::FindPercentile(latencies, 91) == 10);
+    REQUIRE(LoadGenerator::FindPercentile(latencies, 99.9) == 10);
+  }
+
+  SECTION("Test a percentile between ranks rounds up") {
+    vector<double> three_latencies = {1, 2, 3};
+
+    REQUIRE(LoadGenerator::FindPercentile(three_latencies, 50) == 2);
+    REQUIRE(LoadGenerator::FindPercentile(three_latencies, 34) == 2);
+    REQUIRE(LoadGenerator::FindPercentile(three_latencies, 33) == 1);
+  }
+
+  SECTION("Test the extreme percentiles are the smallest and largest") {
+    REQUIRE(LoadGenerator::FindPercentile(latencies, 0) == 1);
+    REQUIRE(LoadGenerator::FindPercentile(latencies, 100) == 10);
+    REQUIRE(LoadGenerator::FindPercentile(vector<double>({7}), 50) == 7);
+  }
+
+  SECTION("Test no latencies") {
+    REQUIRE(LoadGenerator::FindPercentile(vector<double>(), 50) == 0);
+  }
+}
@@ -6,9 +6,12 @@
 
 #include <core/model.h>
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <sstream>
 
+using naivebayes::Prediction;
 using naivebayes::Dataset;
 using naivebayes::Image;
 using naivebayes::Model;
@@ -226,5 +229,204 @@ TEST_CASE("Test Model Testing") {
 
     REQUIRE(actual == expected);
     REQUIRE(Model::CalculateAccuracy(actual) == Approx(1));
+
+    stringstream progress_output;
+    REQUIRE(model.Test(testing_dataset, true, &progress_output) == expected);
+    REQUIRE(progress_output.str().find("Testing: 4 of 4 images") !=
+            string::npos);
+  }
+}
+
+TEST_CASE("Test Batch Likelihood Score Calculation") {
+  Model model = Model();
+
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  std::string file_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+                          "naive-bayes-nkaush/data/testing_model.json";
+  ifstream model_input(file_path);
+  model_input >> model;
+
+  Dataset testing_dataset;
+  std::string test_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+                          "naive-bayes-nkaush/data/testing_test_dataset_4x4.txt";
+  ifstream dataset_input(test_path);
+  dataset_input >> testing_dataset;
+
+  vector<Image> images = testing_dataset.GetImageGroup('0');
+  vector<Image> ones = testing_dataset.GetImageGroup('1');
+  images.insert(images.end(), ones.begin(), ones.end());
+
+  SECTION("Test model reports its labels and image size") {
+    REQUIRE(model.GetLabels() == vector<char>{'0', '1'});
+    REQUIRE(model.GetImageHeight() == 4);
+    REQUIRE(model.GetImageWidth() == 4);
+  }
+
+  SECTION("Test batch scores match scoring each image on its own") {
+    vector<vector<float>> scores = model.CalculateLikelihoodScores(images);
+    vector<char> labels = model.GetLabels();
+
+    REQUIRE(scores.size() == images.size());
+    for (size_t image_idx = 0; image_idx < images.size(); image_idx++) {
+      REQUIRE(scores.at(image_idx).size() == labels.size());
+
+      for (size_t label_idx = 0; label_idx < labels.size(); label_idx++) {
+        REQUIRE(Approx(model.CalculateLikelihoodScore(labels.at(label_idx),
+                                                      images.at(image_idx))) ==
+                scores.at(image_idx).at(label_idx));
+      }
+    }
+  }
+
+  SECTION("Test batch of no images") {
+    REQUIRE(model.CalculateLikelihoodScores(vector<Image>()).empty());
+  }
+}
+
+TEST_CASE("Test Top K Classification") {
+  Model model = Model();
+
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  std::string file_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+                          "naive-bayes-nkaush/data/testing_model.json";
+  ifstream model_input(file_path);
+  model_input >> model;
+
+  Dataset testing_dataset;
+  std::string test_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+                          "naive-bayes-nkaush/data/testing_test_dataset_4x4.txt";
+  ifstream dataset_input(test_path);
+  dataset_input >> testing_dataset;
+
+  Image image = testing_dataset.GetImageGroup('1').at(0);
+
+  SECTION("Test predictions are ordered from most to least likely") {
+    vector<Prediction> predictions = model.ClassifyTopK(image, 2);
+
+    REQUIRE(predictions.size() == 2);
+    REQUIRE(predictions.at(0).label_ == '1');
+    REQUIRE(predictions.at(1).label_ == '0');
+    REQUIRE(Approx(-4.8563).epsilon(0.01) == predictions.at(0).score_);
+    REQUIRE(Approx(-5.0598).epsilon(0.01) == predictions.at(1).score_);
+  }
+
+  SECTION("Test posteriors are normalized over every label") {
+    vector<Prediction> predictions = model.ClassifyTopK(image, 2);
+
+    REQUIRE(predictions.at(0).posterior_ + predictions.at(1).posterior_ ==
+            Approx(1));
+    // The posterior ratio is the ratio of the likelihoods
+    REQUIRE(predictions.at(0).posterior_ / predictions.at(1).posterior_ ==
+            Approx(std::pow(10.0f, predictions.at(0).score_ -
+                                   predictions.at(1).score_)));
+  }
+
+  SECTION("Test the top prediction matches Classify") {
+    for (char label : testing_dataset.GetDistinctLabels()) {
+      for (const Image& group_image : testing_dataset.GetImageGroup(label)) {
+        REQUIRE(model.ClassifyTopK(group_image, 1).at(0).label_ ==
+                model.Classify(group_image));
+      }
+    }
+  }
+
+  SECTION("Test k is capped by the number of labels") {
+    REQUIRE(model.ClassifyTopK(image, 5).size() == 2);
+    REQUIRE(model.ClassifyTopK(image, 0).empty());
+  }
+
+  SECTION("Test batch predictions match predicting each image on its own") {
+    vector<Image> images = testing_dataset.GetImageGroup('0');
+    vector<vector<Prediction>> predictions = model.ClassifyTopK(images, 2);
+
+    REQUIRE(predictions.size() == images.size());
+    for (size_t idx = 0; idx < images.size(); idx++) {
+      vector<Prediction> expected = model.ClassifyTopK(images.at(idx), 2);
+
+      for (size_t rank = 0; rank < expected.size(); rank++) {
+        REQUIRE(predictions.at(idx).at(rank).label_ == expected.at(rank).label_);
+        REQUIRE(predictions.at(idx).at(rank).posterior_ ==
+                Approx(expected.at(rank).posterior_));
+      }
+    }
+  }
+
+  SECTION("Test writing predictions while testing") {
+    stringstream predictions_output;
+    LongMatrix actual = model.Test(testing_dataset, 1, predictions_output);
+
+    REQUIRE(actual == model.Test(testing_dataset, false));
+
+    string header;
+    getline(predictions_output, header);
+    REQUIRE(header == "actual,label_1,score_1,posterior_1");
+
+    string line;
+    size_t line_count = 0;
+    while (getline(predictions_output, line)) {
+      line_count++;
+    }
+    REQUIRE(line_count == 4);
+  }
+}
+
+TEST_CASE("Test Model Pruning") {
+  Model model = Model();
+  Dataset train_dataset = Dataset();
+
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  std::string file_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+                          "naive-bayes-nkaush/data/testing_train_dataset_5x5.txt";
+  ifstream train_input(file_path);
+  train_input >> train_dataset;
+  model.Train(train_dataset);
+
+  Image image = train_dataset.GetImageGroup('0').at(0);
+
+  SECTION("Test an unpruned model retains every pixel") {
+    REQUIRE(model.GetRetainedPixels().size() == 25);
+  }
+
+  SECTION("Test pruning keeps the most discriminative pixels") {
+    vector<size_t> ranked_pixels = model.RankPixels();
+    model.Prune(5);
+
+    vector<size_t> expected(ranked_pixels.begin(), ranked_pixels.begin() + 5);
+    std::sort(expected.begin(), expected.end());
+    REQUIRE(model.GetRetainedPixels() == expected);
+  }
+
+  SECTION("Test a pruned model scores only the retained pixels") {
+    Model unpruned_model = model;
+    model.Prune(5);
+
+    float expected = unpruned_model.GetClassLikelihood('0');
+    for (size_t pixel : model.GetRetainedPixels()) {
+      expected += unpruned_model.GetFeatureLikelihood(
+          '0', image.GetPixel(pixel / 5, pixel % 5), pixel / 5, pixel % 5);
+    }
+
+    REQUIRE(model.CalculateLikelihoodScore('0', image) == Approx(expected));
+  }
+
+  SECTION("Test pruning every pixel leaves only the class likelihood") {
+    model.PruneBelow(1000);
+
+    REQUIRE(model.GetRetainedPixels().empty());
+    REQUIRE(model.CalculateLikelihoodScore('1', image) ==
+            Approx(model.GetClassLikelihood('1')));
+  }
+
+  SECTION("Test a saved pruned model is still pruned once loaded") {
+    model.Prune(5);
+
+    stringstream serialized;
+    serialized << model;
+    Model loaded_model;
+    serialized >> loaded_model;
+
+    REQUIRE(loaded_model.GetRetainedPixels() == model.GetRetainedPixels());
+    REQUIRE(loaded_model.CalculateLikelihoodScore('0', image) ==
+            Approx(model.CalculateLikelihoodScore('0', image)));
   }
 }
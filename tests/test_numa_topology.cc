@@ -0,0 +1,82 @@
+#include <catch2/catch.hpp>
+
+#include <core/numa_topology.h>
+#include <core/thread_pool.h>
+
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using naivebayes::NumaTopology;
+using naivebayes::ThreadPool;
+using std::pair;
+using std::vector;
+
+TEST_CASE("Test Parsing Cpu Lists") {
+  SECTION("Test single cores and ranges") {
+    vector<size_t> cores = NumaTopology::ParseCpuList("0-3,8,10-11");
+
+    REQUIRE(cores == vector<size_t>({0, 1, 2, 3, 8, 10, 11}));
+  }
+
+  SECTION("Test an empty list has no cores") {
+    REQUIRE(NumaTopology::ParseCpuList("").empty());
+  }
+
+  SECTION("Test malformed lists") {
+    REQUIRE_THROWS_AS(NumaTopology::ParseCpuList("0-3,,5"),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(NumaTopology::ParseCpuList("0-a"),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(NumaTopology::ParseCpuList("5-2"),
+                      std::invalid_argument);
+  }
+}
+
+TEST_CASE("Test Numa Topology") {
+  SECTION("Test a single node topology") {
+    NumaTopology topology(4);
+
+    REQUIRE(topology.GetNodeCount() == 1);
+    REQUIRE(topology.GetNodeCores(0) == vector<size_t>({0, 1, 2, 3}));
+  }
+
+  SECTION("Test interleaving cores of uneven nodes") {
+    NumaTopology topology(vector<vector<size_t>>({{0, 1, 2}, {4, 5}}));
+    vector<pair<size_t, size_t>> expected = {{0, 0}, {4, 1}, {1, 0},
+                                             {5, 1}, {2, 0}};
+
+    REQUIRE(topology.GetNodeCount() == 2);
+    REQUIRE(topology.InterleaveCores() == expected);
+  }
+
+  SECTION("Test the detected topology has every node with a core") {
+    NumaTopology topology = NumaTopology::Detect();
+
+    REQUIRE(topology.GetNodeCount() >= 1);
+    for (size_t node = 0; node < topology.GetNodeCount(); node++) {
+      REQUIRE_FALSE(topology.GetNodeCores(node).empty());
+    }
+  }
+}
+
+TEST_CASE("Test Pinned Thread Pool") {
+  ThreadPool pool(4);
+  pool.SetThreadCount(4, ThreadPool::Placement::kPinned);
+
+  SECTION("Test the pool is spread over every detected node") {
+    REQUIRE(pool.GetPlacement() == ThreadPool::Placement::kPinned);
+    REQUIRE(pool.GetNodeCount() == NumaTopology::Detect().GetNodeCount());
+  }
+
+  SECTION("Test every index is counted on some node") {
+    pool.ResetNodeIndexCounts();
+    pool.ParallelFor(0, 1000, 7, [](size_t, size_t) {});
+
+    size_t total = 0;
+    for (size_t count : pool.GetNodeIndexCounts()) {
+      total += count;
+    }
+    REQUIRE(total == 1000);
+  }
+}
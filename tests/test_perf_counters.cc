@@ -0,0 +1,44 @@
+#include <catch2/catch.hpp>
+
+#include <core/perf_counters.h>
+
+using naivebayes::PerfCounters;
+
+TEST_CASE("Test Perf Counters") {
+  SECTION("Test counters that were never opened count nothing") {
+    PerfCounters counters;
+    counters.Start();
+    PerfCounters::Reading reading = counters.Stop();
+
+    REQUIRE_FALSE(counters.IsOpen());
+    for (size_t event = 0; event < PerfCounters::kEventCount; event++) {
+      REQUIRE_FALSE(reading.is_counted_[event]);
+      REQUIRE(reading.counts_[event] == 0);
+    }
+  }
+
+  SECTION("Test opened counters count or explain why they can't") {
+    // Machines without perf_event_open, or that forbid it, can't count
+    PerfCounters counters;
+    if (!counters.Open()) {
+      REQUIRE_FALSE(counters.IsOpen());
+      REQUIRE_FALSE(counters.GetError().empty());
+      return;
+    }
+
+    counters.Start();
+    volatile size_t sum = 0;
+    for (size_t index = 0; index < 100000; index++) {
+      sum = sum + index;
+    }
+    PerfCounters::Reading reading = counters.Stop();
+
+    REQUIRE(counters.GetError().empty());
+    for (size_t event = 0; event < PerfCounters::kEventCount; event++) {
+      REQUIRE(reading.counts_[event] >= 0);
+    }
+    if (reading.is_counted_[PerfCounters::kInstructions]) {
+      REQUIRE(reading.counts_[PerfCounters::kInstructions] > 100000);
+    }
+  }
+}
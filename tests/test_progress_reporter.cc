@@ -0,0 +1,69 @@
+#include <catch2/catch.hpp>
+
+#include <core/progress_reporter.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using naivebayes::ProgressReporter;
+using std::string;
+
+TEST_CASE("Test Progress Reporter") {
+  std::stringstream output;
+
+  SECTION("Test counts added from many threads are all counted") {
+    ProgressReporter progress(output, "Testing", 4000);
+    std::vector<std::thread> threads;
+    for (size_t thread = 0; thread < 4; thread++) {
+      threads.emplace_back([&progress]() {
+        for (size_t image = 0; image < 1000; image++) {
+          progress.Add(1);
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+
+    REQUIRE(progress.GetCount() == 4000);
+  }
+
+  SECTION("Test progress is printed once when stopped early") {
+    ProgressReporter progress(output, "Testing", 200);
+    progress.Add(50);
+    progress.Stop();
+
+    string report = output.str();
+    REQUIRE(report.find("Testing: 50 of 200 images (25%)") == 0);
+    REQUIRE(report.find("images/s") != string::npos);
+    REQUIRE(report.find("s left") != string::npos);
+    REQUIRE(std::count(report.begin(), report.end(), '\n') == 1);
+  }
+
+  SECTION("Test stopping twice prints once") {
+    ProgressReporter progress(output, "Parsing", 0);
+    progress.Add(7);
+    progress.Stop();
+    progress.Stop();
+
+    string report = output.str();
+    REQUIRE(report.find("Parsing: 7 images, ") == 0);
+    REQUIRE(report.find("%") == string::npos);
+    REQUIRE(std::count(report.begin(), report.end(), '\n') == 1);
+  }
+
+  SECTION("Test progress is printed every interval") {
+    {
+      ProgressReporter progress(output, "Training", 0,
+                                std::chrono::milliseconds(5));
+      progress.Add(1);
+      std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    }
+
+    string report = output.str();
+    REQUIRE(std::count(report.begin(), report.end(), '\n') > 2);
+  }
+}
@@ -0,0 +1,66 @@
+#include <catch2/catch.hpp>
+
+#include <core/read_ahead_file.h>
+#include <core/dataset.h>
+
+#include <fstream>
+#include <sstream>
+
+using naivebayes::ReadAheadFile;
+using naivebayes::Dataset;
+using std::ifstream;
+using std::string;
+
+// Need long verbose filepath since Cmake/Cinder can't locate local file path
+const string kReadAheadDatasetPath = "/Users/neilkaushikkar/Cinder/my-projects/"
+    "naive-bayes-nkaush/data/testing_train_dataset_5x5.txt";
+
+TEST_CASE("Test Read Ahead File") {
+  std::ostringstream file_bytes;
+  file_bytes << ifstream(kReadAheadDatasetPath).rdbuf();
+
+  SECTION("Test the stream reads the same bytes as the file") {
+    ReadAheadFile read_ahead_file;
+    REQUIRE(read_ahead_file.Open(kReadAheadDatasetPath));
+    REQUIRE(read_ahead_file.IsOpen());
+
+    std::ostringstream read_bytes;
+    read_bytes << read_ahead_file.GetStream().rdbuf();
+
+    REQUIRE(read_bytes.str() == file_bytes.str());
+    REQUIRE(read_ahead_file.GetReadBytes() == file_bytes.str().size());
+    REQUIRE(read_ahead_file.GetReadSeconds() >= 0);
+  }
+
+  SECTION("Test a dataset can be extracted from the stream") {
+    ReadAheadFile read_ahead_file;
+    REQUIRE(read_ahead_file.Open(kReadAheadDatasetPath));
+    Dataset read_ahead_dataset;
+    read_ahead_file.GetStream() >> read_ahead_dataset;
+
+    ifstream input(kReadAheadDatasetPath);
+    Dataset dataset;
+    input >> dataset;
+
+    REQUIRE(read_ahead_dataset.GetSize() == dataset.GetSize());
+    REQUIRE(read_ahead_dataset.GetDistinctLabels() ==
+            dataset.GetDistinctLabels());
+  }
+
+  SECTION("Test reopening a file before reading all of it") {
+    ReadAheadFile read_ahead_file;
+    REQUIRE(read_ahead_file.Open(kReadAheadDatasetPath));
+    read_ahead_file.GetStream().get();
+
+    REQUIRE(read_ahead_file.Open(kReadAheadDatasetPath));
+    REQUIRE(read_ahead_file.GetStream().get() == file_bytes.str().at(0));
+  }
+
+  SECTION("Test opening a missing file") {
+    ReadAheadFile read_ahead_file;
+
+    REQUIRE_FALSE(read_ahead_file.Open(kReadAheadDatasetPath + ".missing"));
+    REQUIRE_FALSE(read_ahead_file.IsOpen());
+    REQUIRE(read_ahead_file.GetStream().get() == EOF);
+  }
+}
@@ -0,0 +1,75 @@
+#include <catch2/catch.hpp>
+
+#include <visualizer/sketchpad.h>
+
+using naivebayes::visualizer::PixelChange;
+using naivebayes::visualizer::Sketchpad;
+using naivebayes::Shading;
+using std::vector;
+
+TEST_CASE("Test Sketchpad Brush") {
+  // 10 sketchpad pixels per side, each 10 screen pixels wide
+  Sketchpad sketchpad(glm::vec2(0, 0), 10, 100, 1);
+
+  SECTION("Test brush only shades pixels within its radius") {
+    sketchpad.HandleBrush(glm::vec2(55, 55));
+
+    for (size_t row = 0; row < 10; row++) {
+      for (size_t col = 0; col < 10; col++) {
+        bool is_near_brush = (row == 5 && col >= 4 && col <= 6) ||
+                             (col == 5 && row >= 4 && row <= 6);
+        Shading expected = is_near_brush ? Shading::kBlack : Shading::kWhite;
+
+        REQUIRE(sketchpad.GetPixel(row, col) == expected);
+      }
+    }
+  }
+
+  SECTION("Test brush records each newly shaded pixel once") {
+    sketchpad.HandleBrush(glm::vec2(55, 55));
+    sketchpad.HandleBrush(glm::vec2(55, 55));
+
+    const vector<PixelChange>& changes = sketchpad.GetDirtyPixels();
+    REQUIRE(changes.size() == 5);
+    for (const PixelChange& change : changes) {
+      REQUIRE(change.previous_ == Shading::kWhite);
+      REQUIRE(change.current_ == Shading::kBlack);
+    }
+  }
+
+  SECTION("Test brush on the corner stays within the sketchpad") {
+    sketchpad.HandleBrush(glm::vec2(0, 0));
+
+    REQUIRE(sketchpad.GetDirtyPixels().size() == 1);
+    REQUIRE(sketchpad.GetPixel(0, 0) == Shading::kBlack);
+  }
+
+  SECTION("Test brush off of the sketchpad shades nothing") {
+    sketchpad.HandleBrush(glm::vec2(-50, 250));
+
+    REQUIRE(sketchpad.GetDirtyPixels().empty());
+  }
+}
+
+TEST_CASE("Test Sketchpad Clear") {
+  Sketchpad sketchpad(glm::vec2(0, 0), 10, 100, 1);
+  sketchpad.HandleBrush(glm::vec2(55, 55));
+  sketchpad.ClearDirtyPixels();
+
+  sketchpad.Clear();
+
+  SECTION("Test clear unshades every pixel") {
+    for (Shading shading : sketchpad.GetPixels()) {
+      REQUIRE(shading == Shading::kWhite);
+    }
+  }
+
+  SECTION("Test clear records only the pixels that were shaded") {
+    const vector<PixelChange>& changes = sketchpad.GetDirtyPixels();
+    REQUIRE(changes.size() == 5);
+    for (const PixelChange& change : changes) {
+      REQUIRE(change.previous_ == Shading::kBlack);
+      REQUIRE(change.current_ == Shading::kWhite);
+    }
+  }
+}
@@ -0,0 +1,115 @@
+#include <catch2/catch.hpp>
+
+#include <core/thread_pool.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using naivebayes::ThreadPool;
+using std::vector;
+
+TEST_CASE("Test Thread Pool Thread Count") {
+  SECTION("Test a thread count of 0 uses every core") {
+    ThreadPool pool(0);
+
+    REQUIRE(pool.GetThreadCount() == ThreadPool::GetCoreCount());
+  }
+
+  SECTION("Test setting the thread count") {
+    ThreadPool pool(2);
+    REQUIRE(pool.GetThreadCount() == 2);
+
+    pool.SetThreadCount(5);
+    REQUIRE(pool.GetThreadCount() == 5);
+  }
+}
+
+TEST_CASE("Test Parallel For") {
+  for (size_t thread_count : {1, 2, 4}) {
+    ThreadPool pool(thread_count);
+
+    SECTION("Test every index is run exactly once with " +
+            std::to_string(thread_count) + " threads") {
+      for (size_t grain_size : {0, 1, 7, 1000}) {
+        vector<std::atomic<int>> runs(1000);
+        for (std::atomic<int>& run : runs) {
+          run = 0;
+        }
+
+        pool.ParallelFor(0, runs.size(), grain_size,
+                         [&](size_t first, size_t last) {
+          for (size_t index = first; index < last; index++) {
+            runs[index]++;
+          }
+        });
+
+        for (const std::atomic<int>& run : runs) {
+          REQUIRE(run == 1);
+        }
+      }
+    }
+
+    SECTION("Test an empty range runs nothing with " +
+            std::to_string(thread_count) + " threads") {
+      bool is_run = false;
+      pool.ParallelFor(5, 5, 1, [&](size_t, size_t) { is_run = true; });
+
+      REQUIRE_FALSE(is_run);
+    }
+
+    SECTION("Test uneven tasks with " + std::to_string(thread_count) +
+            " threads") {
+      std::atomic<size_t> total(0);
+      pool.ParallelFor(0, 64, 1, [&](size_t first, size_t last) {
+        for (size_t index = first; index < last; index++) {
+          // Later tasks do far more work than earlier ones
+          size_t sum = 0;
+          for (size_t step = 0; step < index * index * 100; step++) {
+            sum += step % 3;
+          }
+          total += sum > 0 ? 1 : 0;
+        }
+      });
+
+      REQUIRE(total == 63);
+    }
+
+    SECTION("Test work started from inside a task with " +
+            std::to_string(thread_count) + " threads") {
+      std::atomic<size_t> total(0);
+      pool.ParallelFor(0, 8, 1, [&](size_t, size_t) {
+        pool.ParallelFor(0, 100, 10, [&](size_t first, size_t last) {
+          total += last - first;
+        });
+      });
+
+      REQUIRE(total == 800);
+    }
+
+    SECTION("Test an exception thrown by a task with " +
+            std::to_string(thread_count) + " threads") {
+      std::atomic<size_t> run_count(0);
+      auto throwing_body = [&](size_t first, size_t) {
+        run_count++;
+        if (first == 3) {
+          throw std::invalid_argument("Task failed.");
+        }
+      };
+
+      REQUIRE_THROWS_AS(pool.ParallelFor(0, 10, 1, throwing_body),
+                        std::invalid_argument);
+      REQUIRE(run_count == 10);
+    }
+  }
+
+  SECTION("Test a range no bigger than a grain runs on the calling thread") {
+    ThreadPool pool(4);
+    std::thread::id body_thread;
+    pool.ParallelFor(0, 10, 10, [&](size_t, size_t) {
+      body_thread = std::this_thread::get_id();
+    });
+
+    REQUIRE(body_thread == std::this_thread::get_id());
+  }
+}
@@ -0,0 +1,76 @@
+#include <catch2/catch.hpp>
+
+#include <core/trace.h>
+
+#include <nlohmann/json.hpp>
+
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using naivebayes::Tracer;
+using naivebayes::TraceSpan;
+
+TEST_CASE("Test Tracing Spans") {
+  Tracer::Clear();
+
+  SECTION("Test nothing is recorded while tracing is disabled") {
+    Tracer::SetEnabled(false);
+    {
+      TraceSpan span("Disabled");
+    }
+
+    REQUIRE(Tracer::GetSpanCount() == 0);
+  }
+
+  SECTION("Test a span is recorded when it ends") {
+    Tracer::SetEnabled(true);
+    {
+      TraceSpan span("Outer");
+      TraceSpan nested_span("Inner");
+    }
+
+    REQUIRE(Tracer::GetSpanCount() == 2);
+  }
+
+  SECTION("Test a span started while disabled is not recorded") {
+    Tracer::SetEnabled(false);
+    {
+      TraceSpan span("Started disabled");
+      Tracer::SetEnabled(true);
+    }
+
+    REQUIRE(Tracer::GetSpanCount() == 0);
+  }
+
+  SECTION("Test writing spans of several threads as trace events") {
+    Tracer::SetEnabled(true);
+    {
+      TraceSpan span("Main");
+    }
+    std::thread worker([]() { TraceSpan span("Worker"); });
+    worker.join();
+
+    std::stringstream trace;
+    Tracer::Write(trace);
+    nlohmann::json trace_json = nlohmann::json::parse(trace.str());
+    const nlohmann::json& events = trace_json.at("traceEvents");
+
+    std::set<std::string> names;
+    std::set<size_t> thread_ids;
+    for (const nlohmann::json& event : events) {
+      names.insert(event.at("name").get<std::string>());
+      thread_ids.insert(event.at("tid").get<size_t>());
+      REQUIRE(event.at("ph") == "X");
+      REQUIRE(event.at("dur").get<double>() >= 0);
+    }
+
+    REQUIRE(events.size() == 2);
+    REQUIRE(names == std::set<std::string>({"Main", "Worker"}));
+    REQUIRE(thread_ids.size() == 2);
+  }
+
+  Tracer::SetEnabled(false);
+  Tracer::Clear();
+}
@@ -0,0 +1,248 @@
+#include <catch2/catch.hpp>
+
+#include <core/model.h>
+#include <core/thread_pool.h>
+
+#include <fstream>
+#include <random>
+#include <sstream>
+
+using naivebayes::TrainingCounts;
+using naivebayes::Dataset;
+using naivebayes::Shading;
+using naivebayes::Model;
+using naivebayes::Image;
+using naivebayes::ThreadPool;
+using std::stringstream;
+using std::ifstream;
+using std::vector;
+using std::string;
+
+TEST_CASE("Test Merging Count Checkpoints") {
+  // Need long verbose filepath since Cmake/Cinder can't locate local file path
+  std::string file_path = "/Users/neilkaushikkar/Cinder/my-projects/"
+      "naive-bayes-nkaush/data/testing_train_dataset_4x4.txt";
+  ifstream input(file_path);
+  Dataset dataset;
+  input >> dataset;
+
+  TrainingCounts full_counts;
+  full_counts.AddDataset(dataset);
+
+  // Split the images between two shards by label
+  TrainingCounts zero_counts;
+  TrainingCounts one_counts;
+  for (const Image& image : dataset.GetImageGroup('0')) {
+    zero_counts.AddImage(image);
+  }
+  for (const Image& image : dataset.GetImageGroup('1')) {
+    one_counts.AddImage(image);
+  }
+
+  SECTION("Test checkpoints survive serialization") {
+    stringstream checkpoint;
+    checkpoint << zero_counts;
+    TrainingCounts loaded_counts;
+    checkpoint >> loaded_counts;
+
+    REQUIRE(loaded_counts.GetImageCount() == 5);
+    REQUIRE(loaded_counts.GetClassCount('0') == 5);
+    REQUIRE(loaded_counts.GetShadingCount('0', Shading::kBlack, 0, 0) == 2);
+    REQUIRE(loaded_counts.GetShadingCount('0', Shading::kWhite, 0, 3) == 4);
+  }
+
+  SECTION("Test merged shards train the same model as all images") {
+    TrainingCounts merged_counts;
+    merged_counts.Merge(one_counts);
+    merged_counts.Merge(zero_counts);
+
+    Model full_model;
+    Model merged_model;
+    full_model.Train(full_counts);
+    merged_model.Train(merged_counts);
+
+    stringstream full_serialized;
+    stringstream merged_serialized;
+    full_serialized << full_model;
+    merged_serialized << merged_model;
+
+    REQUIRE(merged_counts.GetImageCount() == 9);
+    REQUIRE(full_serialized.str() == merged_serialized.str());
+  }
+
+  SECTION("Test merging counts of differently sized images") {
+    vector<vector<Shading>> pixels(2, vector<Shading>(2, Shading::kWhite));
+    TrainingCounts small_counts;
+    small_counts.AddImage(Image(pixels, '0'));
+
+    REQUIRE_THROWS_AS(full_counts.Merge(small_counts), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Test Subtracting Counts") {
+  Shading b = Shading::kBlack;
+  Shading w = Shading::kWhite;
+  Image first_image({{b, w}, {w, b}}, '0');
+  Image second_image({{b, b}, {w, w}}, '0');
+  Image third_image({{w, w}, {b, b}}, '1');
+
+  TrainingCounts total_counts;
+  total_counts.AddImage(first_image);
+  total_counts.AddImage(second_image);
+  total_counts.AddImage(third_image);
+
+  SECTION("Test subtracting a fold leaves the counts of the other images") {
+    TrainingCounts fold_counts;
+    fold_counts.AddImage(second_image);
+    fold_counts.AddImage(third_image);
+    total_counts.Subtract(fold_counts);
+
+    REQUIRE(total_counts.GetImageCount() == 1);
+    REQUIRE(total_counts.GetClassCount('0') == 1);
+    REQUIRE(total_counts.GetShadingCount('0', b, 0, 1) == 0);
+    REQUIRE(total_counts.GetShadingCount('0', b, 1, 1) == 1);
+  }
+
+  SECTION("Test subtracting every image of a class keeps the class") {
+    TrainingCounts fold_counts;
+    fold_counts.AddImage(third_image);
+    total_counts.Subtract(fold_counts);
+
+    REQUIRE(total_counts.GetDistinctLabels() == vector<char>({'0', '1'}));
+    REQUIRE(total_counts.GetClassCount('1') == 0);
+  }
+
+  SECTION("Test subtracting images that were never counted") {
+    TrainingCounts fold_counts;
+    fold_counts.AddImage(third_image);
+    fold_counts.AddImage(third_image);
+
+    REQUIRE_THROWS_AS(total_counts.Subtract(fold_counts),
+                      std::invalid_argument);
+    REQUIRE(total_counts.GetImageCount() == 3);
+  }
+}
+
+TEST_CASE("Test Weighted Counts") {
+  Shading b = Shading::kBlack;
+  Shading w = Shading::kWhite;
+  Image first_image({{b, w}, {w, b}}, '0');
+  Image second_image({{b, b}, {w, w}}, '0');
+  Image third_image({{w, w}, {b, b}}, '1');
+
+  SECTION("Test a weight scales every count of the image") {
+    TrainingCounts counts;
+    counts.AddImage(first_image, 0.5);
+    counts.AddImage(third_image, 2);
+
+    REQUIRE(counts.GetImageCount() == Approx(2.5));
+    REQUIRE(counts.GetClassCount('0') == Approx(0.5));
+    REQUIRE(counts.GetShadingCount('0', b, 0, 0) == Approx(0.5));
+    REQUIRE(counts.GetShadingCount('1', b, 1, 0) == Approx(2));
+  }
+
+  SECTION("Test weighted counts survive serialization") {
+    TrainingCounts counts;
+    counts.AddImage(first_image, 0.25);
+    stringstream checkpoint;
+    checkpoint << counts;
+    TrainingCounts loaded_counts;
+    checkpoint >> loaded_counts;
+
+    REQUIRE(loaded_counts.GetClassCount('0') == Approx(0.25));
+    REQUIRE(loaded_counts.GetShadingCount('0', w, 0, 1) == Approx(0.25));
+  }
+
+  SECTION("Test negative weights") {
+    TrainingCounts counts;
+
+    REQUIRE_THROWS_AS(counts.AddImage(first_image, -1), std::invalid_argument);
+  }
+
+  SECTION("Test subtracting weighted counts") {
+    TrainingCounts total_counts;
+    total_counts.AddImage(first_image, 0.1);
+    total_counts.AddImage(second_image, 0.2);
+    TrainingCounts fold_counts;
+    fold_counts.AddImage(second_image, 0.2);
+    total_counts.Subtract(fold_counts);
+
+    REQUIRE(total_counts.GetClassCount('0') == Approx(0.1));
+    REQUIRE(total_counts.GetShadingCount('0', b, 0, 1) == Approx(0));
+  }
+
+  SECTION("Test balancing gives every class the same weight") {
+    TrainingCounts counts;
+    counts.AddImage(first_image);
+    counts.AddImage(second_image);
+    counts.AddImage(third_image);
+    counts.BalanceClasses();
+
+    REQUIRE(counts.GetImageCount() == Approx(3));
+    REQUIRE(counts.GetClassCount('0') == Approx(1.5));
+    REQUIRE(counts.GetClassCount('1') == Approx(1.5));
+    REQUIRE(counts.GetShadingCount('0', b, 0, 0) == Approx(1.5));
+    REQUIRE(counts.GetShadingCount('0', b, 0, 1) == Approx(0.75));
+    REQUIRE(counts.GetShadingCount('1', b, 1, 1) == Approx(1.5));
+  }
+}
+
+TEST_CASE("Test Counting In Parallel") {
+  ThreadPool& pool = ThreadPool::GetShared();
+  size_t thread_count = pool.GetThreadCount();
+  ThreadPool::Placement placement = pool.GetPlacement();
+  pool.SetThreadCount(4);
+
+  // Enough images for several tasks, with classes of very different sizes
+  std::mt19937 generator(7);
+  std::bernoulli_distribution is_black(0.3);
+  vector<Image> images;
+  Dataset dataset;
+  for (size_t index = 0; index < 1000; index++) {
+    vector<vector<Shading>> pixels(3, vector<Shading>(4, Shading::kWhite));
+    for (vector<Shading>& row : pixels) {
+      for (Shading& pixel : row) {
+        pixel = is_black(generator) ? Shading::kBlack : Shading::kWhite;
+      }
+    }
+
+    images.emplace_back(pixels, index % 10 == 0 ? '1' : '0');
+    dataset.AddImage(images.back());
+  }
+
+  TrainingCounts serial_counts;
+  for (const Image& image : images) {
+    serial_counts.AddImage(image);
+  }
+  stringstream serial_serialized;
+  serial_serialized << serial_counts;
+
+  SECTION("Test a batch counted in parallel equals the serial counts") {
+    TrainingCounts parallel_counts;
+    parallel_counts.AddImages(images, vector<double>(images.size(), 1));
+    stringstream parallel_serialized;
+    parallel_serialized << parallel_counts;
+
+    REQUIRE(parallel_serialized.str() == serial_serialized.str());
+  }
+
+  SECTION("Test a dataset counted in parallel equals the serial counts") {
+    TrainingCounts parallel_counts;
+    parallel_counts.AddDataset(dataset);
+    stringstream parallel_serialized;
+    parallel_serialized << parallel_counts;
+
+    REQUIRE(parallel_serialized.str() == serial_serialized.str());
+  }
+
+  SECTION("Test an image of another size fails the whole batch") {
+    images.emplace_back(vector<vector<Shading>>(2, vector<Shading>(2)), '0');
+    TrainingCounts parallel_counts;
+
+    REQUIRE_THROWS_AS(
+        parallel_counts.AddImages(images, vector<double>(images.size(), 1)),
+        std::invalid_argument);
+  }
+
+  pool.SetThreadCount(thread_count, placement);
+}